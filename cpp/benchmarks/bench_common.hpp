@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <string>
+
+
+// best wall time of `reps` runs of f(), seconds
+template<typename F>
+double bench_time(F&& f, size_t reps = 5) {
+  double best = std::numeric_limits<double>::max();
+  for (size_t r = 0; r < reps; ++r) {
+    const auto t0 = std::chrono::steady_clock::now();
+    f();
+    const auto t1 = std::chrono::steady_clock::now();
+    const double dt = std::chrono::duration<double>(t1 - t0).count();
+    if (dt < best) { best = dt; }
+  }
+  return best;
+}
+
+
+// one line per case: name, time [ms], bandwidth [GB/s] for `bytes` moved
+inline void bench_report(const std::string& name, double sec, double bytes) {
+  std::cout << std::left << std::setw(40) << name << std::right
+            << std::fixed << std::setprecision(3)
+            << std::setw(10) << sec * 1e3 << " ms"
+            << std::setw(10) << bytes / sec * 1e-9 << " GB/s\n";
+}
+
+
+// one line per case: name, time [ms], time per item [ns]
+inline void bench_report_items(const std::string& name, double sec, double nitems) {
+  std::cout << std::left << std::setw(40) << name << std::right
+            << std::fixed << std::setprecision(3)
+            << std::setw(10) << sec * 1e3 << " ms"
+            << std::setw(10) << sec / nitems * 1e9 << " ns/item\n";
+}
+
+
+// one line per case: name, time [ms], arithmetic rate [GFLOP/s]
+inline void bench_report_flops(const std::string& name, double sec, double flops) {
+  std::cout << std::left << std::setw(40) << name << std::right
+            << std::fixed << std::setprecision(3)
+            << std::setw(10) << sec * 1e3 << " ms"
+            << std::setw(10) << flops / sec * 1e-9 << " GFLOP/s\n";
+}
+
+
+// keeps the result alive for the optimizer: `x` escapes and all memory
+// counts as read, so the stores it depends on can't be dropped
+template<typename T>
+void bench_keep(const T& x) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "g"(&x) : "memory");
+#else
+  static volatile char sink;
+  sink = *reinterpret_cast<const volatile char*>(&x);
+#endif
+}
@@ -0,0 +1,273 @@
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "bench_common.hpp"
+
+
+// Element access paths of NArray_/View_, summing int elements:
+//   raw pointers, at(Index), variadic at(), FIterator_, WIterator_, VIterator_
+// for C/F order, contiguous arrays and views with a step of 2 along the most
+// data-local dim, ND = 1..8, about the same number of elements for every ND.
+//
+//   xmat_bench_xarray [--n numel] [--reps r] [--json out.json | --json -]
+//
+// A table goes to stdout; --json writes one record per case.
+namespace {
+
+struct Options {
+  size_t numel = size_t{1} << 22;
+  size_t reps = 5;
+  std::string json;  // "-": stdout instead of the table
+};
+
+struct Record {
+  std::string method, order, layout, shape;
+  size_t ndim = 0, numel = 0;
+  double sec = 0;
+};
+
+std::vector<Record> g_records;
+
+// extents of ND dims with about `numel` elements in total
+template<size_t ND>
+xmat::Index_<size_t, ND> make_shape(size_t numel, xmat::MOrder morder) {
+  const size_t e = std::max<size_t>(2, size_t(std::lround(std::pow(double(numel), 1.0 / ND))));
+  xmat::Index_<size_t, ND> shape;
+  shape.fill(e);
+  size_t inner = 1;
+  for (size_t d = 1; d < ND; ++d) { inner *= e; }
+  shape[morder == xmat::MOrder::C ? 0 : ND - 1] = std::max<size_t>(1, numel / inner);
+  return shape;
+}
+
+template<size_t ND>
+std::string shape_str(const xmat::Index_<size_t, ND>& shape) {
+  std::string s = "[";
+  for (size_t d = 0; d < ND; ++d) { s += (d ? "," : "") + std::to_string(shape[d]); }
+  return s + "]";
+}
+
+// ---- access paths, all return the sum of the elements ----
+
+// nested loops in memory order, innermost stride 1 written out
+template<size_t D, size_t ND>
+struct RawLoop {
+  static void run(const int* p, const size_t* sh, const ptrdiff_t* st, long long& s) {
+    for (size_t i = 0; i < sh[D]; ++i) { RawLoop<D + 1, ND>::run(p + ptrdiff_t(i) * st[D], sh, st, s); }
+  }
+};
+
+template<size_t ND>
+struct RawLoop<ND - 1, ND> {
+  static void run(const int* p, const size_t* sh, const ptrdiff_t* st, long long& s) {
+    const size_t n = sh[ND - 1];
+    if (st[ND - 1] == 1) { for (size_t i = 0; i < n; ++i) { s += p[i]; } }
+    else                 { for (size_t i = 0; i < n; ++i) { s += p[ptrdiff_t(i) * st[ND - 1]]; } }
+  }
+};
+
+template<size_t ND, xmat::MOrder MOrderT>
+using view_t = xmat::View_<int, ND, MOrderT, size_t>;
+
+template<size_t ND, xmat::MOrder MOrderT>
+long long sum_raw(const view_t<ND, MOrderT>& v) {
+  constexpr bool c = MOrderT == xmat::MOrder::C;
+  long long s = 0;
+  if (v.ravel().ndcontig() == ND && v.ravel().leaststride() == 1) {
+    const int* p = v.ptr();
+    for (size_t i = 0, n = v.numel(); i < n; ++i) { s += p[i]; }
+    return s;
+  }
+  size_t sh[ND];
+  ptrdiff_t st[ND];
+  for (size_t d = 0; d < ND; ++d) {
+    sh[d] = v.shape()[c ? d : ND - 1 - d];
+    st[d] = ptrdiff_t(v.stride()[c ? d : ND - 1 - d]);
+  }
+  RawLoop<0, ND>::run(v.ptr(), sh, st, s);
+  return s;
+}
+
+// index odometer in memory order
+template<size_t ND, xmat::MOrder MOrderT, typename F>
+long long sum_index(const view_t<ND, MOrderT>& v, F&& get) {
+  typename view_t<ND, MOrderT>::index_t index;
+  index.fill(0);
+  long long s = 0;
+  if (v.numel() == 0) { return s; }
+  do { s += get(index); } while (xmat::hidx::next_outer<MOrderT>(index.begin(), v.shape().begin(), ND, 0));
+  return s;
+}
+
+template<class V, size_t... I>
+int at_variadic(const V& v, const typename V::index_t& index, std::index_sequence<I...>) {
+  return v.at(index[I]...);
+}
+
+template<class V>
+long long sum_at_index(const V& v) {
+  return sum_index(v, [&](const typename V::index_t& index) { return v.at(index); });
+}
+
+template<class V>
+long long sum_at_variadic(const V& v) {
+  return sum_index(v, [&](const typename V::index_t& index) {
+    return at_variadic(v, index, std::make_index_sequence<V::ndim>());
+  });
+}
+
+template<class V>
+long long sum_fiterator(const V& v) {
+  long long s = 0;
+  for (auto it = v.fbegin(), end = v.fend(); it != end; ++it) { s += *it; }
+  return s;
+}
+
+template<class V>
+long long sum_witerator(const V& v) {
+  long long s = 0;
+  for (auto w = v.wbegin(), wend = v.wend(); w != wend; ++w) {
+    for (auto it = w.begin(), end = w.end(); it != end; ++it) { s += *it; }
+  }
+  return s;
+}
+
+// sub-arrays along the least data-local dim, then FIterator_
+template<class V, std::enable_if_t<(V::ndim > 1), int> = 0>
+long long sum_viterator(V& v) {
+  long long s = 0;
+  for (auto sub = v.begin(), end = v.end(); sub != end; ++sub) { s += sum_fiterator(*sub); }
+  return s;
+}
+
+template<class V, std::enable_if_t<(V::ndim == 1), int> = 0>
+long long sum_viterator(V&) { return -1; }
+
+// ---- cases ----
+
+template<class V>
+void bench_case(const Options& opt, const std::string& order, const std::string& layout, V v, long long expect) {
+  constexpr size_t ND = V::ndim;
+  const std::string shape = shape_str<ND>(v.shape());
+  auto run = [&](const char* method, auto&& f) {
+    long long s = 0;
+    const double sec = bench_time([&]() { s = f(); bench_keep(s); }, opt.reps);
+    if (s != expect) {
+      std::cerr << "sum mismatch: " << method << " " << order << " " << layout << " " << shape << '\n';
+      return;
+    }
+    g_records.push_back({method, order, layout, shape, ND, v.numel(), sec});
+  };
+  run("raw", [&]() { return sum_raw(v); });
+  run("at(Index)", [&]() { return sum_at_index(v); });
+  run("at(...)", [&]() { return sum_at_variadic(v); });
+  run("FIterator_", [&]() { return sum_fiterator(v); });
+  run("WIterator_", [&]() { return sum_witerator(v); });
+  if (ND > 1) { run("VIterator_", [&]() { return sum_viterator(v); }); }
+}
+
+template<size_t ND, xmat::MOrder MOrderT>
+void bench_nd(const Options& opt) {
+  using array_t = xmat::NArray_<int, ND, std::allocator<int>, MOrderT, size_t>;
+  const std::string order = MOrderT == xmat::MOrder::C ? "C" : "F";
+  const auto shape = make_shape<ND>(opt.numel, MOrderT);
+  constexpr size_t lo = xmat::hidx::morderlowi(MOrderT, ND);
+
+  array_t a{shape};
+  for (size_t k = 0; k < a.numel(); ++k) { a.ptr()[k] = int(k % 7); }
+  view_t<ND, MOrderT> va = a.template view<ND>({});
+  bench_case(opt, order, "contiguous", va, sum_raw(va));
+
+  // same shape, every second element of the most data-local dim
+  auto wide = shape;
+  wide[lo] *= 2;
+  array_t b{wide};
+  for (size_t k = 0; k < b.numel(); ++k) { b.ptr()[k] = int(k % 7); }
+  xmat::NSlice<ND> nsl;
+  nsl.fill(xmat::sl_::all());
+  nsl[lo] = xmat::Slice(0, ptrdiff_t(wide[lo]), 2);
+  view_t<ND, MOrderT> vb = b.template view<ND>(nsl);
+  bench_case(opt, order, "sliced", vb, sum_raw(vb));
+}
+
+template<xmat::MOrder MOrderT>
+void bench_orders(const Options& opt) {
+  bench_nd<1, MOrderT>(opt);
+  bench_nd<2, MOrderT>(opt);
+  bench_nd<3, MOrderT>(opt);
+  bench_nd<4, MOrderT>(opt);
+  bench_nd<5, MOrderT>(opt);
+  bench_nd<6, MOrderT>(opt);
+  bench_nd<7, MOrderT>(opt);
+  bench_nd<8, MOrderT>(opt);
+}
+
+double ns_per_element(const Record& r) { return r.sec / double(r.numel) * 1e9; }
+double gb_per_s(const Record& r) { return double(r.numel) * sizeof(int) / r.sec * 1e-9; }
+
+void write_json(std::ostream& os, const Options& opt) {
+  os << "{\n  \"benchmark\": \"xmat_bench_xarray\",\n"
+     << "  \"element\": \"int\",\n  \"numel\": " << opt.numel << ",\n  \"reps\": " << opt.reps << ",\n"
+     << "  \"results\": [\n";
+  for (size_t k = 0; k < g_records.size(); ++k) {
+    const Record& r = g_records[k];
+    os << "    {\"method\": \"" << r.method << "\", \"order\": \"" << r.order
+       << "\", \"layout\": \"" << r.layout << "\", \"ndim\": " << r.ndim
+       << ", \"shape\": " << r.shape << ", \"numel\": " << r.numel
+       << ", \"ns_per_element\": " << ns_per_element(r) << ", \"gb_per_s\": " << gb_per_s(r) << "}"
+       << (k + 1 < g_records.size() ? ",\n" : "\n");
+  }
+  os << "  ]\n}\n";
+}
+
+bool parse(int argc, char** argv, Options& opt) {
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--n") && has_value)         { opt.numel = std::strtoul(argv[++i], nullptr, 10); }
+    else if (!std::strcmp(argv[i], "--reps") && has_value) { opt.reps = std::strtoul(argv[++i], nullptr, 10); }
+    else if (!std::strcmp(argv[i], "--json") && has_value) { opt.json = argv[++i]; }
+    else { return false; }
+  }
+  return opt.numel > 0 && opt.reps > 0;
+}
+} // namespace
+
+
+int main(int argc, char** argv) {
+  Options opt;
+  if (!parse(argc, argv, opt)) {
+    std::cerr << "usage: " << argv[0] << " [--n numel] [--reps r] [--json out.json | --json -]\n";
+    return EXIT_FAILURE;
+  }
+
+  bench_orders<xmat::MOrder::C>(opt);
+  bench_orders<xmat::MOrder::F>(opt);
+
+  if (opt.json != "-") {
+    for (const auto& r : g_records) {
+      std::cout << std::left << std::setw(56) << r.method + " " + r.order + " " + r.layout + " " + r.shape
+                << std::right << std::fixed << std::setprecision(3)
+                << std::setw(10) << ns_per_element(r) << " ns/element"
+                << std::setw(10) << gb_per_s(r) << " GB/s\n";
+    }
+  }
+  if (opt.json == "-") {
+    write_json(std::cout, opt);
+  } else if (!opt.json.empty()) {
+    std::ofstream f{opt.json};
+    write_json(f, opt);
+    if (!f) {
+      std::cerr << "cannot write " << opt.json << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
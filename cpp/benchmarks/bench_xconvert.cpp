@@ -0,0 +1,52 @@
+#include <cstdlib>
+#include <cstdint>
+#include <complex>
+#include <string>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xconvert.hpp"
+#include "bench_common.hpp"
+
+
+// 1M samples: per-element loop vs xmat::astype, IQ widening and
+// saturating narrowing
+namespace {
+
+constexpr size_t k_n = size_t{1} << 20;
+
+template<typename U, typename T, typename F>
+void bench_pair(const std::string& name, F&& naive_op, double scale, double offset) {
+  xmat::NArray<T, 1> x{{k_n}};
+  xmat::NArray<U, 1> y{{k_n}};
+  size_t q = 0;
+  for (auto it = x.fbegin(), end = x.fend(); it != end; ++it) { *it = T(typename xmat::impl_convert::component<T>::type(q++ % 251)); }
+  const double bytes = double(k_n) * (sizeof(T) + sizeof(U));
+
+  bench_report("naive " + name, bench_time([&]() {
+    for (size_t i = 0; i < k_n; ++i) { y.at(i) = naive_op(x.at(i)); }
+    bench_keep(y.ptr()[0]);
+  }), bytes);
+
+  bench_report("astype " + name, bench_time([&]() {
+    xmat::astype(y, x, scale, offset);
+    bench_keep(y.ptr()[0]);
+  }), bytes);
+}
+} // namespace
+
+
+int main() {
+  using ci16 = std::complex<std::int16_t>;
+  using ci8 = std::complex<std::int8_t>;
+  using cf = std::complex<float>;
+  const float s16 = 1.f / 32768;
+
+  bench_pair<cf, ci16>("cint16 -> cfloat", [=](ci16 v) { return cf(v.real() * s16, v.imag() * s16); }, s16, 0);
+  bench_pair<cf, ci8>("cint8 -> cfloat", [](ci8 v) { return cf(v.real() / 128.f, v.imag() / 128.f); }, 1.0 / 128, 0);
+  bench_pair<std::int16_t, float>("float -> int16 (saturating)", [](float v) {
+    return std::int16_t(std::max(-32768.f, std::min(32767.f, std::nearbyint(v * 100.f))));
+  }, 100, 0);
+  bench_pair<float, std::uint8_t>("uint8 -> float", [](std::uint8_t v) { return v * 0.5f - 1.f; }, 0.5, -1);
+  bench_pair<double, float>("float -> double", [](float v) { return double(v); }, 1, 0);
+  return EXIT_SUCCESS;
+}
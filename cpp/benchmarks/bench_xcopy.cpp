@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <complex>
+#include <string>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xcopy.hpp"
+#include "bench_common.hpp"
+
+
+namespace {
+
+using cfloat = std::complex<float>;
+
+// F -> C conversion of complex<float> matrices:
+// naive FIterator_ walk vs tiled copy_to
+void bench_convert(size_t m, size_t n) {
+  xmat::NArrayxF<cfloat, 2> src{{m, n}};
+  xmat::NArray<cfloat, 2> dst{{m, n}};
+  for (size_t k = 0; k < src.numel(); ++k) { src.ptr()[k] = {float(k), -float(k)}; }
+
+  const double bytes = 2.0 * sizeof(cfloat) * src.numel();
+  const std::string shape = "[" + std::to_string(m) + "x" + std::to_string(n) + "]";
+
+  // destination walked in C order, strided gather from the source
+  bench_report("naive FIterator_ F->C " + shape, bench_time([&]() {
+    for (auto d = dst.fbegin(), end = dst.fend(); d != end; ++d) { *d = src.at(d.index()); }
+  }), bytes);
+  bench_keep(dst);
+
+  bench_report("copy_to F->C " + shape, bench_time([&]() {
+    xmat::copy_to(dst, src);
+  }), bytes);
+  bench_keep(dst);
+
+  xmat::NArray<cfloat, 2> dstt{{n, m}};
+  bench_report("copy_to transpose C->C " + shape, bench_time([&]() {
+    xmat::copy_to(dstt, dst.permute({1, 0}));
+  }), bytes);
+  bench_keep(dstt);
+}
+
+
+// strided views and broadcast: naive FIterator_ walk vs assign
+void bench_assign(size_t n) {
+  using xmat::Slice;
+  using xmat::sl;
+  xmat::NArray<float, 3> src{{8, n, n}}, dst{{8, n, n}};
+  for (size_t k = 0; k < src.numel(); ++k) { src.ptr()[k] = float(k); }
+
+  const std::string shape = "[8x" + std::to_string(n) + "x" + std::to_string(n) + "]";
+  const xmat::NSlice<3> s{Slice(0, 8, 2), Slice(1, n), sl::all};
+  auto sv = src.view<3>(s);
+  auto dv = dst.view<3>(s);
+  const double bytes = 2.0 * sizeof(float) * sv.numel();
+
+  bench_report("naive FIterator_ view " + shape, bench_time([&]() {
+    for (auto d = dv.fbegin(), end = dv.fend(); d != end; ++d) { *d = sv.at(d.index()); }
+  }), bytes);
+  bench_keep(dst);
+
+  bench_report("assign view " + shape, bench_time([&]() {
+    xmat::assign(dv, sv);
+  }), bytes);
+  bench_keep(dst);
+
+  // one row broadcast over the two outer dims
+  auto row = src.view<3>({Slice(0, 1), Slice(0, 1), sl::all});
+  bench_report("naive FIterator_ broadcast " + shape, bench_time([&]() {
+    for (auto d = dst.fbegin(), end = dst.fend(); d != end; ++d) { *d = row.at(0, 0, d.index()[2]); }
+  }), sizeof(float) * dst.numel());
+  bench_keep(dst);
+
+  bench_report("assign broadcast " + shape, bench_time([&]() {
+    xmat::assign(dst, row);
+  }), sizeof(float) * dst.numel());
+  bench_keep(dst);
+}
+} // namespace
+
+
+int main(int argc, char** argv) {
+  const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4096;
+  bench_convert(n, n);
+  bench_convert(n, n / 2 + 3);
+  bench_assign(n / 4);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+#include <cstdlib>
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xfft.hpp"
+#include "bench_common.hpp"
+
+
+// batch of 64 transforms: naive DFT vs xmat::fft along the contiguous axis,
+// along the strided axis, real input and threaded. 5*n*log2(n) flops per transform
+namespace {
+
+constexpr size_t k_batch = 64;
+
+template<typename R>
+void naive(xmat::NArray<std::complex<R>, 2>& y, const xmat::NArray<std::complex<R>, 2>& x,
+           const std::vector<std::complex<R>>& tw) {
+  const size_t b = x.shape()[0], n = x.shape()[1];
+  for (size_t i = 0; i < b; ++i) {
+    for (size_t k = 0; k < n; ++k) {
+      std::complex<R> s{0};
+      for (size_t j = 0, q = 0; j < n; ++j, q = (q + k) % n) { s += x.at(i, j) * tw[q]; }
+      y.at(i, k) = s;
+    }
+  }
+}
+
+template<typename R>
+void bench_fft(const std::string& type, size_t n) {
+  using C = std::complex<R>;
+  const std::string shape = type + " " + std::to_string(k_batch) + "x" + std::to_string(n);
+  xmat::NArray<C, 2> x{{k_batch, n}}, y{{k_batch, n}};
+  xmat::NArray<C, 2> xt{{n, k_batch}}, yt{{n, k_batch}};
+  xmat::NArray<R, 2> r{{k_batch, n}};
+  xmat::NArray<C, 2> rf{{k_batch, n / 2 + 1}};
+  size_t q = 0;
+  for (auto it = x.fbegin(), end = x.fend(); it != end; ++it, ++q) { *it = C(R(q % 7) - 3, R(q % 5)); }
+  for (auto it = r.fbegin(), end = r.fend(); it != end; ++it) { *it = R(q++ % 7) - 3; }
+  const double flops = 5.0 * k_batch * n * std::log2(double(n));
+
+  if (n <= 1024) {
+    std::vector<C> tw(n);
+    for (size_t k = 0; k < n; ++k) { tw[k] = std::polar(R{1}, R(-2 * std::acos(-1.0) * k / n)); }
+    bench_report_flops("naive dft " + shape, bench_time([&]() {
+      naive(y, x, tw);
+      bench_keep(y.ptr()[0]);
+    }, 1), flops);
+  }
+
+  bench_report_flops("xmat::fft<1> " + shape, bench_time([&]() {
+    xmat::fft<1>(y, x);
+    bench_keep(y.ptr()[0]);
+  }), flops);
+
+  bench_report_flops("xmat::fft<0> lanes contiguous " + shape, bench_time([&]() {
+    xmat::fft<0>(yt, xt);
+    bench_keep(yt.ptr()[0]);
+  }), flops);
+
+  bench_report_flops("xmat::rfft<1> " + shape, bench_time([&]() {
+    xmat::rfft<1>(rf, r);
+    bench_keep(rf.ptr()[0]);
+  }), flops / 2);
+
+  bench_report_flops("xmat::par::fft<1> " + shape, bench_time([&]() {
+    xmat::par::fft<1>(y, x);
+    bench_keep(y.ptr()[0]);
+  }), flops);
+}
+} // namespace
+
+
+int main() {
+  // powers of two, smooth mixed radix, radix-7/11 and Bluestein primes
+  for (size_t n : {256, 1024, 4096, 1000, 3000, 4095, 1001, 1009, 4099}) {
+    bench_fft<float>("cfloat", n);
+    bench_fft<double>("cdouble", n);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,91 @@
+#include <cstdlib>
+#include <complex>
+#include <string>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xfir.hpp"
+#include "bench_common.hpp"
+
+
+// 8 channels x 8192 samples per block: naive per-sample loop vs direct
+// and overlap-save xmat::FirFilter over tap counts, polyphase rate change
+namespace {
+
+constexpr size_t k_channels = 8;
+constexpr size_t k_block = 8192;
+
+template<typename T, typename H>
+void naive(xmat::NArray<T, 2>& y, const xmat::NArray<T, 2>& x, const std::vector<H>& h) {
+  for (size_t c = 0; c < k_channels; ++c) {
+    for (size_t n = 0; n < k_block; ++n) {
+      T s{0};
+      for (size_t k = 0; k < h.size() && k <= n; ++k) { s += h[k] * x.at(c, n - k); }
+      y.at(c, n) = s;
+    }
+  }
+}
+
+template<typename T, typename H>
+void bench_fir(const std::string& type, size_t ntaps) {
+  const std::string shape = type + " taps=" + std::to_string(ntaps);
+  xmat::NArray<T, 2> x{{k_channels, k_block}}, y{{k_channels, k_block}};
+  size_t q = 0;
+  for (auto it = x.fbegin(), end = x.fend(); it != end; ++it) { *it = T(float(q++ % 7) - 3); }
+  std::vector<H> h(ntaps, H(0.5));
+  const double nsamples = double(k_channels) * k_block;
+
+  if (ntaps <= 64) {
+    bench_report_items("naive " + shape, bench_time([&]() {
+      naive(y, x, h);
+      bench_keep(y.ptr()[0]);
+    }, 3), nsamples);
+  }
+
+  xmat::FirFilter<T, H> direct{h, xmat::FirMethod::direct};
+  bench_report_items("FirFilter direct " + shape, bench_time([&]() {
+    direct.template apply<1>(y, x);
+    bench_keep(y.ptr()[0]);
+  }), nsamples);
+
+  xmat::FirFilter<T, H> fft{h, xmat::FirMethod::fft};
+  bench_report_items("FirFilter fft " + shape, bench_time([&]() {
+    fft.template apply<1>(y, x);
+    bench_keep(y.ptr()[0]);
+  }), nsamples);
+}
+
+template<typename T, typename H>
+void bench_polyphase(const std::string& type, size_t ntaps, size_t factor) {
+  const std::string shape = type + " taps=" + std::to_string(ntaps) + " x" + std::to_string(factor);
+  xmat::NArray<T, 2> x{{k_channels, k_block}};
+  xmat::NArray<T, 2> yd{{k_channels, k_block / factor}}, yu{{k_channels, k_block * factor}};
+  for (auto it = x.fbegin(), end = x.fend(); it != end; ++it) { *it = T(1); }
+  std::vector<H> h(ntaps, H(0.5));
+  const double nsamples = double(k_channels) * k_block;
+
+  xmat::FirFilter<T, H> dec{h, xmat::Rate{1, factor}};
+  bench_report_items("FirFilter decimate " + shape, bench_time([&]() {
+    dec.template apply<1>(yd, x);
+    bench_keep(yd.ptr()[0]);
+  }), nsamples);
+
+  xmat::FirFilter<T, H> itp{h, xmat::Rate{factor, 1}};
+  bench_report_items("FirFilter interpolate " + shape, bench_time([&]() {
+    itp.template apply<1>(yu, x);
+    bench_keep(yu.ptr()[0]);
+  }), nsamples);
+}
+} // namespace
+
+
+int main() {
+  for (size_t ntaps : {8, 32, 64, 128, 512}) {
+    bench_fir<float, float>("float", ntaps);
+    bench_fir<std::complex<float>, float>("cfloat", ntaps);
+    bench_fir<std::complex<float>, std::complex<float>>("cfloat*cfloat", ntaps);
+  }
+  bench_polyphase<float, float>("float", 64, 4);
+  bench_polyphase<std::complex<float>, float>("cfloat", 64, 4);
+  return EXIT_SUCCESS;
+}
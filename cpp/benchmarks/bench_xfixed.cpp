@@ -0,0 +1,82 @@
+#include <cstdlib>
+#include <complex>
+#include <string>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "bench_common.hpp"
+
+
+// per-sample NxN complex matrix product: NArrayFixed vs NArray_<T, 2>,
+// heap-allocated per sample, reused, or in a small inline buffer
+namespace {
+
+using cfloat = std::complex<float>;
+
+template<class A, class B, class C>
+void matmul(C& c, const A& a, const B& b, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n; ++j) {
+      cfloat s = 0;
+      for (size_t k = 0; k < n; ++k) { s += a.at(i, k) * b.at(k, j); }
+      c.at(i, j) = s;
+    }
+  }
+}
+
+template<size_t N>
+void bench_matmul(size_t nsamples) {
+  const std::string shape = std::to_string(N) + "x" + std::to_string(N);
+
+  std::vector<xmat::NArrayFixed<cfloat, N, N>> xs(nsamples);
+  for (size_t k = 0; k < nsamples; ++k) {
+    for (size_t i = 0; i < N*N; ++i) { xs[k].ptr()[i] = {float(k + i), 1.0f}; }
+  }
+  xmat::NArrayFixed<cfloat, N, N> h, y;
+  for (size_t i = 0; i < N*N; ++i) { h.ptr()[i] = {0.5f, float(i)}; }
+
+  xmat::NArray<cfloat, 2> hd{{N, N}}, xd{{N, N}}, yd{{N, N}};
+  std::copy_n(h.ptr(), N*N, hd.ptr());
+
+  bench_report_items("NArray_ " + shape + " (allocated)", bench_time([&]() {
+    for (const auto& x : xs) {
+      xmat::NArray<cfloat, 2> xa{{N, N}}, ya{{N, N}};
+      std::copy_n(x.ptr(), N*N, xa.ptr());
+      matmul(ya, hd, xa, N);
+      bench_keep(ya.ptr()[0]);
+    }
+  }), nsamples);
+
+  bench_report_items("NArraySmall " + shape + " (inline)", bench_time([&]() {
+    for (const auto& x : xs) {
+      xmat::NArraySmall<cfloat, 2, N*N> xa{{N, N}}, ya{{N, N}};
+      std::copy_n(x.ptr(), N*N, xa.ptr());
+      matmul(ya, hd, xa, N);
+      bench_keep(ya.ptr()[0]);
+    }
+  }), nsamples);
+
+  bench_report_items("NArray_ " + shape + " (reused)", bench_time([&]() {
+    for (const auto& x : xs) {
+      std::copy_n(x.ptr(), N*N, xd.ptr());
+      matmul(yd, hd, xd, N);
+      bench_keep(yd.ptr()[0]);
+    }
+  }), nsamples);
+
+  bench_report_items("NArrayFixed " + shape, bench_time([&]() {
+    for (const auto& x : xs) {
+      matmul(y, h, x, N);
+      bench_keep(y.ptr()[0]);
+    }
+  }), nsamples);
+}
+} // namespace
+
+
+int main(int argc, char** argv) {
+  const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 20;
+  bench_matmul<2>(n);
+  bench_matmul<4>(n / 4);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include <string>
+
+#include "../include/xmat/xarray.hpp"
+#include "bench_common.hpp"
+
+
+// flat traversal (sum) of arrays and strided views: raw pointer loops vs
+// FIterator_ (per element and as counted innermost runs) vs Increment_
+namespace {
+
+template<class V>
+long long sum_fiterator(const V& v) {
+  long long s = 0;
+  for (auto it = v.fbegin(), end = v.fend(); it != end; ++it) { s += *it; }
+  return s;
+}
+
+template<class V>
+long long sum_fiterator_runs(const V& v) {
+  long long s = 0;
+  for (auto it = v.fbegin(), end = v.fend(); it != end; it.skip_run()) {
+    const int* p = &*it;
+    const auto step = it.step();
+    for (size_t i = 0, n = it.run(); i < n; ++i) { s += p[i * step]; }
+  }
+  return s;
+}
+
+// ptr += Increment_::nextd()
+template<class V>
+long long sum_increment(const V& v) {
+  typename V::increment_t inc{v.shape(), v.stride()};
+  const int* p = v.ptr();
+  long long s = 0;
+  for (size_t n = 0, N = v.numel(); n < N; ++n, p += inc.nextd()) { s += *p; }
+  return s;
+}
+
+template<class V>
+long long sum_raw(const V& v) {
+  const auto& sh = v.shape();
+  const auto& st = v.stride();
+  long long s = 0;
+  for (size_t i = 0; i < sh[0]; ++i) {
+    for (size_t j = 0; j < sh[1]; ++j) {
+      const int* p = v.ptr() + i*st[0] + j*st[1];
+      for (size_t k = 0; k < sh[2]; ++k) { s += p[k*st[2]]; }
+    }
+  }
+  return s;
+}
+
+template<class V>
+void bench_sum(const std::string& name, const V& v) {
+  long long s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  const double n = static_cast<double>(v.numel());
+  bench_report_items("raw pointers " + name, bench_time([&]() { s0 = sum_raw(v); }), n);
+  bench_report_items("FIterator_ " + name, bench_time([&]() { s1 = sum_fiterator(v); }), n);
+  bench_report_items("FIterator_ runs " + name, bench_time([&]() { s3 = sum_fiterator_runs(v); }), n);
+  bench_report_items("Increment_::nextd " + name, bench_time([&]() { s2 = sum_increment(v); }), n);
+  if (s0 != s1 || s0 != s2 || s0 != s3) {
+    std::cout << "sum mismatch: " << s0 << " " << s1 << " " << s2 << " " << s3 << '\n';
+  }
+}
+} // namespace
+
+
+int main(int argc, char** argv) {
+  using xmat::Slice;
+  using xmat::sl;
+  const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 256;
+
+  xmat::NArray<int, 3> a{{n, n, n}};
+  for (size_t k = 0; k < a.numel(); ++k) { a.ptr()[k] = int(k % 7); }
+  bench_sum("[contiguous]", a);
+
+  const auto v = a.view<3>({Slice(0, n, 2), Slice(1, n), Slice(0, n, 2)});
+  bench_sum("[strided view]", v);
+
+  const auto w = a.view<3>({sl::all, sl::all, Slice(0, 3)});
+  bench_sum("[short rows]", w);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include <cstdlib>
+#include <complex>
+#include <string>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xlinalg.hpp"
+#include "bench_common.hpp"
+
+
+// C = A*B: naive i-k-j loop vs blocked xmat::matmul, C-order and transposed A
+namespace {
+
+template<typename T>
+void naive(xmat::NArray<T, 2>& c, const xmat::NArray<T, 2>& a, const xmat::NArray<T, 2>& b) {
+  const size_t m = c.shape()[0], n = c.shape()[1], k = a.shape()[1];
+  for (size_t i = 0; i < m; ++i) {
+    T* ci = &c.at(i, 0);
+    for (size_t j = 0; j < n; ++j) { ci[j] = T{0}; }
+    for (size_t q = 0; q < k; ++q) {
+      const T aiq = a.at(i, q);
+      const T* bq = &b.at(q, 0);
+      for (size_t j = 0; j < n; ++j) { ci[j] += aiq * bq[j]; }
+    }
+  }
+}
+
+template<typename T>
+void bench_matmul(const std::string& type, size_t n, double flops_per_madd) {
+  const std::string shape = type + " " + std::to_string(n) + "x" + std::to_string(n);
+  xmat::NArray<T, 2> a{{n, n}}, at{{n, n}}, b{{n, n}}, c{{n, n}};
+  size_t q = 0;
+  for (auto it = a.fbegin(), end = a.fend(); it != end; ++it) { *it = T(float(q++ % 7) - 3); }
+  for (auto it = b.fbegin(), end = b.fend(); it != end; ++it) { *it = T(float(q++ % 5) - 2); }
+  at = a;
+  const double flops = flops_per_madd * n * n * n;
+
+  bench_report_flops("naive i-k-j " + shape, bench_time([&]() {
+    naive(c, a, b);
+    bench_keep(c.ptr()[0]);
+  }, 3), flops);
+
+  bench_report_flops("xmat::matmul " + shape, bench_time([&]() {
+    xmat::matmul(c, a, b);
+    bench_keep(c.ptr()[0]);
+  }, 3), flops);
+
+  bench_report_flops("xmat::matmul A^T " + shape, bench_time([&]() {
+    xmat::matmul(c, at.permute({1, 0}), b);
+    bench_keep(c.ptr()[0]);
+  }, 3), flops);
+}
+
+template<typename T>
+void bench_gemv(const std::string& type, size_t n) {
+  const std::string shape = type + " " + std::to_string(n) + "x" + std::to_string(n);
+  xmat::NArray<T, 2> a{{n, n}};
+  xmat::NArray<T, 1> x{{n}}, y{{n}};
+  for (auto it = a.fbegin(), end = a.fend(); it != end; ++it) { *it = T(1); }
+  for (auto it = x.fbegin(), end = x.fend(); it != end; ++it) { *it = T(1); }
+
+  bench_report("xmat::gemv " + shape, bench_time([&]() {
+    xmat::gemv(y, a, x);
+    bench_keep(y.ptr()[0]);
+  }), double(n) * n * sizeof(T));
+
+  bench_report("xmat::gemv A^T " + shape, bench_time([&]() {
+    xmat::gemv(y, a.permute({1, 0}), x);
+    bench_keep(y.ptr()[0]);
+  }), double(n) * n * sizeof(T));
+}
+} // namespace
+
+
+int main() {
+  for (size_t n : {64, 256, 512}) {
+    bench_matmul<float>("float", n, 2);
+    bench_matmul<double>("double", n, 2);
+    bench_matmul<std::complex<float>>("cfloat", n, 8);
+    bench_matmul<std::complex<double>>("cdouble", n, 8);
+  }
+  bench_gemv<float>("float", 2048);
+  bench_gemv<std::complex<float>>("cfloat", 1024);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+#include <complex>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xmemory.hpp"
+#include "../include/xmat/xdatastream.hpp"
+#include "bench_common.hpp"
+
+
+// allocations from 1..8 threads at once: std::allocator vs the lock-free
+// global arena (MemorySourceGlobalMT); float blocks of 16..1024 elements.
+// recv -> decode -> reply frames of recurring shapes: std::allocator vs the
+// size-class pool (MemorySourcePool).
+namespace {
+
+constexpr size_t k_allocs = 1 << 16;  // per thread
+constexpr size_t k_batch = 64;
+
+size_t block_size(size_t k) { return 16 + (k * 7919) % 1009; }
+
+// allocate + free at once (temporaries)
+template<class Alloc>
+void run_lifo(Alloc alc) {
+  for (size_t k = 0; k < k_allocs; ++k) {
+    const size_t n = block_size(k);
+    float* p = alc.allocate(n);
+    p[0] = float(k);
+    bench_keep(p[0]);
+    alc.deallocate(p, n);
+  }
+}
+
+// batches of blocks, freed together in reverse order (arrays of a scope)
+template<class Alloc>
+void run_batch(Alloc alc) {
+  float* ps[k_batch];
+  for (size_t k = 0; k < k_allocs; k += k_batch) {
+    for (size_t j = 0; j < k_batch; ++j) {
+      ps[j] = alc.allocate(block_size(k + j));
+      ps[j][0] = float(j);
+    }
+    bench_keep(ps[k_batch - 1][0]);
+    for (size_t j = k_batch; j-- > 0;) { alc.deallocate(ps[j], block_size(k + j)); }
+  }
+}
+
+// NArray_ of a frame, filled and dropped
+template<class Array>
+void run_narray() {
+  for (size_t k = 0; k < k_allocs / 4; ++k) {
+    Array a{{4, block_size(k) / 4}};
+    a.ptr()[0] = float(k);
+    bench_keep(a.ptr()[0]);
+  }
+}
+
+// one message per frame, shapes repeat: [64, 1024], [32, 512], [64, 256] complex<float>
+constexpr size_t k_frames = 1 << 11;  // per thread
+constexpr size_t k_shapes[3][2] = {{64, 1024}, {32, 512}, {64, 256}};
+
+using cf_t = std::complex<float>;
+
+template<class IBuf, class OBuf, class Array, class Sums>
+void run_frames(const std::vector<cf_t>& wire) {
+  for (size_t k = 0; k < k_frames; ++k) {
+    const size_t rows = k_shapes[k % 3][0], cols = k_shapes[k % 3][1];
+    const size_t bytes = rows * cols * sizeof(cf_t);
+
+    IBuf ibuf;  // recv
+    std::memcpy(ibuf.push_reserve(std::streamsize(bytes)), wire.data(), bytes);
+
+    Array a{{rows, cols}};  // decode
+    ibuf.read(reinterpret_cast<char*>(a.ptr()), std::streamsize(bytes));
+
+    Sums sums{{rows}};  // reply
+    for (size_t r = 0; r < rows; ++r) { sums.ptr()[r] = a.ptr()[r * cols]; }
+    OBuf obuf;
+    obuf.write(reinterpret_cast<const char*>(sums.ptr()), std::streamsize(rows * sizeof(cf_t)));
+    bench_keep(obuf.size());
+  }
+}
+
+template<typename F>
+void threads(size_t nthreads, F f) {
+  std::vector<std::thread> th;
+  for (size_t t = 0; t < nthreads; ++t) { th.emplace_back(f); }
+  for (auto& x : th) { x.join(); }
+}
+
+// arena big enough for every block of every thread
+void reset_arena(size_t nthreads) {
+  xmat::MemorySourceGlobalMT::reset(nthreads * k_allocs * (1024 + 16) * sizeof(float));
+}
+
+void bench(size_t nthreads) {
+  const std::string tag = " x" + std::to_string(nthreads);
+  const double n = double(nthreads * k_allocs);
+  using ms_t = xmat::AllocatorMSGlobalMT<float>;
+  reset_arena(nthreads);
+
+  bench_report_items("std::allocator alloc/free" + tag, bench_time([&]() {
+    threads(nthreads, []() { run_lifo(std::allocator<float>{}); });
+  }), n);
+  bench_report_items("GlobalMT alloc/free" + tag, bench_time([&]() {
+    xmat::MemorySourceGlobalMT::reset();
+    threads(nthreads, []() { run_lifo(ms_t{}); });
+  }), n);
+
+  bench_report_items("std::allocator batch" + tag, bench_time([&]() {
+    threads(nthreads, []() { run_batch(std::allocator<float>{}); });
+  }), n);
+  bench_report_items("GlobalMT batch" + tag, bench_time([&]() {
+    xmat::MemorySourceGlobalMT::reset();
+    threads(nthreads, []() { run_batch(ms_t{}); });
+  }), n);
+
+  bench_report_items("NArray" + tag, bench_time([&]() {
+    threads(nthreads, []() { run_narray<xmat::NArray<float, 2>>(); });
+  }), n / 4);
+  bench_report_items("NArrayGMT" + tag, bench_time([&]() {
+    xmat::MemorySourceGlobalMT::reset();
+    threads(nthreads, []() { run_narray<xmat::NArrayGMT<float, 2>>(); });
+  }), n / 4);
+}
+void bench_frames(size_t nthreads) {
+  const std::string tag = " x" + std::to_string(nthreads);
+  const double n = double(nthreads * k_frames);
+  const std::vector<cf_t> wire(k_shapes[0][0] * k_shapes[0][1], cf_t{1.f, -1.f});
+
+  bench_report_items("std::allocator frames" + tag, bench_time([&]() {
+    threads(nthreads, [&]() {
+      run_frames<xmat::IBBuf, xmat::OBBuf, xmat::NArray<cf_t, 2>, xmat::NArray<cf_t, 1>>(wire);
+    });
+  }), n);
+
+  bench_report_items("Pool frames" + tag, bench_time([&]() {
+    threads(nthreads, [&]() {
+      run_frames<xmat::IBBufPMS, xmat::OBBufPMS, xmat::NArrayPMS<cf_t, 2, 64>, xmat::NArrayPMS<cf_t, 1>>(wire);
+    });
+  }), n);
+}
+} // namespace
+
+
+int main() {
+  for (size_t nthreads : {1, 2, 4, 8}) { bench(nthreads); }
+  for (size_t nthreads : {1, 2, 4, 8}) { bench_frames(nthreads); }
+
+  // the frames ran on worker threads: their blocks are on the shared lists now,
+  // the main thread finds them there
+  xmat::MemorySourcePool pool;
+  xmat::MemorySourcePool::reset_stats();
+  for (size_t k = 0; k < 6; ++k) { pool.deallocate(pool.allocate(k_shapes[k % 3][0] * k_shapes[k % 3][1] * sizeof(cf_t)), 0); }
+  const auto st = xmat::MemorySourcePool::stats();
+  std::cout << "Pool main thread: hits " << st.hits << ", shared " << st.shared
+            << ", misses " << st.misses << ", direct " << st.direct << '\n';
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,56 @@
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xmmap.hpp"
+#include "bench_common.hpp"
+
+
+// first write to a fresh 64 MB buffer: page faults of new char[] and lazy
+// mappings vs MappedBuffer pre-faulted at construction (normal and huge pages)
+namespace {
+
+constexpr size_t k_n = size_t{1} << 26;
+constexpr size_t k_reps = 3;
+
+template<typename Make>
+void bench_case(const std::string& name, Make make) {
+  double t_make = 1e30, t_touch = 1e30;
+  for (size_t r = 0; r < k_reps; ++r) {
+    char* data = nullptr;
+    decltype(make(&data)) keep;
+    t_make = std::min(t_make, bench_time([&]() { keep = make(&data); }, 1));
+    t_touch = std::min(t_touch, bench_time([&]() {
+      std::memset(data, 1, k_n);
+      bench_keep(data[k_n - 1]);
+    }, 1));
+  }
+  bench_report(name + " make", t_make, double(k_n));
+  bench_report(name + " first write", t_touch, double(k_n));
+}
+
+std::unique_ptr<xmat::MappedBuffer> mapped(char** data, xmat::HugePages huge, bool populate) {
+  xmat::MapOptions opt;
+  opt.huge = huge;
+  opt.populate = populate;
+  auto mb = std::make_unique<xmat::MappedBuffer>(k_n, opt);
+  *data = mb->data();
+  return mb;
+}
+} // namespace
+
+
+int main() {
+  bench_case("new char[]", [](char** data) {
+    std::unique_ptr<char[]> p{new char[k_n]};
+    *data = p.get();
+    return p;
+  });
+  bench_case("mmap lazy", [](char** data) { return mapped(data, xmat::HugePages::none, false); });
+  bench_case("mmap populate", [](char** data) { return mapped(data, xmat::HugePages::none, true); });
+  bench_case("mmap THP populate", [](char** data) { return mapped(data, xmat::HugePages::transparent, true); });
+  bench_case("mmap HUGETLB populate", [](char** data) { return mapped(data, xmat::HugePages::explicit_, true); });
+  return EXIT_SUCCESS;
+}
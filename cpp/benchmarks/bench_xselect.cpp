@@ -0,0 +1,87 @@
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xselect.hpp"
+#include "bench_common.hpp"
+
+
+// [64, 16384] float: element loops vs xmat::take/compress; channels are
+// rows (copied whole), samples are gathered
+namespace {
+
+constexpr size_t k_rows = 64;
+constexpr size_t k_cols = 16384;
+
+void bench_take() {
+  xmat::NArray<float, 2> x{{k_rows, k_cols}};
+  x.enumerate();
+
+  std::vector<size_t> rows;
+  for (size_t i = 0; i < k_rows; i += 3) { rows.push_back(i); }
+  xmat::NArray<float, 2> yr{{rows.size(), k_cols}};
+  const double br = double(yr.numel()) * sizeof(float) * 2;
+  bench_report("naive take rows", bench_time([&]() {
+    for (size_t k = 0; k < rows.size(); ++k) {
+      for (size_t j = 0; j < k_cols; ++j) { yr.at(k, j) = x.at(rows[k], j); }
+    }
+    bench_keep(yr.ptr()[0]);
+  }), br);
+  bench_report("take<0> rows", bench_time([&]() {
+    xmat::take<0>(yr, x, rows);
+    bench_keep(yr.ptr()[0]);
+  }), br);
+
+  std::vector<size_t> cols;
+  for (size_t j = 0; j < k_cols; j += 2) { cols.push_back((j * 7919) % k_cols); }
+  xmat::NArray<float, 2> yc{{k_rows, cols.size()}};
+  const double bc = double(yc.numel()) * sizeof(float) * 2;
+  bench_report("naive take samples", bench_time([&]() {
+    for (size_t i = 0; i < k_rows; ++i) {
+      for (size_t k = 0; k < cols.size(); ++k) { yc.at(i, k) = x.at(i, cols[k]); }
+    }
+    bench_keep(yc.ptr()[0]);
+  }), bc);
+  bench_report("take<1> samples", bench_time([&]() {
+    xmat::take<1>(yc, x, cols);
+    bench_keep(yc.ptr()[0]);
+  }), bc);
+}
+
+// gated bursts: runs of 64 true/false, then a random region
+void bench_compress() {
+  xmat::NArray<float, 2> x{{k_rows, k_cols}};
+  x.enumerate();
+  xmat::NArray<bool, 2> m{{k_rows, k_cols}};
+  size_t q = 0, r = 12345;
+  for (auto it = m.fbegin(), end = m.fend(); it != end; ++it, ++q) {
+    r = r * 1103515245 + 12345;
+    *it = q % 8192 < 6144 ? (q / 64) % 2 == 0 : ((r >> 16) & 1) != 0;
+  }
+  const size_t n = xmat::count_nonzero(m);
+  xmat::NArray<float, 1> v{{n}};
+  const double bytes = double(x.numel()) * (sizeof(float) + 1);
+
+  bench_report("naive compress", bench_time([&]() {
+    size_t j = 0;
+    for (size_t i = 0; i < k_rows; ++i) {
+      for (size_t k = 0; k < k_cols; ++k) {
+        if (m.at(i, k)) { v.at(j++) = x.at(i, k); }
+      }
+    }
+    bench_keep(v.ptr()[0]);
+  }), bytes);
+  bench_report("compress", bench_time([&]() {
+    xmat::compress(v, x, m);
+    bench_keep(v.ptr()[0]);
+  }), bytes);
+}
+} // namespace
+
+
+int main() {
+  bench_take();
+  bench_compress();
+  return EXIT_SUCCESS;
+}
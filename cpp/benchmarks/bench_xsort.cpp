@@ -0,0 +1,85 @@
+#include <cstdlib>
+#include <complex>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xsort.hpp"
+#include "bench_common.hpp"
+
+
+// peak picking: top 8 of [256, 4096] complex<float> spectra by magnitude,
+// per-row std::vector copies vs xmat::topk; sorting networks on short rows
+namespace {
+
+template<typename T>
+void fill(T& x) {
+  size_t r = 12345;
+  for (auto it = x.fbegin(), end = x.fend(); it != end; ++it) {
+    r = r * 1103515245 + 12345;
+    const float a = float((r >> 16) & 0x7fff), b = float((r >> 8) & 0x7fff);
+    *it = typename T::value_type(a, b);
+  }
+}
+
+void bench_topk() {
+  constexpr size_t rows = 256, cols = 4096, k = 8;
+  xmat::NArray<std::complex<float>, 2> x{{rows, cols}};
+  fill(x);
+  xmat::NArray<std::complex<float>, 2> v{{rows, k}};
+  xmat::NArray<std::uint32_t, 2> q{{rows, k}};
+  const double bytes = double(x.numel()) * sizeof(std::complex<float>);
+
+  bench_report("vector copy + partial_sort", bench_time([&]() {
+    std::vector<size_t> idx(cols);
+    for (size_t i = 0; i < rows; ++i) {
+      std::vector<std::complex<float>> row(&x.at(i, 0), &x.at(i, 0) + cols);
+      std::iota(idx.begin(), idx.end(), size_t{0});
+      std::partial_sort(idx.begin(), idx.begin() + k, idx.end(), [&](size_t a, size_t b) {
+        return std::norm(row[a]) > std::norm(row[b]);
+      });
+      for (size_t j = 0; j < k; ++j) { v.at(i, j) = row[idx[j]]; q.at(i, j) = std::uint32_t(idx[j]); }
+    }
+    bench_keep(q.ptr()[0]);
+  }), bytes);
+  bench_report("topk<1>", bench_time([&]() {
+    xmat::topk<1>(v, q, x);
+    bench_keep(q.ptr()[0]);
+  }), bytes);
+  bench_report("par::topk<1>", bench_time([&]() {
+    xmat::par::topk<1>(v, q, x);
+    bench_keep(q.ptr()[0]);
+  }), bytes);
+}
+
+void bench_short_rows() {
+  constexpr size_t rows = 1 << 16, cols = 8;
+  xmat::NArray<float, 2> x0{{rows, cols}};
+  size_t r = 777;
+  for (auto it = x0.fbegin(), end = x0.fend(); it != end; ++it) {
+    r = r * 1103515245 + 12345;
+    *it = float((r >> 16) & 0x7fff);
+  }
+  xmat::NArray<float, 2> x{{rows, cols}};
+  const double bytes = double(x.numel()) * sizeof(float);
+
+  bench_report("std::sort rows of 8", bench_time([&]() {
+    std::copy_n(x0.ptr(), x0.numel(), x.ptr());
+    for (size_t i = 0; i < rows; ++i) { std::sort(&x.at(i, 0), &x.at(i, 0) + cols); }
+    bench_keep(x.ptr()[0]);
+  }), bytes);
+  bench_report("sort<1> rows of 8", bench_time([&]() {
+    std::copy_n(x0.ptr(), x0.numel(), x.ptr());
+    xmat::sort<1>(x);
+    bench_keep(x.ptr()[0]);
+  }), bytes);
+}
+} // namespace
+
+
+int main() {
+  bench_topk();
+  bench_short_rows();
+  return EXIT_SUCCESS;
+}
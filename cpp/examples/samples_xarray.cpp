@@ -302,12 +302,177 @@ int sample_6() {
   print(1, "FINISH", 1, '=');
   return 1;
 }
+
+
+int sample_7() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("NArrayFixed", 0, '-');
+
+  xmat::NArrayFixed<std::complex<float>, 2, 2> h{{1, 0}, {0, 1}, {0, -1}, {1, 0}};
+  printv(sizeof(h));
+  printv(h.at(1, 0));
+  printv(h);
+
+  print(1, "interface: views and iterators as for NArray_", 0, '-');
+  xmat::NArrayFixed<int, 3, 4> a;
+  a.enumerate();
+  printv(a.view<2>({xmat::sl::all, xmat::Slice(1, 3)}));
+
+  print(1, "F-order", 0, '-');
+  xmat::NArrayFixedxF<int, 3, 4> f;
+  f.enumerate();
+  printv(f);
+  printv(f.stride());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_8() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("NArray_ with padded rows: xmat::Pitch", 0, '-');
+
+  xmat::NArray<float, 2> a{{3, 5}, xmat::Pitch{64}};
+  a.enumerate();
+  printv(a);
+  printv(a.stride());
+  printv(a.pitch());
+  printv(xmat::is_aligned(&a.at(1, 0), 64));
+
+  print(1, "copy keeps the pitch", 0, '-');
+  auto b = a;
+  printv(b.stride());
+  printv(xmat::is_aligned(&b.at(2, 0), 64));
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_9() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("NArraySmall: up to N elements inline, no heap", 0, '-');
+
+  xmat::NArraySmall<float, 2, 16> a{{2, 3}};
+  a.enumerate();
+  printv(a);
+  printv(a.storage_.is_inline());
+
+  print(1, "larger than N: std::allocator", 0, '-');
+  xmat::NArraySmall<float, 2, 16> b{{4, 5}};
+  printv(b.storage_.is_inline());
+
+  print(1, "move and swap copy inline elements", 0, '-');
+  auto c = std::move(a);
+  swap(b, c);
+  printv(b);
+  printv(b.storage_.is_inline());
+  printv(c.storage_.is_inline());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_10() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("append_rows: [N, channels] accumulator, geometric growth", 0, '-');
+
+  xmat::NArray<float, 2> acc{{0, 3}};
+  xmat::NArray<float, 2> block{{2, 3}};
+  for (int k = 0; k < 3; ++k) {
+    block.enumerate();
+    acc.append_rows(block);
+    printv(acc.capacity());
+  }
+  printv(acc);
+
+  print(1, "arena: the buffer is extended in place", 0, '-');
+  char buf[1024];
+  xmat::MemorySource ms{buf, sizeof(buf)};
+  xmat::NArray_<float, 2, xmat::AllocatorMSRef<float>> arr{{0, 3}, xmat::AllocatorMSRef<float>{&ms}};
+  arr.reserve(1);
+  const float* p0 = arr.ptr();
+  arr.resize(40);
+  printv(arr.ptr() == p0);
+  printv(arr.capacity());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_11() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("begin(): sub-arrays along the outer (largest stride) dim, F-order: columns", 0, '-');
+
+  xmat::NArrayxF<float, 2> f{{3, 4}};
+  f.enumerate();
+  printv(f);
+  size_t j = 0;
+  for (auto& col : f) {
+    printv(col);
+    printv(&col.at(0) == &f.at(0, j));
+    ++j;
+  }
+
+  print(1, "F-order view, every second column", 0, '-');
+  auto fv = f.view<2>({xmat::sl::all, xmat::Slice(0, 4, 2)});
+  j = 0;
+  for (auto& col : fv) {
+    printv(col);
+    printv(&col.at(0) == &f.at(0, 2 * j));
+    ++j;
+  }
+
+  print(1, "C-order view, every second row", 0, '-');
+  xmat::NArray<float, 2> c{{6, 3}};
+  c.enumerate();
+  auto cv = c.view<2>({xmat::Slice(1, 6, 2), xmat::sl::all});
+  size_t i = 0;
+  for (auto& row : cv) {
+    printv(row);
+    printv(&row.at(0) == &c.at(1 + 2 * i, 0));
+    ++i;
+  }
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_12() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("empty 1-D arrays grow: resize, append_rows", 0, '-');
+
+  xmat::NArray<int, 1> a;
+  a.resize(5);
+  printv(a.capacity());
+  printv(a);
+
+  xmat::NArray<int, 1> b;
+  xmat::NArray<int, 1> part{{3}};
+  part.enumerate();
+  b.append_rows(part);
+  b.append_rows(part);
+  printv(b);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
 } // namespace
 
 
 int main() {
   print("START: " __FILE__, 0, '=');
   sample_5();
+  sample_7();
+  sample_8();
+  sample_9();
+  sample_10();
+  sample_11();
+  sample_12();
   print("END: " __FILE__, 0, '=');
   return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <complex>
+#include <cstdint>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xconvert.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("astype: complex<int16_t> IQ -> complex<float>, full scale 1.0", 0, '-');
+
+  xmat::NArray<std::complex<std::int16_t>, 1> iq{{4}};
+  iq.at(0) = {16384, -16384};
+  iq.at(1) = {32767, 0};
+  iq.at(2) = {-32768, 1};
+  iq.at(3) = {0, 8192};
+
+  xmat::NArray<std::complex<float>, 1> y{{4}};
+  xmat::astype(y, iq, 1.0 / 32768);
+  printv(y);
+
+  print(1, "saturating: float -> int8_t, rounded to nearest", 0, '-');
+  xmat::NArray<float, 1> x{{6}};
+  x.enumerate();
+  auto q = xmat::astype<std::int8_t>(x, 50.0, -100.0);  // -100, -50, 0, 50, 100, 127
+  for (size_t i = 0; i < q.shape()[0]; ++i) { *kOutStream << int(q.at(i)) << ", "; }
+  *kOutStream << "\n";
+
+  print(1, "strided views, real -> complex", 0, '-');
+  xmat::NArray<double, 2> a{{2, 4}};
+  a.enumerate();
+  auto c = xmat::astype<std::complex<float>>(a.view<2>({xmat::sl::all, xmat::Slice(0, 4, 2)}));
+  printv(c);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <complex>
+#include <vector>
+#include <algorithm>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xcopy.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("C <-> F conversion: copy_to(dst, src)", 0, '-');
+
+  xmat::NArray<float, 2> c{{3, 5}};
+  c.enumerate();
+  printv(c);
+
+  xmat::NArrayxF<float, 2> f{{3, 5}};
+  xmat::copy_to(f, c);
+  print(1, "same logical elements, F-order in memory", 0, '-');
+  printv(f);
+  print_mv("memory: ", std::vector<float>(f.ptr(), f.ptr() + f.numel()));
+
+  print(1, "ViewC <- ViewF", 0, '-');
+  xmat::NArray<float, 2> y{{3, 5}};
+  xmat::ViewF<float, 2> vf{f.ptr(), f.ravel()};
+  xmat::ViewC<float, 2> vy{y.ptr(), y.ravel()};
+  xmat::copy_to(vy, vf);
+  printv(y);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("permuted views", 0, '-');
+
+  xmat::NArray<std::complex<float>, 3> a{{2, 3, 4}};
+  for (size_t n = 0; n < a.numel(); ++n) { a.ptr()[n] = {float(n), -float(n)}; }
+
+  print(1, "t := a.permute({2, 0, 1}), shape", 0, '-');
+  xmat::NArray<std::complex<float>, 3> t{{4, 2, 3}};
+  xmat::copy_to(t, a.permute({2, 0, 1}));
+  printv(t.shape());
+  print_mv("t(3, 1, 2) == a(1, 2, 3): ", t.at(3, 1, 2) == a.at(1, 2, 3));
+
+  print(1, "transposed view as destination", 0, '-');
+  xmat::NArray<std::complex<float>, 3> b{{2, 3, 4}};
+  xmat::copy_to(t.permute({1, 2, 0}), a);
+  xmat::copy_to(b, t.permute({1, 2, 0}));
+  print_mv("b == a: ", std::equal(a.ptr(), a.ptr() + a.numel(), b.ptr()));
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_2() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("strided assign with broadcasting: assign(dst, src)", 0, '-');
+
+  using xmat::sl;
+  xmat::NArray<float, 1> row{{5}};
+  row.enumerate();
+
+  xmat::NArray<float, 2> y{{3, 5}};
+  print(1, "row broadcast over dim 0 (sl::newaxis)", 0, '-');
+  xmat::assign(y, row.view<2>({sl::newaxis, sl::all}));
+  printv(y);
+
+  print(1, "column of y into every other column of an F-order array", 0, '-');
+  xmat::NArrayxF<float, 2> f{{3, 6}};
+  std::fill_n(f.ptr(), f.numel(), 0.0f);
+  xmat::assign(f.view<2>({sl::all, xmat::Slice(0, 6, 2)}), y.view<2>({sl::all, xmat::Slice(4, 5)}));
+  printv(f);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  sample_2();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <complex>
+#include <cstdint>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xdynarray.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("NArrayDyn: blocks of unknown ndim/type", 0, '-');
+  using xmat::Endian;
+
+  xmat::OMapStream<Endian::native> xout{};
+  xmat::NArray<float, 2> a{{2, 3}};
+  a.enumerate();
+  xmat::NArray<std::int16_t, 1> b{{4}};
+  b.enumerate();
+  xout.setitem("a", a);
+  xout.setitem("b", b);
+  xout.close();
+
+  auto xoutms = xout.stream().get_memsource();
+  xmat::IDStreamMS<Endian::native> xin_ibb{&xoutms};
+  xin_ibb.push_all();
+  xmat::IMapStreamMS<Endian::native> xin{std::move(xin_ibb)};
+
+  print(1, "generic loop over blocks", 0, '-');
+  for (auto it = xin.begin(), end = xin.end(); it != end; ++it) {
+    auto x = it.get<xmat::NArrayDyn>();
+    print_mv("name: ", it->name());
+    printv(int(x.tid()));
+    printv(x.ndim());
+    printv(x.numel());
+    if (x.is<float>()) { 
+      auto v = x.as<float, 2>();
+      printv(v); 
+    }
+    if (x.is<std::int16_t>()) {
+      auto v = x.as<std::int16_t, 1>();
+      printv(v);
+    }
+  }
+
+  print(1, "wrong type", 0, '-');
+  auto y = xin.at("a").get<xmat::NArrayDyn>();
+  try { y.as<double, 2>(); }
+  catch (const xmat::TypeError& e) { print_mv("xmat::TypeError: ", e.what()); }
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
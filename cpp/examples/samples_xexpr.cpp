@@ -0,0 +1,111 @@
+#include <cmath>
+#include <iostream>
+#include <complex>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xexpr.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("lazy expressions: assign(dst, expr)", 0, '-');
+
+  xmat::NArray<float, 2> a{{3, 4}}, b{{3, 4}}, y{{3, 4}};
+  a.enumerate();
+  b.enumerate();
+
+  print(1, "y = a*b + 1 - a/2", 0, '-');
+  xmat::assign(y, a*b + 1 - a/2);
+  printv(y);
+
+  print(1, "strided view as destination and operand", 0, '-');
+  using xmat::sl;
+  xmat::assign(y.view<2>({sl::all, xmat::Slice(0, 4, 2)}), 
+               -a.view<2>({sl::all, xmat::Slice(0, 2)}));
+  printv(y);
+
+  print(1, "F-order operand", 0, '-');
+  xmat::NArrayxF<float, 2> f{{3, 4}};
+  f.enumerate();
+  xmat::assign(y, a + f);
+  printv(y);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("complex, comparison, functions", 0, '-');
+
+  xmat::NArray<std::complex<float>, 1> z{{5}};
+  for (size_t n = 0; n < 5; ++n) { z.at(n) = {float(n), 1.0f}; }
+
+  xmat::NArray<float, 1> r{{5}};
+  xmat::assign(r, xmat::abs(z * 2));
+  printv(r);
+
+  xmat::NArray<bool, 1> m{{5}};
+  xmat::assign(m, xmat::real(xmat::conj(z)) > 1.5);
+  printv(m);
+
+  xmat::assign(r, xmat::sqrt(xmat::exp(-r)));
+  printv(r);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_2() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("broadcasting: extent-1 dims are repeated", 0, '-');
+  using xmat::sl;
+
+  xmat::NArray<float, 2> x{{3, 4}}, y{{3, 4}};
+  x.enumerate();
+  xmat::NArray<float, 1> gain{{3}}, u{{4}};
+  for (size_t n = 0; n < 3; ++n) { gain.at(n) = float(n + 1); }
+  for (size_t n = 0; n < 4; ++n) { u.at(n) = float(n); }
+
+  print(1, "per-row gain: [3, 4] * [3, 1]", 0, '-');
+  xmat::assign(y, x * gain.view<2>({sl::all, sl::nax}));
+  printv(y);
+
+  print(1, "outer product: [3, 1] * [1, 4]", 0, '-');
+  xmat::assign(y, gain.view<2>({sl::all, sl::nax}) * u.view<2>({sl::nax, sl::all}));
+  printv(y);
+
+  print(1, "expression broadcast to destination: [1, 4] -> [3, 4]", 0, '-');
+  xmat::assign(y, -u.view<2>({sl::nax, sl::all}));
+  printv(y);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  sample_2();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
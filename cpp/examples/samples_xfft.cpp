@@ -0,0 +1,79 @@
+#include <iostream>
+#include <complex>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xfft.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("fft, ifft along an axis: channels x samples", 0, '-');
+  using cfloat = std::complex<float>;
+
+  xmat::NArray<cfloat, 2> x{{2, 6}}, y{{2, 6}};
+  for (size_t j = 0; j < 6; ++j) {
+    x.at(0, j) = {1.0f, 0.0f};                 // DC
+    x.at(1, j) = {float(j % 2 ? -1 : 1), 0.0f};  // Nyquist
+  }
+  printv(x);
+
+  print(1, "fft<1>: along samples", 0, '-');
+  xmat::fft<1>(y, x);
+  printv(y);
+
+  print(1, "ifft<1>: in place, scaled by 1/n", 0, '-');
+  xmat::ifft<1>(y, y);
+  printv(y);
+
+  print(1, "fft<0>: along channels", 0, '-');
+  xmat::fft<0>(y, x);
+  printv(y);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("rfft, irfft: real signal, n/2+1 bins", 0, '-');
+
+  xmat::NArray<double, 1> r{{8}}, r2{{8}};
+  r.enumerate();
+  xmat::NArray<std::complex<double>, 1> spec{{5}};
+  xmat::rfft<0>(spec, r);
+  printv(spec);
+
+  xmat::irfft<0>(r2, spec);
+  printv(r2);
+
+  print(1, "plans are cached per length", 0, '-');
+  printv(xmat::FftPlanD::get(8) == xmat::FftPlanD::get(8));
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
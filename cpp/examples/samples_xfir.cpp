@@ -0,0 +1,80 @@
+#include <iostream>
+#include <complex>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xfir.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("FirFilter: blocks of a stream, 2 channels x samples", 0, '-');
+
+  xmat::FirFilter<float> fir{{0.5f, 0.5f}};  // moving average
+  printv(int(fir.method()));
+
+  xmat::NArray<float, 2> x{{2, 4}}, y{{2, 4}};
+  for (int block = 0; block < 2; ++block) {
+    x.enumerate();
+    fir.apply<1>(y, x);
+    print_mv("block ", block);
+    printv(y);  // first sample of block 1 uses the last of block 0
+  }
+
+  print(1, "complex data, real taps, F-order block [samples, channels]", 0, '-');
+  xmat::FirFilter<std::complex<float>, float> cfir{{1.0f, 0.0f, -1.0f}};
+  xmat::NArrayxF<std::complex<float>, 2> cx{{5, 2}}, cy{{5, 2}};
+  for (size_t i = 0; i < 5; ++i) { cx.at(i, 0) = {float(i * i), 1.0f}; cx.at(i, 1) = {1.0f, float(i)}; }
+  cfir.apply<0>(cy, cx);
+  printv(cy);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("polyphase: decimate by 3, interpolate by 2", 0, '-');
+
+  xmat::NArray<double, 1> x{{8}};
+  x.enumerate();
+
+  xmat::FirFilter<double> dec{{1.0}, xmat::Rate{1, 3}};
+  xmat::NArray<double, 1> yd{{dec.out_size(8)}};
+  dec.apply<0>(yd, x);
+  printv(yd);
+  printv(dec.out_size(8));  // phase is carried to the next block
+
+  xmat::FirFilter<double> itp{{0.5, 1.0, 0.5}, xmat::Rate{2, 1}};  // linear interpolation
+  xmat::NArray<double, 1> yu{{itp.out_size(8)}};
+  itp.apply<0>(yu, x);
+  printv(yu);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
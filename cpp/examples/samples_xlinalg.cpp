@@ -0,0 +1,78 @@
+#include <iostream>
+#include <complex>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xlinalg.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("matmul, gemm: any strides", 0, '-');
+
+  xmat::NArray<float, 2> a{{2, 3}}, c{{2, 2}};
+  xmat::NArrayxF<float, 2> b{{3, 2}};
+  a.enumerate();
+  b.enumerate();
+  printv(a);
+  printv(b);
+
+  print(1, "C = A*B, F-order B", 0, '-');
+  xmat::matmul(c, a, b);
+  printv(c);
+
+  print(1, "C = 2*B^T*A^T + C, transposed views", 0, '-');
+  xmat::gemm(c.permute({1, 0}), b.permute({1, 0}), a.permute({1, 0}), 2.0f, 1.0f);
+  printv(c);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("complex: beamforming weights x channels", 0, '-');
+  using cfloat = std::complex<float>;
+
+  xmat::NArray<cfloat, 2> w{{2, 3}}, x{{3, 4}}, y{{2, 4}};
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t k = 0; k < 3; ++k) { w.at(i, k) = {float(i == k), float(i + k)}; }
+  }
+  for (size_t k = 0; k < 3; ++k) {
+    for (size_t j = 0; j < 4; ++j) { x.at(k, j) = {float(j), -float(k)}; }
+  }
+  xmat::matmul(y, w, x);
+  printv(y);
+
+  print(1, "gemv: y = W*x[:, 0]", 0, '-');
+  xmat::NArray<cfloat, 1> y0{{2}};
+  xmat::gemv(y0, w, x.keep<1>({0}));  // strided column
+  printv(y0);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
@@ -149,6 +149,139 @@ int sample_1() {
   print(1, "FINISH", 1, '=');
   return 1;
 }
+
+
+int sample_2() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("MemorySourceGlobalMT: lock-free, any thread may allocate", 0, '-');
+
+  xmat::MemorySourceGlobalMT::reset(1 << 12);
+  printv(xmat::MemorySourceGlobalMT::space());
+
+  xmat::AllocatorMSGlobalMT<float, 64> alc;
+  float* p0 = alc.allocate(10);
+  printv(xmat::is_aligned(p0, 64));
+  printv(xmat::MemorySourceGlobalMT::used());
+
+  print(1, "the last block of this thread grows in place", 0, '-');
+  float* p1 = alc.extend(p0, 112);
+  printv(p1 == p0);
+  printv(xmat::MemorySourceGlobalMT::used());
+
+  print(1, "blocks freed in reverse order go back", 0, '-');
+  float* p2 = alc.allocate(16);
+  alc.deallocate(p2, 16);
+  alc.deallocate(p1, 112);
+  printv(xmat::MemorySourceGlobalMT::used());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_3() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("MemorySourceThread + ArenaScope: one frame, one rewind", 0, '-');
+
+  xmat::MemorySourceThread::reset(1 << 12);
+  for (int frame = 0; frame < 2; ++frame) {
+    xmat::ArenaScope scope;
+    xmat::AllocatorMSRef<char> rx{scope.source()};   // as in IBBufMS, NArrayMS
+    xmat::AllocatorMSThread<float, 16> alc;
+    rx.allocate(100);
+    alc.allocate(64);
+    printv(scope.used());
+    printv(xmat::MemorySourceThread::get().used());
+  }
+  print(1, "after the frames", 0, '-');
+  printv(xmat::MemorySourceThread::get().used());
+
+  print(1, "nested scope, rewind()", 0, '-');
+  xmat::ArenaScope outer;
+  outer.source()->allocate(32);
+  {
+    xmat::ArenaScope inner;
+    inner.source()->allocate(1000);
+    printv(outer.used());
+    inner.rewind();
+    printv(outer.used());
+  }
+  printv(outer.used());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_4() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("MemorySourceStack: deallocate() gives memory back", 0, '-');
+
+  const size_t N = 1 << 10;
+  char buf[N] = {};
+  xmat::MemorySource ms(buf, N);
+  xmat::AllocatorMSStack<float, 16> alc{&ms};
+
+  float* p0 = alc.allocate(16);
+  float* p1 = alc.allocate(16);
+  float* p2 = alc.allocate(16);
+  printv(ms.used());
+
+  print(1, "out of order: p1 is kept until p2 goes", 0, '-');
+  alc.deallocate(p1, 16);
+  printv(ms.used());
+  alc.deallocate(p2, 16);
+  printv(ms.used());
+
+  print(1, "the top block grows in place", 0, '-');
+  printv(alc.extend(p0, 64) == p0);
+  alc.deallocate(p0, 64);
+  printv(ms.used());
+
+  print(1, "mark()/rewind()", 0, '-');
+  xmat::MemorySourceStack stack{&ms};
+  auto m = stack.mark();
+  stack.allocate(100);
+  stack.allocate(200, 64);
+  printv(ms.used());
+  stack.rewind(m);
+  printv(ms.used());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_5() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("MemorySourcePool: power-of-two size classes, free lists", 0, '-');
+
+  using pool_t = xmat::MemorySourcePool;
+  pool_t::reset_stats();
+  xmat::AllocatorMSPool<std::complex<float>, 64> alc;
+
+  auto* p0 = alc.allocate(1000);
+  printv(pool_t::capacity(p0));
+  printv(xmat::is_aligned(p0, 64));
+
+  print(1, "in place up to the class size", 0, '-');
+  printv(alc.extend(p0, 1024, std::nothrow) == p0);
+  printv(alc.extend(p0, 1025, std::nothrow) == nullptr);
+
+  print(1, "the same class again: from the free list", 0, '-');
+  alc.deallocate(p0, 1024);
+  auto* p1 = alc.allocate(700);
+  printv(p1 == p0);
+  alc.deallocate(p1, 700);
+
+  const auto st = pool_t::stats();
+  printv(st.hits);
+  printv(st.misses);
+
+  pool_t::trim();
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
 }
 
 
@@ -157,6 +290,10 @@ int main() {
   
   try {
     sample_1();
+    sample_2();
+    sample_3();
+    sample_4();
+    sample_5();
   }
   catch (std::exception& err) {
     print(1, "----------------------\n");
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <cstdint>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xmmap.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("MappedBuffer: pre-faulted, huge pages if the system has them", 0, '-');
+
+  xmat::MapOptions opt;
+  opt.huge = xmat::HugePages::explicit_;  // falls back to transparent, then normal pages
+  opt.lock = true;                         // may fail: RLIMIT_MEMLOCK
+  xmat::MappedBuffer mb{size_t{1} << 22, opt};
+  printv(mb.size());
+  printv(mb.mapped() >= mb.size());
+  printv(mb.populated());
+  printv(xmat::is_aligned(mb.data(), 64));
+
+  print(1, "the backing store of MemorySourceGlobal", 0, '-');
+  xmat::MemorySourceGlobal::reset(mb.data(), mb.size());
+  xmat::NArrayGMS<float, 2> a{{64, 256}};
+  printv(a.ptr() == reinterpret_cast<float*>(mb.data()));
+  printv(xmat::MemorySourceGlobal::get().used());
+  xmat::MemorySourceGlobal::reset(1 << 10);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("MemorySourceMapped: a MemorySource on its own mapping", 0, '-');
+
+  xmat::MemorySourceMapped ms{size_t{1} << 20, {xmat::HugePages::none, true, false}};
+  printv(ms.space());
+  printv(ms.buffer().pages() == xmat::HugePages::none);
+
+  xmat::NArrayMS<int, 2> a{{16, 16}, &ms};
+  a.at(15, 15) = 1;
+  printv(ms.used());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+#include <cmath>
+#include <iostream>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xlinalg.hpp"
+#include "../include/xmat/xparallel.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("par::for_each, par::transform, par::reduce", 0, '-');
+
+  printv(xmat::par::ThreadPool::global().size());
+
+  xmat::NArray<float, 3> x{{64, 128, 256}}, y{{64, 128, 256}};
+  x.enumerate();
+
+  print(1, "par::for_each: x = x / 2", 0, '-');
+  xmat::par::for_each(x, [](float& v) { v /= 2; });
+  printv(x.at(1, 2, 3));
+
+  print(1, "par::transform: y = sqrt(x)", 0, '-');
+  xmat::par::transform(y, x, [](float v) { return std::sqrt(v); });
+  printv(y.at(1, 2, 3));
+
+  print(1, "par::reduce", 0, '-');
+  printv(xmat::par::reduce(y, xmat::rd::max{}));
+  printv(xmat::par::reduce(x, 0.0, [](double a, double b) { return a + b; }));
+
+  print(1, "sliced view and own pool", 0, '-');
+  xmat::par::ThreadPool pool{4};
+  using xmat::sl;
+  auto v = x.view<3>({sl::all, xmat::Slice(0, 128, 2), sl::all});
+  xmat::par::for_each(v, [](float& a) { a = 0; }, 1 << 10, pool);
+  printv(xmat::par::reduce(x, xmat::rd::sum{}, 1 << 10, pool));
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("par::matmul: row blocks of C in parallel", 0, '-');
+
+  xmat::NArray<double, 2> a{{300, 200}}, b{{200, 100}}, c{{300, 100}}, c1{{300, 100}};
+  a.enumerate();
+  b.enumerate();
+
+  xmat::par::ThreadPool pool{4};
+  xmat::par::matmul(c, a, b, xmat::par::k_grain, pool);
+  xmat::matmul(c1, a, b);
+  printv(c.at(299, 99));
+  printv(c1.at(299, 99));
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
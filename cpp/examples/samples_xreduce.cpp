@@ -0,0 +1,82 @@
+#include <cmath>
+#include <iostream>
+#include <complex>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xreduce.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("reduce<Axis>(out, x, op)", 0, '-');
+
+  xmat::NArray<float, 3> x{{2, 3, 4}};
+  x.enumerate();
+  printv(x);
+
+  xmat::NArray<float, 2> y2{{2, 3}};
+  xmat::reduce<2>(y2, x, xmat::rd::sum{});
+  printv(y2);
+
+  xmat::NArray<float, 2> y0{{3, 4}};
+  xmat::reduce<0>(y0, x, xmat::rd::mean{});
+  printv(y0);
+
+  xmat::NArray<size_t, 2> i1{{2, 4}};
+  xmat::reduce<1>(i1, x, xmat::rd::argmax{});
+  printv(i1);
+
+  print(1, "reduce(x, op): all elements", 0, '-');
+  printv(xmat::reduce(x, xmat::rd::sum{}));
+  printv(xmat::reduce(x, xmat::rd::var{}));
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("complex data", 0, '-');
+
+  xmat::NArray<std::complex<float>, 2> z{{2, 5}};
+  for (size_t n = 0; n < 5; ++n) {
+    z.at(0, n) = {float(n), 1.0f};
+    z.at(1, n) = {1.0f, -float(n)};
+  }
+
+  xmat::NArray<float, 1> nrm{{2}};
+  xmat::reduce<1>(nrm, z, xmat::rd::norm{});
+  printv(nrm);
+
+  xmat::NArray<std::complex<float>, 1> mx{{2}};
+  xmat::reduce<1>(mx, z, xmat::rd::max{});
+  printv(mx);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xselect.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("take: rows 3, 0, 3 of a 4x5 array", 0, '-');
+
+  xmat::NArray<float, 2> a{{4, 5}};
+  a.enumerate();
+  xmat::NArray<float, 2> rows{{3, 5}};
+  xmat::take<0>(rows, a, {3, 0, 3});
+  printv(rows);
+
+  print(1, "take: samples 4, 1 of each row", 0, '-');
+  std::vector<size_t> idx{4, 1};
+  xmat::NArray<float, 2> cols{{4, 2}};
+  xmat::take<1>(cols, a, idx);
+  printv(cols);
+
+  print(1, "put: scatter them back into zeros", 0, '-');
+  xmat::NArray<float, 2> z{{4, 5}};
+  std::fill(z.fbegin(), z.fend(), 0.f);
+  xmat::put<1>(z, idx, cols);
+  printv(z);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("compress: elements above 10, then expand back", 0, '-');
+
+  xmat::NArray<float, 2> a{{4, 5}};
+  a.enumerate();
+  xmat::NArray<std::uint8_t, 2> mask{{4, 5}};
+  std::transform(a.fbegin(), a.fend(), mask.fbegin(), [](float x) { return x > 10; });
+
+  xmat::NArray<float, 1> v{{xmat::count_nonzero(mask)}};
+  xmat::compress(v, a, mask);
+  printv(v);
+
+  std::transform(v.fbegin(), v.fend(), v.fbegin(), [](float x) { return -x; });
+  xmat::expand(a, mask, v);
+  printv(a);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
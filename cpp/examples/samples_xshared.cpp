@@ -0,0 +1,87 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xshared.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("SharedView: the buffer lives while any view refers to it", 0, '-');
+
+  xmat::NArrayShared<float, 2> frame{{3, 4}};
+  frame.enumerate();
+
+  auto s = xmat::share(std::move(frame));  // frame is empty now
+  printv(s);
+  printv(s.use_count());
+
+  auto rows = s.share(s.view<2>({xmat::Slice(1, 3), xmat::sl::all}));
+  printv(s.use_count());
+
+  s = {};  // rows keeps the buffer
+  printv(rows);
+  printv(rows.use_count());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("fan-out to threads without copies, copy-on-write", 0, '-');
+
+  xmat::NArrayShared<double, 1> x{{1000}};
+  x.enumerate();
+  auto s = xmat::share(std::move(x));
+
+  std::vector<double> sums(4);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < sums.size(); ++t) {
+    threads.emplace_back([s, t, &sums]() {
+      double acc = 0;
+      for (auto it = s.fbegin(), end = s.fend(); it != end; ++it) { acc += *it; }
+      sums[t] = acc;
+    });
+  }
+  for (auto& th : threads) { th.join(); }
+  printv(sums[0]);
+  printv(sums[3]);
+
+  auto w = s;
+  printv(w.use_count());
+  w.detach();  // private copy before mutating
+  w.at(0) = -1;
+  printv(s.at(0));
+  printv(w.at(0));
+  printv(w.use_count());
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
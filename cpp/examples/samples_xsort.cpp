@@ -0,0 +1,83 @@
+#include <iostream>
+#include <complex>
+#include <cstdint>
+
+#include "../include/xmat/xarray.hpp"
+#include "../include/xmat/xsort.hpp"
+#include "common.hpp"
+
+
+std::ostream* kOutStream = &std::cout;
+
+namespace {
+
+int sample_x() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("COMMENT", 0, '-');
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_0() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("sort and argsort every row", 0, '-');
+
+  xmat::NArray<int, 2> a{{3, 6}};
+  int vals[] = {5, -1, 3, 0, 9, -7};
+  for (size_t i = 0; i < 3; ++i) {
+    for (size_t j = 0; j < 6; ++j) { a.at(i, j) = vals[(i * 2 + j) % 6] * int(i + 1); }
+  }
+  printv(a);
+
+  xmat::NArray<std::uint32_t, 2> idx{{3, 6}};
+  xmat::argsort<1>(idx, a);
+  printv(idx);
+
+  auto s = a;
+  xmat::sort<1>(s);
+  printv(s);
+
+  print(1, "columns of a strided view, by magnitude, largest first", 0, '-');
+  xmat::sort<0>(a.view<2>({xmat::sl::all, xmat::Slice(0, 6, 2)}), xmat::ord::abs_greater{});
+  printv(a);
+
+  print(1, "partition around the median", 0, '-');
+  xmat::nth_element<1>(s, 3, xmat::ord::greater{});
+  printv(s);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+
+
+int sample_1() {
+  print(__PRETTY_FUNCTION__, 1);
+  print("peak picking: top 2 bins of every spectrum by magnitude", 0, '-');
+
+  xmat::NArray<std::complex<float>, 2> spec{{2, 8}};
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < 8; ++j) { spec.at(i, j) = {float((j * 5 + i * 3) % 8), float(i)}; }
+  }
+  printv(spec);
+
+  xmat::NArray<std::complex<float>, 2> peaks{{2, 2}};
+  xmat::NArray<std::uint32_t, 2> bins{{2, 2}};
+  xmat::topk<1>(peaks, bins, spec);
+  printv(peaks);
+  printv(bins);
+
+  print(1, "FINISH", 1, '=');
+  return 1;
+}
+} // namespace
+
+
+int main() {
+  print("START: " __FILE__, 0, '=');
+  sample_0();
+  sample_1();
+  print("END: " __FILE__, 0, '=');
+  return EXIT_SUCCESS;
+}
@@ -8,12 +8,15 @@
 #include <iomanip>
 
 #include <array>
+#include <initializer_list>
 #include <vector>
 #include <complex>
 #include <numeric>
 #include <algorithm>
 #include <iterator>
+#include <new>
 #include <utility>
+#include <stdexcept>
 #include <type_traits>
 
 
@@ -23,6 +26,11 @@
 
 namespace xmat {
 
+class ShapeError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
 // Row- and column-major order
 enum class MOrder: char {
   C = 'C',     // C-language style order: row-major order
@@ -106,6 +114,22 @@ void stride(RandomIt1 shape, RandomIt2 out, size_t ndim) {
   }
 }
 
+// dense strides with rows (the least-stride dim) padded to a multiple of `pitch`
+template<MOrder MOrderT, class RandomIt1, class RandomIt2>
+void stride_pitched(RandomIt1 shape, RandomIt2 out, size_t ndim, size_t pitch) {
+  stride<MOrderT>(shape, out, ndim);
+  if (ndim < 2) { return; }
+  const size_t lowi = morderlowi(MOrderT, ndim);
+  const size_t nexti = MOrderT == MOrder::C ? lowi - 1 : lowi + 1;
+  out[nexti] = align_up_(shape[lowi], pitch);
+  if (MOrderT == MOrder::C) {
+    for (size_t n = nexti; n-- > 0;) { out[n] = out[n + 1] * shape[n + 1]; }
+  }
+  else {
+    for (size_t n = nexti + 1; n < ndim; ++n) { out[n] = out[n - 1] * shape[n - 1]; }
+  }
+}
+
 // MOrder::C
 template<MOrder MOrderT, size_t ND, class RandomIt1, class RandomIt2,
          typename std::enable_if_t<MOrderT == MOrder::C, int> = 0>
@@ -259,7 +283,7 @@ size_t ndcontigous(Iter0 shape, Iter1 stride, size_t ndim) {
   stride += ndim - 1;
   auto expect = *stride;
   for (shape -= 1;
-       *stride == expect && shape_it != shape;
+       shape_it != shape && *stride == expect;
        --shape_it, --stride) {
     expect *= *shape_it;
   }
@@ -273,13 +297,26 @@ size_t ndcontigous(Iter0 shape, Iter1 stride, size_t ndim) {
   auto shape_it = shape;
   auto expect = *stride;
   for (shape += ndim;
-       *stride == expect && shape_it != shape;
+       shape_it != shape && *stride == expect;
        ++shape_it, ++stride) {
     expect *= *shape_it;
   }
   return ndim - (shape - shape_it);
 }
 
+// odometer over the dims outside of the `nc` most data-local dims.
+// returns false after the last position (index is back to zeros)
+template<MOrder MOrderT, typename Iter0, typename Iter1>
+bool next_outer(Iter0 index, Iter1 shape, size_t ndim, size_t nc) {
+  const size_t nout = ndim - nc;
+  for (size_t k = 0; k < nout; ++k) {
+    const size_t d = MOrderT == MOrder::C ? nout - 1 - k : nc + k;
+    if (++index[d] != shape[d]) { return true; }
+    index[d] = 0;
+  }
+  return false;
+}
+
 
 template<typename Iter>
 bool isunique(const Iter begin, const Iter end) {
@@ -460,6 +497,8 @@ template<size_t ND> using Index = Index_<size_t, ND>;
 template<size_t ND, MOrder MOrderT, typename IntT = size_t>
 struct Increment_ {
   static const size_t ndim = ND;
+  static constexpr size_t k_lowi = hidx::morderlowi(MOrderT, ND);
+  static constexpr size_t k_hidi = hidx::morderhidhi(MOrderT, ND);
   using index_t = Index_<IntT, ND>;
 
   Increment_() = default;
@@ -480,26 +519,38 @@ struct Increment_ {
 
   void reset() noexcept { fidx = 0; index.fill(0); }
 
-  void next() noexcept {
-    fidx += hidx::increment<MOrderT>(fidx, ND, index.begin(), shape.begin(), stride.begin());
-  }
+  void next() noexcept { nextd(k_lowi); }
 
-  size_t nextd() noexcept {
-    auto dd = hidx::increment<MOrderT>(fidx, ND, index.begin(), shape.begin(), stride.begin());
-    fidx += dd;
-    return dd;
-  }
+  std::ptrdiff_t nextd() noexcept { return nextd(k_lowi); }
 
-  void next(size_t nd) noexcept {
-    fidx += hidx::increment<MOrderT>(fidx, nd, ND, index.begin(), shape.begin(), stride.begin());
+  void next(size_t nd) noexcept { nextd(nd); }
+
+  // steps dim `nd` and carries into the outer dims, the outermost one never
+  // wraps; returns the change of fidx. No division: a wrapped dim goes back
+  // by stride * (shape - 1), correct for any strides.
+  std::ptrdiff_t nextd(size_t nd) noexcept {
+    assert(nd < ND && "xmat::Increment_::nextd(). nd must be less than ND");
+    if (++index[nd] != shape[nd] || nd == k_hidi) {
+      fidx += static_cast<size_t>(stride[nd]);
+      return static_cast<std::ptrdiff_t>(stride[nd]);
+    }
+    return carry(nd);
   }
 
-  size_t nextd(size_t nd) noexcept {
-    auto dd = hidx::increment<MOrderT>(fidx, nd, ND, index.begin(), shape.begin(), stride.begin());
-    fidx += dd;
+ private:
+  std::ptrdiff_t carry(size_t d) noexcept {
+    std::ptrdiff_t dd = 0;
+    do {
+      index[d] = 0;
+      dd -= static_cast<std::ptrdiff_t>(stride[d] * (shape[d] - 1));
+      d = MOrderT == MOrder::C ? d - 1 : d + 1;
+    } while (++index[d] == shape[d] && d != k_hidi);
+    dd += static_cast<std::ptrdiff_t>(stride[d]);
+    fidx += static_cast<size_t>(dd);
     return dd;
   }
 
+ public:
   index_t shape;
   index_t stride;
   index_t index;
@@ -566,7 +617,7 @@ struct Ravel_ {
   // return: [index_start_delta, ravel]
   template<size_t ND_, MOrder MOrderT_ = MOrderT, typename IntT_ = IntT,
            typename std::enable_if_t<(ND_ >= ND), int> = 0>
-  std::pair<IntT_, Ravel_<ND_, MOrderT_, IntT_>> view(const NSlice<ND_>& nslice) noexcept {
+  std::pair<IntT_, Ravel_<ND_, MOrderT_, IntT_>> view(const NSlice<ND_>& nslice) const noexcept {
     Ravel_<ND_, MOrderT_, IntT_> out;
     Index_<IntT, ND> idx;
 
@@ -601,7 +652,7 @@ struct Ravel_ {
 
   // keep: dims order doesn't matter
   template<size_t Nkeep, typename std::enable_if_t<(Nkeep < ND), int> = 0>
-  Ravel_<Nkeep, MOrderT, IntT> keep(const std::array<size_t, Nkeep>& dims) {
+  Ravel_<Nkeep, MOrderT, IntT> keep(const std::array<size_t, Nkeep>& dims) const {
     assert(hidx::isunique(dims.begin(), dims.end()) && "dims must be unique-values");
 
     // hidx::booblesort(dims.begin(), dims.end());
@@ -615,7 +666,7 @@ struct Ravel_ {
 
   // drops: dims order doesn't matter. must be unique
   template<size_t Ndrop, typename std::enable_if_t<(Ndrop < ND), int> = 0>
-  Ravel_<ND - Ndrop, MOrderT, IntT> drop(const std::array<size_t, Ndrop>& dims) {
+  Ravel_<ND - Ndrop, MOrderT, IntT> drop(const std::array<size_t, Ndrop>& dims) const {
     constexpr size_t Nkeep  = ND - Ndrop;
     std::array<size_t, ND> dkeep;
     std::iota(dkeep.begin(), dkeep.end(), 0);
@@ -628,6 +679,19 @@ struct Ravel_ {
     return keep(keep_dims);
   }
 
+  // permute: out.shape[n] := shape[perm[n]]
+  Ravel_ permute(const std::array<size_t, ND>& perm) const noexcept {
+    assert(hidx::isunique(perm.begin(), perm.end()) && "perm must be unique-values");
+    Ravel_ out;
+    out.origin = origin;
+    for (size_t n = 0; n < ND; ++n) {
+      assert(perm[n] < ND);
+      out.shape[n] = shape[perm[n]];
+      out.stride[n] = stride[perm[n]];
+    }
+    return out;
+  }
+
   // props
   size_t numel() const noexcept { return shape.numel(); }
 
@@ -685,27 +749,47 @@ struct NIterator_<T, 1> {
 
 
 // flat iterator
+// Odometer in MOrderT order: the most data-local dim is stepped by one
+// pointer add, overflows carry to the next dims by subtracting backstrides
+// (stride * (shape - 1)). Works for any strides, e.g. ViewC over F data.
 template<typename T, size_t ND, MOrder MOrderT, typename IntT = size_t>
 struct FIterator_ {
   using increment_t = Increment_<ND, MOrderT, IntT>;
-  using value_type = T;
+  using index_t = Index_<IntT, ND>;
+  using iterator_category = std::forward_iterator_tag;
+  using difference_type = std::ptrdiff_t;
+  using value_type = std::remove_cv_t<T>;
   using pointer = T*;
   using reference = T&;
   using ravel_t = Ravel<1>;
   static const szt ndim = ND;
+  static constexpr size_t k_lowi = hidx::morderlowi(MOrderT, ND);
 
   FIterator_() = default;
 
-  FIterator_(T* ptr, const increment_t& inc) noexcept : ptr_{ptr}, inc_{inc} {}
+  FIterator_(T* ptr, const index_t& shape, const index_t& stride) noexcept 
+  : ptr_{ptr}, shape_{shape}, stride_{stride} {
+    for (size_t n = 0; n < ND; ++n) { back_[n] = shape_[n] ? stride_[n] * (shape_[n] - 1) : 0; }
+  }
 
   // for end iter
-  FIterator_(const increment_t& inc, bool end) noexcept : inc_{inc} { inc_.to_end(); }
+  FIterator_(const index_t& shape, const index_t& stride, bool /*end*/) noexcept 
+  : shape_{shape}, stride_{stride}, fidx_{shape.numel()} {}
+
+  FIterator_(T* ptr, const increment_t& inc) noexcept : FIterator_(ptr, inc.shape, inc.stride) {}
+
+  FIterator_(const increment_t& inc, bool end) noexcept : FIterator_(inc.shape, inc.stride, end) {}
 
   T& operator*() const { return *ptr_; }
 
-  T* operator->() {return ptr_; };
+  T* operator->() const { return ptr_; };
 
-  FIterator_& operator++() { ptr_ += inc_.nextd(); return *this; }
+  FIterator_& operator++() noexcept {
+    ++fidx_;
+    if (++index_[k_lowi] != shape_[k_lowi]) { ptr_ += stride_[k_lowi]; }
+    else { carry(); }
+    return *this;
+  }
   
   FIterator_ operator++(int) {
     FIterator_ tmp = *this;
@@ -713,13 +797,52 @@ struct FIterator_ {
     return tmp;
   }
 
-  bool operator==(const FIterator_& other) const { return inc_.fidx == other.inc_.fidx; }
+  bool operator==(const FIterator_& other) const { return fidx_ == other.fidx_; }
+
+  bool operator!=(const FIterator_& other) const { return fidx_ != other.fidx_; }
+
+  // logical index and flat position of the current element
+  const index_t& index() const noexcept { return index_; }
 
-  bool operator!=(const FIterator_& other) const { return inc_.fidx != other.inc_.fidx; }
+  size_t fidx() const noexcept { return fidx_; }
+
+  // the innermost dim as a counted loop: run() elements from &*it, step()
+  // apart, skip_run() moves past them
+  //   for (auto it = a.fbegin(), end = a.fend(); it != end; it.skip_run()) {
+  //     const T* p = &*it;
+  //     for (size_t i = 0, n = it.run(); i < n; ++i) { s += p[i * it.step()]; }
+  //   }
+  size_t run() const noexcept { return static_cast<size_t>(shape_[k_lowi] - index_[k_lowi]); }
+
+  IntT step() const noexcept { return stride_[k_lowi]; }
+
+  FIterator_& skip_run() noexcept {
+    const size_t n = run();
+    ptr_ += stride_[k_lowi] * (n - 1);
+    index_[k_lowi] = shape_[k_lowi] - 1;
+    fidx_ += n - 1;
+    return ++(*this);
+  }
+
+ private:
+  void carry() noexcept {
+    index_[k_lowi] = 0;
+    ptr_ -= back_[k_lowi];
+    for (size_t k = 1; k < ND; ++k) {
+      const size_t d = MOrderT == MOrder::C ? ND - 1 - k : k;
+      if (++index_[d] != shape_[d]) { ptr_ += stride_[d]; return; }
+      index_[d] = 0;
+      ptr_ -= back_[d];
+    }
+  }
 
  public:
   T* ptr_ = nullptr;
-  Increment_<ND, MOrderT, IntT> inc_;
+  index_t shape_;
+  index_t stride_;
+  index_t back_;
+  index_t index_;
+  size_t fidx_ = 0;
 };
 
 
@@ -736,42 +859,41 @@ struct WIterator_ {
 
   WIterator_() = default;
 
+  // runs: `ndcontig_` jointly contiguous most data-local dims,
+  // the outer dims are walked by inc_.index, inc_.fidx counts runs
   WIterator_(T* ptr, const increment_t& inc) noexcept 
   : ptr_{ptr}, inc_{inc} {
-    // if ndcontig = 2
-    // morder::C:   shape[x, x, x, x]
-    //                          <-->
-    // morder::F:   shape[x, x, x, x]
-    //                    <-->
-    ndcontig_ = xmat::hidx::ndcontigous<MOrderT>(inc_.shape.begin(), inc_.stride.begin(), ND);
-
-    auto sbegin = inc_.shape.begin();
-    auto send = inc_.shape.end();
-    if (MOrderT == MOrder::C) {
-      delta_ = inc_.stride[ND-1];
-      sbegin += ND - ndcontig_;
-      ndcontig_ = ND - ndcontig_;
-    }
-    else { 
-      delta_ = inc_.stride[0];
-      send -= ND - ndcontig_;
-    }
-    length_ = std::accumulate(sbegin, send, IntT{1}, std::multiplies<IntT>());
-
-    // problem: ndcontig (in a proppper case should have `ndconfig -1` val, but it force stride len+1)
-    // so: here inc_ inits in a border value:
-    inc_.index[ndcontig_] = inc_.shape[ndcontig_] - 1;
-    inc_.fidx = inc_.index[ndcontig_] * inc_.stride[ndcontig_];
+    init();
+    inc_.index.fill(0);
+    inc_.fidx = 0;
   }
 
   // for end iter
-  WIterator_(const increment_t& inc, bool end) noexcept : inc_{inc} { inc_.to_end(); }
+  WIterator_(const increment_t& inc, bool /*end*/) noexcept : inc_{inc} { 
+    init();
+    inc_.index.fill(0);
+    inc_.fidx = length_ ? inc_.shape.numel() / length_ : 0;
+  }
 
   iterator_t begin() noexcept { return iterator_t{ptr_, delta_}; }
 
   iterator_t end() noexcept { return iterator_t{ptr_ + delta_ * length_, delta_}; }
 
-  WIterator_& operator++() { ptr_ += inc_.nextd(ndcontig_); return *this; }
+  // the next run: the outer dims carry like FIterator_, no division
+  WIterator_& operator++() { 
+    ++inc_.fidx;
+    const size_t nout = ND - ndcontig_;
+    for (size_t k = 0; k < nout; ++k) {
+      const size_t d = MOrderT == MOrder::C ? nout - 1 - k : ndcontig_ + k;
+      if (++inc_.index[d] != inc_.shape[d]) {
+        ptr_ += inc_.stride[d];
+        return *this;
+      }
+      inc_.index[d] = 0;
+      ptr_ -= inc_.stride[d] * (inc_.shape[d] - 1);
+    }
+    return *this; 
+  }
 
   WIterator_ operator++(int) {
     WIterator_ tmp = *this;
@@ -792,6 +914,27 @@ struct WIterator_ {
 
   IntT length() const noexcept { return length_; }
 
+ private:
+  void init() noexcept {
+    // if ndcontig = 2
+    // morder::C:   shape[x, x, x, x]
+    //                          <-->
+    // morder::F:   shape[x, x, x, x]
+    //                    <-->
+    ndcontig_ = xmat::hidx::ndcontigous<MOrderT>(inc_.shape.begin(), inc_.stride.begin(), ND);
+    auto sbegin = inc_.shape.begin();
+    auto send = inc_.shape.end();
+    if (MOrderT == MOrder::C) {
+      delta_ = inc_.stride[ND-1];
+      sbegin += ND - ndcontig_;
+    }
+    else { 
+      delta_ = inc_.stride[0];
+      send -= ND - ndcontig_;
+    }
+    length_ = std::accumulate(sbegin, send, IntT{1}, std::multiplies<IntT>());
+  }
+
  public:
   T* ptr_ = nullptr;
   Increment_<ND, MOrderT, IntT> inc_;
@@ -848,9 +991,13 @@ struct NArrayInterface_ {
   /*const T&*/ at(Args ... args) const noexcept { assert(ptr()); return ptr()[ravel().at(args...)]; }
 
   // flat-iterator
-  fiterator_t fbegin() noexcept { return {ptr(), {ravel().shape, ravel().stride}}; }
+  fiterator_t fbegin() noexcept { return {ptr(), ravel().shape, ravel().stride}; }
+
+  fiterator_t fend() noexcept { return {ravel().shape, ravel().stride, true}; }
 
-  fiterator_t fend() noexcept { return {{ravel().shape, ravel().stride}, true}; }
+  cfiterator_t fbegin() const noexcept { return {ptr(), ravel().shape, ravel().stride}; }
+
+  cfiterator_t fend() const noexcept { return {ravel().shape, ravel().stride, true}; }
 
   // walk-iterator
   witerator_t wbegin() noexcept { return {ptr(), {ravel().shape, ravel().stride}}; }
@@ -896,6 +1043,9 @@ struct NArrayInterface_ {
   View_<T, ND-Ndrop, MOrderT, IntT> drop(const std::array<size_t, Ndrop>& dims) noexcept;
 
 
+  View_<T, ND, MOrderT, IntT> permute(const std::array<size_t, ND>& perm) noexcept;
+
+
   // fill
   // ------------------------
   void enumerate() noexcept {
@@ -920,7 +1070,8 @@ struct NArrayInterface_ {
 
   const T* ptr() const noexcept { return static_cast<const Derived*>(this)->ptr_; }
 
-  ravel_t& ravel() noexcept { return static_cast<Derived*>(this)->ravel_; }
+  // decltype(auto): the ravel of NArrayFixed_ is static const
+  decltype(auto) ravel() noexcept { return (static_cast<Derived*>(this)->ravel_); }
 
   const ravel_t& ravel() const noexcept { return static_cast<const Derived*>(this)->ravel_; }
 };
@@ -967,7 +1118,10 @@ struct VIterator_ : public View_<T, ND, MOrderT, IntT> {
   using base_t::ptr_;
   using base_t::ravel_;
 
-  using base_t::base_t;
+  VIterator_() = default;
+
+  // sub-array at `ptr`, the next one is at ptr + step
+  VIterator_(T* ptr, const ravel_t& ravel, IntT step) noexcept : base_t{ptr, ravel}, step_{step} { }
   
   base_t& operator*() { return *this; }
 
@@ -982,14 +1136,15 @@ struct VIterator_ : public View_<T, ND, MOrderT, IntT> {
   }
 
   VIterator_& next(size_t n = 1) noexcept {
-    constexpr auto nd = hidx::morderhidhi(MOrderT, ND);
-    ptr_ += n * ravel_.shape[nd] * ravel_.stride[nd];
+    ptr_ += n * step_;
     return *this;
   }
 
   bool operator==(const VIterator_& other) const { return ptr_ == other.ptr_; }
   
   bool operator!=(const VIterator_& other) const { return ptr_ != other.ptr_; }
+
+  IntT step_ = 0;
 };
 
 
@@ -1011,7 +1166,8 @@ template<class Derived, typename T, size_t ND, MOrder MOrderT, typename IntT>
 template<size_t ND_, typename std::enable_if_t<(ND_ > 1), int>>
 VIterator_<T, ND-1, MOrderT, IntT>
 NArrayInterface_<Derived, T, ND, MOrderT, IntT>::begin() noexcept {
-  return {ptr(), ravel().template drop<1>({0})};
+  constexpr auto nd = hidx::morderhidhi(MOrderT, ndim);
+  return {ptr(), ravel().template drop<1>({nd}), ravel().stride[nd]};
 }
 
 // end()
@@ -1047,6 +1203,13 @@ NArrayInterface_<Derived, T, ND, MOrderT, IntT>::drop(const std::array<size_t, N
   return {ptr(), ravel().template drop<Ndrop>(dims)};
 }
 
+// permute
+template<class Derived, typename T, size_t ND, MOrder MOrderT, typename IntT>
+View_<T, ND, MOrderT, IntT>
+NArrayInterface_<Derived, T, ND, MOrderT, IntT>::permute(const std::array<size_t, ND>& perm) noexcept {
+  return {ptr(), ravel().permute(perm)};
+}
+
 
 // ------------------------------------------------------------
 // Array
@@ -1063,6 +1226,36 @@ NArrayInterface_<Derived, T, ND, MOrderT, IntT>::drop(const std::array<size_t, N
 //  std::allocator<T>
 //  xmat::glob_memallocator<T, glob_memsource(default)>
 //  cmat::memallocator<T>
+namespace impl_storage {
+// in-place growth of `p` to [nmin, nmax] elements by arena-like memory sources
+// (MemorySourceBase::extend_reserve), *n is updated on success
+template<class MemSourceT, typename T>
+auto extend(MemSourceT& memsrc, T* p, size_t* n, size_t nmin, size_t nmax, int) noexcept
+  -> decltype(memsrc.extend_reserve(p, nmin, nmax, n, std::nothrow), bool()) {
+  size_t nout = 0;
+  if (!p || !memsrc.extend_reserve(p, nmin, nmax, &nout, std::nothrow) || nout < nmin) { return false; }
+  *n = nout;
+  return true;
+}
+
+// others, e.g. std::allocator: can't
+template<class MemSourceT, typename T>
+bool extend(MemSourceT&, T*, size_t*, size_t, size_t, long) noexcept { return false; }
+
+// n elements on an `align`-byte boundary from arena-like memory sources
+// (MemorySourceBase::allocate(n, aln)), throws std::bad_alloc
+template<typename T, class MemSourceT>
+auto allocate_aligned(MemSourceT& memsrc, size_t n, size_t align, int)
+  -> decltype(memsrc.base()->allocate(n, align), static_cast<T*>(nullptr)) {
+  return static_cast<T*>(memsrc.base()->allocate(n * sizeof(T), align));
+}
+
+// others, e.g. std::allocator: their own alignment
+template<typename T, class MemSourceT>
+T* allocate_aligned(MemSourceT& memsrc, size_t n, size_t, long) { return memsrc.allocate(n); }
+} // namespace impl_storage
+
+
 template<typename T, class MemSourceT>
 struct NArrayStorage_ {
   using memory_source_t = MemSourceT;
@@ -1110,9 +1303,18 @@ struct NArrayStorage_ {
   size_t size() const noexcept { return N_; }
 
 
-  void init(std::size_t n) {
+  // `align` - alignment in bytes the caller applies inside the buffer, 0 - none;
+  // arenas are asked for it
+  void init(std::size_t n, size_t align = 0) {
     N_ = n;
-    data_ = memsource_.allocate(N_); // will throw exception if lack of space
+    data_ = align > alignof(T) ? impl_storage::allocate_aligned<T>(memsource_, N_, align, 0)
+                               : memsource_.allocate(N_); // will throw exception if lack of space
+  }
+
+  // grows the buffer in place to nmin..nmax elements, the data stays;
+  // false if the memory source can't, the caller reallocates
+  bool extend(size_t nmin, size_t nmax) noexcept {
+    return impl_storage::extend(memsource_, data_, &N_, nmin, nmax, 0);
   }
  
  public:
@@ -1122,6 +1324,120 @@ struct NArrayStorage_ {
 };
 
 
+// Small-buffer memory source: arrays up to N elements are stored inline in
+// NArrayStorage_, larger ones are allocated by MemSourceT.
+//   xmat::NArray_<float, 2, xmat::SmallBuffer<std::allocator<float>, 64>> a{{4, 8}};  // no heap
+template<class MemSourceT, size_t N>
+struct SmallBuffer : public MemSourceT {
+  static_assert(N > 0, "xmat::SmallBuffer: capacity must be positive");
+  static constexpr size_t capacity = N;
+
+  SmallBuffer() = default;
+  SmallBuffer(const MemSourceT& memsrc) : MemSourceT{memsrc} {}
+};
+
+template<typename T, class MemSourceT, size_t N>
+struct NArrayStorage_<T, SmallBuffer<MemSourceT, N>> {
+  using memory_source_t = SmallBuffer<MemSourceT, N>;
+
+  // the inline buffer is raw bytes: elements are copied in and out of it, never constructed
+  static_assert(std::is_trivially_copyable<T>::value, "xmat::SmallBuffer: T must be trivially copyable");
+
+  static constexpr bool k_has_default_constructor = std::is_default_constructible<memory_source_t>::value;
+  static constexpr size_t k_capacity = N;
+  static constexpr size_t k_align = alignof(T) > 16 ? alignof(T) : 16;  // of the inline buffer
+
+  template<bool HDC = k_has_default_constructor, typename std::enable_if<HDC, int>::type = 0>
+  NArrayStorage_() {}
+
+  NArrayStorage_(const memory_source_t& memsrc) : memsource_{memsrc} {}
+
+  ~NArrayStorage_() {
+    if (data_ && !is_inline()) {
+      memsource_.deallocate(data_, N_);
+    }
+  }
+
+  // keeps the placement: inline data stays inline
+  NArrayStorage_(const NArrayStorage_& other)
+    : memsource_{other.memsource_} {
+    if (!other.data_) { return; }
+    N_ = other.N_;
+    data_ = other.is_inline() ? buf() : memsource_.allocate(N_);
+    std::copy_n(other.data_, N_, data_);
+  }
+
+  NArrayStorage_(NArrayStorage_&& other) noexcept
+  : memsource_{other.memsource_}  { swap(*this, other); }
+
+  NArrayStorage_& operator=(NArrayStorage_ other) noexcept {
+    swap(*this, other);
+    return *this;
+  }
+
+  // heap buffers are exchanged, inline elements are copied
+  friend void swap(NArrayStorage_& lhs, NArrayStorage_& rhs) noexcept {
+    using std::swap;
+    swap(lhs.memsource_, rhs.memsource_);
+    const bool li = lhs.is_inline(), ri = rhs.is_inline();
+    if (!li && !ri) {
+      swap(lhs.data_, rhs.data_);
+    }
+    else {
+      T tmp[N];
+      T* ld = lhs.data_;
+      if (li) { std::copy_n(lhs.data_, lhs.N_, tmp); }
+      if (ri) { std::copy_n(rhs.data_, rhs.N_, lhs.buf()); }
+      lhs.data_ = ri ? lhs.buf() : rhs.data_;
+      if (li) { std::copy_n(tmp, lhs.N_, rhs.buf()); }
+      rhs.data_ = li ? rhs.buf() : ld;
+    }
+    swap(lhs.N_, rhs.N_);
+  }
+
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+  size_t size() const noexcept { return N_; }
+  bool is_inline() const noexcept { return data_ && data_ == buf(); }
+
+  void init(std::size_t n, size_t align = 0) {
+    N_ = n;
+    if (n <= N && align <= k_align) { data_ = buf(); }
+    else {
+      data_ = align > alignof(T) ? impl_storage::allocate_aligned<T>(memsource_, N_, align, 0)
+                                 : memsource_.allocate(N_);
+    }
+  }
+
+  bool extend(size_t nmin, size_t nmax) noexcept {
+    if (!is_inline()) { return impl_storage::extend(memsource_, data_, &N_, nmin, nmax, 0); }
+    if (nmin > N) { return false; }
+    N_ = std::min(nmax, N);
+    return true;
+  }
+
+ private:
+  T* buf() noexcept { return reinterpret_cast<T*>(buf_); }
+  const T* buf() const noexcept { return reinterpret_cast<const T*>(buf_); }
+
+ public:
+  memory_source_t memsource_;
+  T* data_ = nullptr;
+  size_t N_ = 0;
+
+ private:
+  alignas(k_align) unsigned char buf_[N * sizeof(T)];
+};
+
+
+// Row pitch of NArray_ in bytes: every row (the least-stride dim) starts at
+// a multiple of `bytes`, e.g. Pitch{64} for cache-line/AVX-512 aligned rows.
+// Power of two and a multiple of sizeof(T), 0 - dense.
+struct Pitch {
+  size_t bytes = 0;
+};
+
+
 template<typename T, size_t ND, class MemSourceT, MOrder MOrderT = MOrder::C, typename IntT = size_t>
 struct NArray_ : public NArrayInterface_<NArray_<T, ND, MemSourceT, MOrderT, IntT>, T, ND, MOrderT, IntT>
 {
@@ -1155,21 +1471,182 @@ struct NArray_ : public NArrayInterface_<NArray_<T, ND, MemSourceT, MOrderT, Int
     ptr_ = storage_.data();
   }
 
-  NArray_(const NArray_& ) = default;
-  NArray_(NArray_&& other) : storage_{storage_} { swap(*this, other); }
-  NArray_& operator=(NArray_ other) { swap(*this, other); return *this; }
+  // padded rows: strides reflect the pitch, only logical elements are
+  // visible to iterators, views and serialization
+  template<bool HDC = k_has_default_constructor, typename std::enable_if<HDC, int>::type = 0>
+  NArray_(index_t shape, Pitch pitch) : NArray_(shape, pitch, MemSourceT{}) { }
+
+  NArray_(index_t shape, Pitch pitch, const MemSourceT& memsrs)
+    : storage_{memsrs}, pitch_{pitch.bytes} {
+    if (pitch_ % sizeof(T) != 0 || (pitch_ & (pitch_ - 1)) != 0) {
+      throw ShapeError("xmat::NArray_: pitch must be a power of two multiple of sizeof(T)");
+    }
+    ravel_.shape = shape;
+    hidx::stride_pitched<MOrderT>(shape.cbegin(), ravel_.stride.begin(), ND,
+                                  pitch_ ? pitch_ / sizeof(T) : 1);
+    storage_.init(span() + slack(), pitch_);
+    ptr_ = align(storage_.data());
+  }
+
+  NArray_(const NArray_& other)
+    : storage_{other.storage_.memsource_}, ravel_{other.ravel_}, pitch_{other.pitch_} {
+    if (!other.ptr_) { return; }
+    storage_.init(other.storage_.size(), pitch_);
+    ptr_ = align(storage_.data());
+    std::copy_n(other.ptr_, span(), ptr_);
+  }
+
+  NArray_(NArray_&& other) noexcept : storage_{other.storage_.memsource_} { swap(*this, other); }
+  NArray_& operator=(NArray_ other) noexcept { swap(*this, other); return *this; }
   
+  // ptr_ follows the storage: inline elements of SmallBuffer are copied
   friend void swap(NArray_& lhs, NArray_& rhs) noexcept {
     using std::swap;
     swap(lhs.storage_, rhs.storage_);
-    swap(lhs.ptr_, rhs.ptr_);
     swap(lhs.ravel_, rhs.ravel_);
+    swap(lhs.pitch_, rhs.pitch_);
+    lhs.ptr_ = lhs.align(lhs.storage_.data());
+    rhs.ptr_ = rhs.align(rhs.storage_.data());
+  }
+
+  // row alignment in bytes, 0 - dense
+  size_t pitch() const noexcept { return pitch_; }
+
+  // Growth along the outer (largest stride) dim: rows of C-order [N, channels],
+  // columns of F-order [channels, N]. Strides do not depend on the outer extent,
+  // so the data stays in place if the memory source can extend the buffer
+  // (MemorySourceBase arenas), otherwise it is reallocated and copied.
+  // Views and pointers into the array are invalidated by a reallocation.
+  //   xmat::NArray<float, 2> acc{{0, 8}};
+  //   acc.append_rows(block);  // block: [n, 8]
+
+  // outer slices the buffer holds
+  size_t capacity() const noexcept {
+    const size_t s = outer_stride();
+    if (!ptr_ || !s) { return 0; }
+    return (storage_.size() - static_cast<size_t>(ptr_ - storage_.data())) / s;
+  }
+
+  // room for `n` outer slices, exact
+  void reserve(size_t n) { reserve_(n, n); }
+
+  // outer extent `n`, new elements are T{}
+  void resize(size_t n) {
+    const size_t hi = hidx::morderhidhi(MOrderT, ND);
+    const size_t m = ravel_.shape[hi];
+    if (n > m) {
+      grow(n);
+      const size_t s = outer_stride();
+      std::fill(ptr_ + m * s, ptr_ + n * s, T{});
+    }
+    ravel_.shape[hi] = n;
+  }
+
+  // appends `rows` along the outer dim, the other dims must match; an array
+  // with no elements takes the shape of `rows`. `rows` must not alias *this.
+  template<class D, typename T_, typename IntT_>
+  void append_rows(const NArrayInterface_<D, T_, ND, MOrderT, IntT_>& rows) {
+    const size_t hi = hidx::morderhidhi(MOrderT, ND);
+    const size_t m = ravel_.shape[hi], k = rows.shape()[hi];
+    size_t inner = 1;
+    for (size_t i = 0; i < ND; ++i) { inner *= i != hi ? ravel_.shape[i] : 1; }
+    if (!m && (!inner || !outer_stride())) {
+      adopt(rows.shape());
+    }
+    for (size_t i = 0; i < ND; ++i) {
+      if (i != hi && ravel_.shape[i] != rows.shape()[i]) {
+        throw ShapeError("xmat::NArray_::append_rows: shape mismatch");
+      }
+    }
+    if (!k) { return; }
+    grow(m + k);
+    ravel_t tail = ravel_;
+    tail.shape[hi] = k;
+    View_<T, ND, MOrderT, IntT> dst{ptr_ + m * outer_stride(), tail};
+    if (std::is_same<T, T_>::value && is_dense(tail) && same_strides(tail.stride, rows.stride())) {
+      std::copy_n(rows.ptr(), tail.numel(), dst.ptr());
+    }
+    else {
+      std::copy(rows.fbegin(), rows.fend(), dst.fbegin());
+    }
+    ravel_.shape[hi] = m + k;
+  }
+
+ private:
+  size_t outer_stride() const noexcept {
+    return static_cast<size_t>(ravel_.stride[hidx::morderhidhi(MOrderT, ND)]);
+  }
+
+  template<class S1, class S2>
+  static bool same_strides(const S1& a, const S2& b) noexcept {
+    return std::equal(a.begin(), a.end(), b.begin(),
+                      [](auto x, auto y) { return static_cast<ptrdiff_t>(x) == static_cast<ptrdiff_t>(y); });
+  }
+
+  static bool is_dense(const ravel_t& r) noexcept {
+    ravel_t d{r.shape};
+    return d.stride == r.stride;
+  }
+
+  // geometric: amortized O(1) appends
+  void grow(size_t n) {
+    const size_t c = capacity();
+    if (n > c) { reserve_(n, std::max(n, 2 * c)); }
+  }
+
+  // capacity for at least `n`, up to `nmax` outer slices
+  void reserve_(size_t n, size_t nmax) {
+    if (!outer_stride()) { restride(); }  // default-constructed: no strides yet
+    const size_t s = outer_stride();
+    if (n <= capacity() || !s) { return; }
+    if (ptr_) {
+      const size_t off = static_cast<size_t>(ptr_ - storage_.data());
+      if (storage_.extend(off + n * s, off + nmax * s)) { return; }
+    }
+    storage_t tmp{storage_.memsource_};
+    tmp.init(nmax * s + slack(), pitch_);
+    if (ptr_) { std::copy_n(ptr_, span(), align(tmp.data())); }
+    swap(storage_, tmp);
+    ptr_ = align(storage_.data());
+  }
+
+  // empty array: inner dims and strides from `shape`, the outer extent 0
+  void adopt(index_t shape) {
+    shape[hidx::morderhidhi(MOrderT, ND)] = 0;
+    ravel_.shape = shape;
+    restride();
+  }
+
+  // strides from the shape, the outer extent doesn't matter
+  void restride() {
+    hidx::stride_pitched<MOrderT>(ravel_.shape.cbegin(), ravel_.stride.begin(), ND,
+                                  pitch_ ? pitch_ / sizeof(T) : 1);
+  }
+
+  // elements spanned by the rows, including padding
+  size_t span() const noexcept {
+    const size_t hi = hidx::morderhidhi(MOrderT, ND);
+    return static_cast<size_t>(ravel_.stride[hi]) * ravel_.shape[hi];
+  }
+
+  size_t slack() const noexcept { return pitch_ > alignof(T) ? pitch_ / sizeof(T) - 1 : 0; }
+
+  // the first element on a pitch boundary, whole elements away from `p`
+  T* align(T* p) const {
+    if (!p || pitch_ <= alignof(T)) { return p; }
+    const uintptr_t a = reinterpret_cast<uintptr_t>(p);
+    const size_t d = static_cast<size_t>(align_up(a, pitch_) - a);
+    if (d % sizeof(T) != 0) {
+      throw ShapeError("xmat::NArray_: storage can't be aligned to the pitch");
+    }
+    return p + d / sizeof(T);
   }
 
  public:
   storage_t storage_;
   T* ptr_ = nullptr;
   ravel_t ravel_;
+  size_t pitch_ = 0;
 };
 
 template<typename T, size_t ND, class MemSourceT, MOrder MOrderT, typename IntT>
@@ -1198,6 +1675,13 @@ using NArrayGMS = NArray_<T, ND, AllocatorMSGlobal<T, Aln>, MOrder::C, size_t>;
 template<typename T, size_t ND, size_t Aln = alignof(T)>
 using NArrayGMSxF = NArray_<T, ND, AllocatorMSGlobal<T, Aln>, MOrder::F, size_t>;
 
+// global thread-safe memory source
+template<typename T, size_t ND, size_t Aln = alignof(T)>
+using NArrayGMT = NArray_<T, ND, AllocatorMSGlobalMT<T, Aln>, MOrder::C, size_t>;
+
+template<typename T, size_t ND, size_t Aln = alignof(T)>
+using NArrayGMTxF = NArray_<T, ND, AllocatorMSGlobalMT<T, Aln>, MOrder::F, size_t>;
+
 // specific memory source
 template<typename T, size_t ND, size_t Aln = alignof(T)>
 using NArrayMS = NArray_<T, ND, AllocatorMSRef<T, Aln>, MOrder::C, size_t>;
@@ -1205,6 +1689,146 @@ using NArrayMS = NArray_<T, ND, AllocatorMSRef<T, Aln>, MOrder::C, size_t>;
 template<typename T, size_t ND, size_t Aln = alignof(T)>
 using NArrayMSxF = NArray_<T, ND, AllocatorMSRef<T, Aln>, MOrder::C, size_t>;
 
+// size-class pool memory source, thread-safe
+template<typename T, size_t ND, size_t Aln = alignof(T)>
+using NArrayPMS = NArray_<T, ND, AllocatorMSPool<T, Aln>, MOrder::C, size_t>;
+
+template<typename T, size_t ND, size_t Aln = alignof(T)>
+using NArrayPMSxF = NArray_<T, ND, AllocatorMSPool<T, Aln>, MOrder::F, size_t>;
+
+// specific memory source, LIFO deallocation
+template<typename T, size_t ND, size_t Aln = alignof(T)>
+using NArraySMS = NArray_<T, ND, AllocatorMSStack<T, Aln>, MOrder::C, size_t>;
+
+template<typename T, size_t ND, size_t Aln = alignof(T)>
+using NArraySMSxF = NArray_<T, ND, AllocatorMSStack<T, Aln>, MOrder::F, size_t>;
+
+// up to N elements inline, larger arrays from std::allocator
+template<typename T, size_t ND, size_t N>
+using NArraySmall = NArray_<T, ND, SmallBuffer<std::allocator<T>, N>, MOrder::C, size_t>;
+
+template<typename T, size_t ND, size_t N>
+using NArraySmallxF = NArray_<T, ND, SmallBuffer<std::allocator<T>, N>, MOrder::F, size_t>;
+
+
+// ------------------------------------------------------------
+// Fixed-shape array
+// ------------------------------------------------------------
+// Shape known at compile time, elements stored inline:
+//
+//   xmat::NArrayFixed<std::complex<float>, 2, 2> h;
+//   h.at(1, 0) = 1.0f;                // constant offset: ptr_[2]
+//
+// Ravel_ is shared by all arrays of the type, so views, iterators, printing
+// and serialization work as for NArray_.
+template<MOrder MOrderT, size_t ... Shape>
+struct FixedRavel_ {
+  static constexpr size_t ndim = sizeof...(Shape);
+
+  static constexpr size_t shape(size_t n) noexcept {
+    constexpr size_t s[] = {Shape...};
+    return s[n];
+  }
+
+  static constexpr size_t numel() noexcept {
+    size_t out = 1;
+    for (size_t n = 0; n < ndim; ++n) { out *= shape(n); }
+    return out;
+  }
+
+  static constexpr size_t stride(size_t n) noexcept {
+    size_t out = 1;
+    if (MOrderT == MOrder::C) { for (size_t k = n + 1; k < ndim; ++k) { out *= shape(k); } }
+    else { for (size_t k = 0; k < n; ++k) { out *= shape(k); } }
+    return out;
+  }
+
+  template<typename ... Args>
+  static constexpr size_t at(Args ... args) noexcept {
+    const size_t i[] = {static_cast<size_t>(args)...};
+    size_t out = 0;
+    for (size_t n = 0; n < ndim; ++n) { out += i[n] * stride(n); }
+    return out;
+  }
+
+  template<typename IntT>
+  static Ravel_<ndim, MOrderT, IntT> ravel() noexcept {
+    Index_<IntT, ndim> s;
+    for (size_t n = 0; n < ndim; ++n) { s[n] = static_cast<IntT>(shape(n)); }
+    return {s};
+  }
+};
+
+
+template<typename T, MOrder MOrderT, size_t ... Shape>
+struct NArrayFixed_ : public NArrayInterface_<NArrayFixed_<T, MOrderT, Shape...>, 
+                                              T, sizeof...(Shape), MOrderT, size_t>
+{
+  static_assert(sizeof...(Shape) > 0, "xmat::NArrayFixed_: at least one dim");
+
+  using this_t = NArrayFixed_<T, MOrderT, Shape...>;
+  using base_t = NArrayInterface_<this_t, T, sizeof...(Shape), MOrderT, size_t>;
+  using typename base_t::value_type;
+  using typename base_t::ravel_t;
+  using typename base_t::index_t;
+  using typename base_t::increment_t;
+  using typename base_t::fiterator_t;
+  using typename base_t::witerator_t;
+  using base_t::ndim;
+
+  using fixed_ravel_t = FixedRavel_<MOrderT, Shape...>;
+  static constexpr size_t k_numel = fixed_ravel_t::numel();
+
+  // elements are not initialized, as in std::array
+  NArrayFixed_() = default;
+
+  NArrayFixed_(std::initializer_list<T> x) noexcept {
+    assert(x.size() <= k_numel);
+    std::copy_n(x.begin(), std::min(x.size(), k_numel), ptr_);
+  }
+
+  // constant-offset access, hides NArrayInterface_::at()
+  template<typename ... Args>
+  std::enable_if_t<AllNType<ndim, size_t, Args...>::value, T&>
+  at(Args ... args) noexcept { return ptr_[fixed_ravel_t::at(args...)]; }
+
+  template<typename ... Args>
+  std::enable_if_t<AllNType<ndim, size_t, Args...>::value, const T&>
+  at(Args ... args) const noexcept { return ptr_[fixed_ravel_t::at(args...)]; }
+
+  T& at(const index_t& i) noexcept { return base_t::at(i); }
+
+  const T& at(const index_t& i) const noexcept { return base_t::at(i); }
+
+  static constexpr size_t numel() noexcept { return k_numel; }
+
+ public:
+  T ptr_[k_numel];             // decays to T* for NArrayInterface_::ptr()
+  static const ravel_t ravel_;
+};
+
+template<typename T, MOrder MOrderT, size_t ... Shape>
+constexpr size_t NArrayFixed_<T, MOrderT, Shape...>::k_numel;
+
+template<typename T, MOrder MOrderT, size_t ... Shape>
+const typename NArrayFixed_<T, MOrderT, Shape...>::ravel_t NArrayFixed_<T, MOrderT, Shape...>::ravel_
+  = FixedRavel_<MOrderT, Shape...>::template ravel<size_t>();
+
+template<typename T, MOrder MOrderT, size_t ... Shape>
+struct ViewForNarray<NArrayFixed_<T, MOrderT, Shape...>> {
+  template<size_t ND_, typename IntT_> 
+  using view_t = View_<T, ND_, MOrderT, IntT_>;
+
+  template<size_t ND_, typename IntT_> 
+  using viterator_t = VIterator_<T, ND_, MOrderT, IntT_>;
+};
+
+template<typename T, size_t ... Shape>
+using NArrayFixed = NArrayFixed_<T, MOrder::C, Shape...>;
+
+template<typename T, size_t ... Shape>
+using NArrayFixedxF = NArrayFixed_<T, MOrder::F, Shape...>;
+
 
 // print
 //------
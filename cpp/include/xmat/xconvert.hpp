@@ -0,0 +1,364 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+
+#include <array>
+#include <complex>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XMAT_CONVERT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Element type conversion
+// ------------------------------------------------------------
+//   xmat::astype(y, iq, 1.0 / 32768);              // complex<int16_t> -> complex<float>
+//   xmat::astype(q, y, 32767.0);                   // float -> int16_t, saturating
+//   auto z = xmat::astype<float>(x, 0.5, -1.0);    // new NArray_<float, ND>
+//
+// Every component: y = x * scale + offset (for complex both re and im),
+// real -> complex sets im = 0, complex -> real is not allowed. Integer
+// results are rounded to nearest and saturated, NaN gives 0.
+//
+// The arithmetic is float unless a side is double or a wide integer
+// without float on the other side. Contiguous runs of int8, uint8, int16,
+// uint16, int32, float and double go through SSE2 kernels, complex types
+// as interleaved components. Fused with loading: IMapStream iterator's
+// get_to(y, scale, offset), serial::LoadTo<array>::load(..., scale, offset).
+namespace impl_convert {
+
+template<typename T> struct component { using type = T; static constexpr size_t size = 1; };
+template<typename R> struct component<std::complex<R>> { using type = R; static constexpr size_t size = 2; };
+
+template<typename T> using component_t = typename component<T>::type;
+
+template<typename T> constexpr bool is_complex() noexcept { return component<T>::size == 2; }
+
+// complex -> real drops the imaginary part: refused
+template<typename U, typename T>
+constexpr bool convertible() noexcept { return is_complex<U>() || !is_complex<T>(); }
+
+template<typename T>
+constexpr bool is_wide() noexcept {
+  return std::is_same<T, double>::value || (std::is_integral<T>::value && sizeof(T) >= 4);
+}
+
+// arithmetic type of a component conversion T -> U
+template<typename U, typename T>
+using compute_t = std::conditional_t<
+  std::is_same<T, double>::value || std::is_same<U, double>::value ||
+  (is_wide<T>() && !std::is_same<U, float>::value) || (is_wide<U>() && !std::is_same<T, float>::value),
+  double, float>;
+
+// rounded and saturated
+template<typename U, typename C, typename std::enable_if_t<std::is_integral<U>::value, int> = 0>
+U cast(C v) noexcept {
+  constexpr U umin = std::numeric_limits<U>::min(), umax = std::numeric_limits<U>::max();
+  if (!(v > static_cast<C>(umin))) { return v != v ? U{0} : umin; }
+  if (!(v < static_cast<C>(umax))) { return umax; }
+  return static_cast<U>(std::nearbyint(v));
+}
+
+template<typename U, typename C, typename std::enable_if_t<!std::is_integral<U>::value, int> = 0>
+U cast(C v) noexcept { return static_cast<U>(v); }
+
+
+#if defined(XMAT_CONVERT_SSE2)
+// 16 components in registers of the compute type C: load() widens and
+// converts, store() narrows with saturation
+template<typename T, typename C> struct Simd { static constexpr bool enabled = false; };
+
+template<typename T>
+struct SimdF {
+  static constexpr bool enabled = true;
+  using reg_t = __m128;
+  static constexpr size_t nreg = 4;
+};
+
+template<typename T>
+struct SimdD {
+  static constexpr bool enabled = true;
+  using reg_t = __m128d;
+  static constexpr size_t nreg = 8;
+};
+
+template<> struct Simd<float, float> : SimdF<float> {
+  static void load(const float* p, __m128* v) noexcept {
+    for (size_t k = 0; k < 4; ++k) { v[k] = _mm_loadu_ps(p + 4 * k); }
+  }
+  static void store(float* p, const __m128* v) noexcept {
+    for (size_t k = 0; k < 4; ++k) { _mm_storeu_ps(p + 4 * k, v[k]); }
+  }
+};
+
+template<> struct Simd<std::int32_t, float> : SimdF<std::int32_t> {
+  static void load(const std::int32_t* p, __m128* v) noexcept {
+    for (size_t k = 0; k < 4; ++k) {
+      v[k] = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4 * k)));
+    }
+  }
+  static void store(std::int32_t* p, const __m128* v) noexcept {
+    // >= 2^31 converts to 0x80000000, flipped to 0x7fffffff
+    const __m128 lo = _mm_set1_ps(-2147483648.f), hi = _mm_set1_ps(2147483648.f);
+    for (size_t k = 0; k < 4; ++k) {
+      const __m128 x = _mm_and_ps(v[k], _mm_cmpord_ps(v[k], v[k]));  // NaN -> 0
+      const __m128i over = _mm_castps_si128(_mm_cmpge_ps(x, hi));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 4 * k), _mm_xor_si128(_mm_cvtps_epi32(_mm_max_ps(x, lo)), over));
+    }
+  }
+};
+
+// int32 lanes rounded from floats clamped to [lo, hi]
+inline void to_i32(const __m128* v, __m128i* q, float lo, float hi) noexcept {
+  const __m128 l = _mm_set1_ps(lo), h = _mm_set1_ps(hi);
+  for (size_t k = 0; k < 4; ++k) {
+    const __m128 x = _mm_and_ps(v[k], _mm_cmpord_ps(v[k], v[k]));
+    q[k] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(x, l), h));
+  }
+}
+
+template<> struct Simd<std::int16_t, float> : SimdF<std::int16_t> {
+  static void load(const std::int16_t* p, __m128* v) noexcept {
+    for (size_t k = 0; k < 2; ++k) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8 * k));
+      v[2 * k] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+      v[2 * k + 1] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+    }
+  }
+  static void store(std::int16_t* p, const __m128* v) noexcept {
+    __m128i q[4];
+    to_i32(v, q, -32768.f, 32767.f);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(q[0], q[1]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 8), _mm_packs_epi32(q[2], q[3]));
+  }
+};
+
+template<> struct Simd<std::uint16_t, float> : SimdF<std::uint16_t> {
+  static void load(const std::uint16_t* p, __m128* v) noexcept {
+    const __m128i z = _mm_setzero_si128();
+    for (size_t k = 0; k < 2; ++k) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8 * k));
+      v[2 * k] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(x, z));
+      v[2 * k + 1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(x, z));
+    }
+  }
+  // no unsigned 32 -> 16 pack in SSE2: shift to the signed range and back
+  static void store(std::uint16_t* p, const __m128* v) noexcept {
+    __m128i q[4];
+    to_i32(v, q, 0.f, 65535.f);
+    const __m128i b32 = _mm_set1_epi32(32768), b16 = _mm_set1_epi16(-32768);
+    for (size_t k = 0; k < 4; ++k) { q[k] = _mm_sub_epi32(q[k], b32); }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_xor_si128(_mm_packs_epi32(q[0], q[1]), b16));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 8), _mm_xor_si128(_mm_packs_epi32(q[2], q[3]), b16));
+  }
+};
+
+template<> struct Simd<std::int8_t, float> : SimdF<std::int8_t> {
+  static void load(const std::int8_t* p, __m128* v) noexcept {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i l = _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8), h = _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+    v[0] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(l, l), 16));
+    v[1] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(l, l), 16));
+    v[2] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(h, h), 16));
+    v[3] = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(h, h), 16));
+  }
+  static void store(std::int8_t* p, const __m128* v) noexcept {
+    __m128i q[4];
+    to_i32(v, q, -128.f, 127.f);
+    const __m128i w = _mm_packs_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), w);
+  }
+};
+
+template<> struct Simd<std::uint8_t, float> : SimdF<std::uint8_t> {
+  static void load(const std::uint8_t* p, __m128* v) noexcept {
+    const __m128i z = _mm_setzero_si128();
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i l = _mm_unpacklo_epi8(x, z), h = _mm_unpackhi_epi8(x, z);
+    v[0] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(l, z));
+    v[1] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(l, z));
+    v[2] = _mm_cvtepi32_ps(_mm_unpacklo_epi16(h, z));
+    v[3] = _mm_cvtepi32_ps(_mm_unpackhi_epi16(h, z));
+  }
+  static void store(std::uint8_t* p, const __m128* v) noexcept {
+    __m128i q[4];
+    to_i32(v, q, 0.f, 255.f);
+    const __m128i w = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]), _mm_packs_epi32(q[2], q[3]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(p), w);
+  }
+};
+
+template<> struct Simd<double, double> : SimdD<double> {
+  static void load(const double* p, __m128d* v) noexcept {
+    for (size_t k = 0; k < 8; ++k) { v[k] = _mm_loadu_pd(p + 2 * k); }
+  }
+  static void store(double* p, const __m128d* v) noexcept {
+    for (size_t k = 0; k < 8; ++k) { _mm_storeu_pd(p + 2 * k, v[k]); }
+  }
+};
+
+template<> struct Simd<float, double> : SimdD<float> {
+  static void load(const float* p, __m128d* v) noexcept {
+    for (size_t k = 0; k < 4; ++k) {
+      const __m128 x = _mm_loadu_ps(p + 4 * k);
+      v[2 * k] = _mm_cvtps_pd(x);
+      v[2 * k + 1] = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+    }
+  }
+  static void store(float* p, const __m128d* v) noexcept {
+    for (size_t k = 0; k < 4; ++k) {
+      _mm_storeu_ps(p + 4 * k, _mm_movelh_ps(_mm_cvtpd_ps(v[2 * k]), _mm_cvtpd_ps(v[2 * k + 1])));
+    }
+  }
+};
+
+template<> struct Simd<std::int32_t, double> : SimdD<std::int32_t> {
+  static void load(const std::int32_t* p, __m128d* v) noexcept {
+    for (size_t k = 0; k < 4; ++k) {
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4 * k));
+      v[2 * k] = _mm_cvtepi32_pd(x);
+      v[2 * k + 1] = _mm_cvtepi32_pd(_mm_unpackhi_epi64(x, x));
+    }
+  }
+  static void store(std::int32_t* p, const __m128d* v) noexcept {
+    const __m128d lo = _mm_set1_pd(-2147483648.0), hi = _mm_set1_pd(2147483647.0);
+    for (size_t k = 0; k < 4; ++k) {
+      __m128d a = v[2 * k], b = v[2 * k + 1];
+      a = _mm_min_pd(_mm_max_pd(_mm_and_pd(a, _mm_cmpord_pd(a, a)), lo), hi);
+      b = _mm_min_pd(_mm_max_pd(_mm_and_pd(b, _mm_cmpord_pd(b, b)), lo), hi);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 4 * k),
+                       _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b)));
+    }
+  }
+};
+
+inline __m128 madd(__m128 x, __m128 a, __m128 b) noexcept { return _mm_add_ps(_mm_mul_ps(x, a), b); }
+inline __m128d madd(__m128d x, __m128d a, __m128d b) noexcept { return _mm_add_pd(_mm_mul_pd(x, a), b); }
+inline __m128 set1(float x) noexcept { return _mm_set1_ps(x); }
+inline __m128d set1(double x) noexcept { return _mm_set1_pd(x); }
+
+// converts the first n - n % 16 components, returns their count
+template<typename U, typename T, typename C>
+size_t run_simd(U* d, const T* s, size_t n, C scale, C offset, std::true_type) noexcept {
+  using reg_t = typename Simd<T, C>::reg_t;
+  constexpr size_t nreg = Simd<T, C>::nreg;
+  const reg_t a = set1(scale), b = set1(offset);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    reg_t v[nreg];
+    Simd<T, C>::load(s + i, v);
+    for (size_t k = 0; k < nreg; ++k) { v[k] = madd(v[k], a, b); }
+    Simd<U, C>::store(d + i, v);
+  }
+  return i;
+}
+
+template<typename U, typename T, typename C>
+size_t run_simd(U*, const T*, size_t, C, C, std::false_type) noexcept { return 0; }
+#endif
+
+// n components with strides
+template<typename U, typename T>
+void run(U* d, ptrdiff_t ds, const T* s, ptrdiff_t ss, size_t n, double scale, double offset) noexcept {
+  using C = compute_t<U, T>;
+  const C a = static_cast<C>(scale), b = static_cast<C>(offset);
+  size_t i = 0;
+  if (ds == 1 && ss == 1) {
+    if (std::is_same<U, T>::value && scale == 1 && offset == 0) {
+      std::copy_n(s, n, d);
+      return;
+    }
+#if defined(XMAT_CONVERT_SSE2)
+    using simd_t = std::integral_constant<bool, Simd<T, C>::enabled && Simd<U, C>::enabled>;
+    i = run_simd(d, s, n, a, b, simd_t{});
+#endif
+  }
+  for (; i < n; ++i) { d[i * ds] = cast<U>(static_cast<C>(s[i * ss]) * a + b); }
+}
+
+// n elements with strides in elements
+template<typename U, typename T, typename std::enable_if_t<is_complex<U>() == is_complex<T>(), int> = 0>
+void convert(U* d, ptrdiff_t ds, const T* s, ptrdiff_t ss, size_t n, double scale, double offset) noexcept {
+  constexpr ptrdiff_t m = component<T>::size;
+  auto* dc = reinterpret_cast<component_t<U>*>(d);
+  auto* sc = reinterpret_cast<const component_t<T>*>(s);
+  if (ds == 1 && ss == 1) {
+    run(dc, 1, sc, 1, n * m, scale, offset);
+    return;
+  }
+  for (ptrdiff_t k = 0; k < m; ++k) { run(dc + k, ds * m, sc + k, ss * m, n, scale, offset); }
+}
+
+// real -> complex
+template<typename U, typename T, typename std::enable_if_t<is_complex<U>() && !is_complex<T>(), int> = 0>
+void convert(U* d, ptrdiff_t ds, const T* s, ptrdiff_t ss, size_t n, double scale, double offset) noexcept {
+  using R = component_t<U>;
+  auto* dc = reinterpret_cast<R*>(d);
+  run(dc, 2 * ds, s, ss, n, scale, offset);
+  for (size_t i = 0; i < n; ++i) { dc[2 * i * ds + 1] = R{0}; }
+}
+
+// calls f(dst offset, src offset) for every run along the least-stride
+// dim of dst
+template<MOrder MOrderT, class D, class S, typename F>
+void for_runs(const D& dst, const S& src, F&& f) {
+  constexpr size_t ND = D::ndim;
+  if (!dst.numel()) { return; }
+  std::array<size_t, ND> index{};
+  do {
+    f(hidx::conv(index.data(), dst.stride().begin(), ND, ptrdiff_t{0}),
+      hidx::conv(index.data(), src.stride().begin(), ND, ptrdiff_t{0}));
+  } while (hidx::next_outer<MOrderT>(index.data(), dst.shape().begin(), ND, 1));
+}
+
+template<class D0, typename U, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void astype(NArrayInterface_<D0, U, ND, MOrderT0, IntT0>& dst, const S& src, double scale, double offset) {
+  using T = typename S::value_type;
+  static_assert(S::ndim == ND, "xmat::astype: ndim mismatch");
+  static_assert(convertible<U, T>(), "xmat::astype: complex -> real is not allowed");
+  if (!std::equal(dst.shape().begin(), dst.shape().end(), src.shape().begin(),
+                  [](auto a, auto b) { return static_cast<size_t>(a) == static_cast<size_t>(b); })) {
+    throw ShapeError("xmat::astype: shape mismatch");
+  }
+  const size_t lo = hidx::morderlowi(MOrderT0, ND);
+  const size_t n = dst.shape()[lo];
+  const ptrdiff_t ds = dst.stride()[lo], ss = src.stride()[lo];
+  U* d = dst.ptr();
+  const T* s = src.ptr();
+  for_runs<MOrderT0>(dst, src, [&](ptrdiff_t od, ptrdiff_t os) { convert(d + od, ds, s + os, ss, n, scale, offset); });
+}
+} // namespace impl_convert
+
+
+// dst = src * scale + offset, dst and src of the same shape, any strides
+template<class D0, typename U, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void astype(NArrayInterface_<D0, U, ND, MOrderT0, IntT0>& dst, const S& src, double scale = 1, double offset = 0) {
+  impl_convert::astype(dst, src, scale, offset);
+}
+
+template<class D0, typename U, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void astype(NArrayInterface_<D0, U, ND, MOrderT0, IntT0>&& dst, const S& src, double scale = 1, double offset = 0) {
+  impl_convert::astype(dst, src, scale, offset);
+}
+
+// new array of U, the memory order of src
+template<typename U, class D, typename T, size_t ND, MOrder MOrderT, typename IntT>
+NArray_<U, ND, std::allocator<U>, MOrderT, IntT>
+astype(const NArrayInterface_<D, T, ND, MOrderT, IntT>& src, double scale = 1, double offset = 0) {
+  NArray_<U, ND, std::allocator<U>, MOrderT, IntT> out{src.shape()};
+  impl_convert::astype(out, src, scale, offset);
+  return out;
+}
+} // namespace xmat
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XMAT_COPY_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Strided and layout-changing copy
+// ------------------------------------------------------------
+// assign(dst, src) walks a loop nest built from the strides of both
+// operands: dims are ordered by destination stride, jointly contiguous
+// dims are merged into one run, unit-stride runs are copied by memmove and
+// broadcast (stride 0) runs by fill. When the memory of dst and src
+// overlaps (shifted views of one array) src is first copied to a temporary.
+//
+// copy_to(dst, src) copies elements with the same logical index. When the
+// most data-local dims of dst and src differ (C <-> F conversion, permuted
+// views) one of the sides is always accessed with a large stride; the copy
+// is then done as a tiled 2D transpose of those two dims, for each position
+// of the remaining dims:
+//
+//   xmat::NArrayxF<float, 2> f({1024, 512});
+//   xmat::NArray<float, 2> c({1024, 512}), t({512, 1024});
+//   xmat::copy_to(c, f);                    // C <- F
+//   xmat::copy_to(t, c.permute({1, 0}));    // t := transpose(c)
+//
+// Tiles of 4-byte and 8-byte elements are transposed in SSE registers.
+namespace impl_copy {
+
+constexpr size_t k_tile = 32;
+
+// most data-local dim: least non-zero stride among dims with shape > 1, ND if none
+template<typename IntT, size_t ND>
+size_t localdim(const Index_<IntT, ND>& shape, const Index_<IntT, ND>& stride) noexcept {
+  size_t d = ND;
+  for (size_t n = 0; n < ND; ++n) {
+    if (shape[n] > 1 && stride[n] != 0 && (d == ND || stride[n] < stride[d])) { d = n; }
+  }
+  return d;
+}
+
+
+// Loop nest of assign(dst, src), innermost dim first: size-1 dims dropped,
+// dims sorted by destination stride, jointly contiguous dims merged.
+// Broadcast source dims have stride 0.
+template<size_t ND>
+struct Nest {
+  size_t ndim = 0;
+  size_t shape[ND + 1];
+  ptrdiff_t dstride[ND + 1];
+  ptrdiff_t sstride[ND + 1];
+};
+
+template<typename IntT0, typename IntT1, size_t ND>
+Nest<ND> nest(const Index_<IntT0, ND>& shape, const Index_<IntT0, ND>& dstride,
+              const Index_<IntT1, ND>& sshape, const Index_<IntT1, ND>& sstride) noexcept {
+  Nest<ND> q;
+  for (size_t n = 0; n < ND; ++n) {
+    if (shape[n] == 1) { continue; }
+    // insertion by (destination stride, source stride)
+    const ptrdiff_t ds = static_cast<ptrdiff_t>(dstride[n]);
+    const ptrdiff_t ss = sshape[n] == 1 ? 0 : static_cast<ptrdiff_t>(sstride[n]);
+    size_t k = q.ndim++;
+    for (; k > 0; --k) {
+      const ptrdiff_t ds0 = q.dstride[k-1], ss0 = q.sstride[k-1];
+      if (ds0 < ds || (ds0 == ds && ss0 <= ss)) { break; }
+      q.shape[k] = q.shape[k-1];
+      q.dstride[k] = ds0;
+      q.sstride[k] = ss0;
+    }
+    q.shape[k] = static_cast<size_t>(shape[n]);
+    q.dstride[k] = ds;
+    q.sstride[k] = ss;
+  }
+
+  // scalar
+  if (q.ndim == 0) {
+    q.ndim = 1;
+    q.shape[0] = 1;
+    q.dstride[0] = q.sstride[0] = 0;
+    return q;
+  }
+
+  size_t m = 0;
+  for (size_t k = 1; k < q.ndim; ++k) {
+    const ptrdiff_t len = static_cast<ptrdiff_t>(q.shape[m]);
+    if (q.dstride[k] == q.dstride[m] * len && q.sstride[k] == q.sstride[m] * len) {
+      q.shape[m] *= q.shape[k];
+    }
+    else {
+      ++m;
+      q.shape[m] = q.shape[k];
+      q.dstride[m] = q.dstride[k];
+      q.sstride[m] = q.sstride[k];
+    }
+  }
+  q.ndim = m + 1;
+  return q;
+}
+
+
+// inner run: memmove, fill or strided loop
+template<typename T0, typename T1>
+void run(T0* d, ptrdiff_t ds, const T1* s, ptrdiff_t ss, size_t n, std::false_type) {
+  if (ss == 0) {
+    const T0 x = static_cast<T0>(*s);
+    if (ds == 1) { std::fill_n(d, n, x); }
+    else { for (size_t i = 0; i < n; ++i) { d[i * ds] = x; } }
+  }
+  else if (ds == 1 && ss == 1) {
+    for (size_t i = 0; i < n; ++i) { d[i] = static_cast<T0>(s[i]); }
+  }
+  else {
+    for (size_t i = 0; i < n; ++i) { d[i * ds] = static_cast<T0>(s[i * ss]); }
+  }
+}
+
+template<typename T0, typename T1>
+void run(T0* d, ptrdiff_t ds, const T1* s, ptrdiff_t ss, size_t n, std::true_type) noexcept {
+  if (ds == 1 && ss == 1) { std::memmove(d, s, n * sizeof(T0)); }  // views may overlap
+  else { run(d, ds, s, ss, n, std::false_type{}); }
+}
+
+template<typename T0, typename T1>
+using memcpyable = std::integral_constant<bool,
+  std::is_same<T0, std::remove_const_t<T1>>::value && std::is_trivially_copyable<T0>::value>;
+
+
+// bytes [first, second) spanned by the nest from p with strides st
+template<typename T, size_t ND>
+std::pair<uintptr_t, uintptr_t> span(const T* p, const ptrdiff_t* st, const Nest<ND>& q) noexcept {
+  ptrdiff_t lo = 0, hi = 0;
+  for (size_t k = 0; k < q.ndim; ++k) {
+    const ptrdiff_t e = st[k] * static_cast<ptrdiff_t>(q.shape[k] - 1);
+    (e < 0 ? lo : hi) += e;
+  }
+  const uintptr_t a = reinterpret_cast<uintptr_t>(p);
+  return {a - static_cast<uintptr_t>(-lo) * sizeof(T), a + static_cast<uintptr_t>(hi + 1) * sizeof(T)};
+}
+
+template<typename T0, typename T1, size_t ND>
+bool overlap(const T0* d, const T1* s, const Nest<ND>& q) noexcept {
+  const auto dr = span(d, q.dstride, q);
+  const auto sr = span(s, q.sstride, q);
+  return dr.first < sr.second && sr.first < dr.second;
+}
+
+
+// odometer over the outer dims of the nest, pointers moved by strides
+template<typename T0, typename T1, size_t ND>
+void assign(T0* d, const T1* s, const Nest<ND>& q) {
+  // self-assignment: same elements on both sides
+  if (memcpyable<T0, T1>::value && static_cast<const void*>(d) == static_cast<const void*>(s) &&
+      std::equal(q.dstride, q.dstride + q.ndim, q.sstride)) {
+    return;
+  }
+  // overlapping views: the forward loops would read already written
+  // elements, so src goes through a temporary laid out in nest order
+  if (overlap(d, s, q)) {
+    using U = std::remove_const_t<T1>;
+    Nest<ND> t = q;  // tmp := src
+    Nest<ND> u = q;  // dst := tmp
+    size_t n = 1;
+    for (size_t k = 0; k < q.ndim; ++k) {
+      t.dstride[k] = u.sstride[k] = static_cast<ptrdiff_t>(n);
+      n *= q.shape[k];
+    }
+    std::vector<U> tmp(n);
+    assign(tmp.data(), s, t);
+    assign(d, static_cast<const U*>(tmp.data()), u);
+    return;
+  }
+  size_t index[ND + 1] = {};
+  const size_t n0 = q.shape[0];
+  const ptrdiff_t ds0 = q.dstride[0], ss0 = q.sstride[0];
+  while (true) {
+    run(d, ds0, s, ss0, n0, memcpyable<T0, T1>{});
+    size_t k = 1;
+    for (; k < q.ndim; ++k) {
+      d += q.dstride[k];
+      s += q.sstride[k];
+      if (++index[k] < q.shape[k]) { break; }
+      d -= q.dstride[k] * static_cast<ptrdiff_t>(q.shape[k]);
+      s -= q.sstride[k] * static_cast<ptrdiff_t>(q.shape[k]);
+      index[k] = 0;
+    }
+    if (k == q.ndim) { break; }
+  }
+}
+
+
+// 4x4 / 2x2 block transposes, dst has unit stride along i, src along j
+// dst[j*dj + i] := src[i*si + j]
+template<size_t Size>
+struct Block {
+  static constexpr size_t n = 1;
+
+  template<typename T, typename IntT0, typename IntT1>
+  static void transpose(T* dst, IntT0, const T* src, IntT1) noexcept { *dst = *src; }
+};
+
+#if defined(XMAT_COPY_SSE2)
+template<>
+struct Block<4> {
+  static constexpr size_t n = 4;
+
+  template<typename T, typename IntT0, typename IntT1>
+  static void transpose(T* dst, IntT0 dj, const T* src, IntT1 si) noexcept {
+    const float* s = reinterpret_cast<const float*>(src);
+    float* d = reinterpret_cast<float*>(dst);
+    __m128 r0 = _mm_loadu_ps(s);
+    __m128 r1 = _mm_loadu_ps(s + si);
+    __m128 r2 = _mm_loadu_ps(s + 2*si);
+    __m128 r3 = _mm_loadu_ps(s + 3*si);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(d, r0);
+    _mm_storeu_ps(d + dj, r1);
+    _mm_storeu_ps(d + 2*dj, r2);
+    _mm_storeu_ps(d + 3*dj, r3);
+  }
+};
+
+template<>
+struct Block<8> {
+  static constexpr size_t n = 2;
+
+  template<typename T, typename IntT0, typename IntT1>
+  static void transpose(T* dst, IntT0 dj, const T* src, IntT1 si) noexcept {
+    const double* s = reinterpret_cast<const double*>(src);
+    double* d = reinterpret_cast<double*>(dst);
+    const __m128d r0 = _mm_loadu_pd(s);
+    const __m128d r1 = _mm_loadu_pd(s + si);
+    _mm_storeu_pd(d, _mm_unpacklo_pd(r0, r1));
+    _mm_storeu_pd(d + dj, _mm_unpackhi_pd(r0, r1));
+  }
+};
+#endif
+
+
+// dst[i*di + j*dj] := src[i*si + j*sj], i < ni, j < nj
+template<typename T, typename IntT0, typename IntT1>
+void transpose2d(T* dst, IntT0 di, IntT0 dj, const T* src, IntT1 si, IntT1 sj,
+                 size_t ni, size_t nj) noexcept {
+  using BlockT = Block<std::is_trivially_copyable<T>::value ? sizeof(T) : 0>;
+  constexpr size_t nb = BlockT::n;
+  const bool unit = di == 1 && sj == 1;
+
+  for (size_t i0 = 0; i0 < ni; i0 += k_tile) {
+    const size_t i1 = std::min(ni, i0 + k_tile);
+    for (size_t j0 = 0; j0 < nj; j0 += k_tile) {
+      const size_t j1 = std::min(nj, j0 + k_tile);
+      size_t ib = i0, jb = j0;
+      if (unit && nb > 1) {
+        ib = i0 + (i1 - i0) / nb * nb;
+        jb = j0 + (j1 - j0) / nb * nb;
+        for (size_t j = j0; j < jb; j += nb) {
+          for (size_t i = i0; i < ib; i += nb) {
+            BlockT::transpose(dst + i + j*dj, dj, src + i*si + j, si);
+          }
+        }
+      }
+      // tails of the tile (the whole tile if not blocked)
+      for (size_t j = j0; j < j1; ++j) {
+        const size_t ia = j < jb ? ib : i0;
+        for (size_t i = ia; i < i1; ++i) { dst[i*di + j*dj] = src[i*si + j*sj]; }
+      }
+    }
+  }
+}
+} // namespace impl_copy
+
+
+// Strided assignment: dst[i] := src[i] for all logical indices i.
+// Source dims of extent 1 (and sl::newaxis dims) are broadcast over dst.
+// The loops run in the order of the destination strides whatever MOrder
+// the operands have, so assigning between C and F arrays stays correct but
+// strided on the source side; copy_to() is faster for that case.
+// dst and src may overlap, e.g. assign(a[1:], a[:-1]), then src is copied
+// to a temporary first.
+template<class D0, typename T0, size_t ND, MOrder M0, typename IntT0,
+         class D1, typename T1, MOrder M1, typename IntT1>
+void assign(NArrayInterface_<D0, T0, ND, M0, IntT0>& dst,
+            const NArrayInterface_<D1, T1, ND, M1, IntT1>& src) {
+  const auto& dshape = dst.shape();
+  const auto& sshape = src.shape();
+  for (size_t n = 0; n < ND; ++n) {
+    if (sshape[n] != dshape[n] && sshape[n] != 1) {
+      throw ShapeError("xmat::assign(): source is not broadcastable to destination shape");
+    }
+  }
+  if (dst.numel() == 0) { return; }
+  impl_copy::assign(dst.ptr(), src.ptr(), impl_copy::nest(dshape, dst.stride(), sshape, src.stride()));
+}
+
+// for temporary views: assign(a.view<2>({...}), b)
+template<class D0, typename T0, size_t ND, MOrder M0, typename IntT0,
+         class D1, typename T1, MOrder M1, typename IntT1>
+void assign(NArrayInterface_<D0, T0, ND, M0, IntT0>&& dst,
+            const NArrayInterface_<D1, T1, ND, M1, IntT1>& src) {
+  assign(dst, src);
+}
+
+
+// dst and src must have the same shape and must not overlap
+template<class D0, typename T0, size_t ND, MOrder M0, typename IntT0,
+         class D1, typename T1, MOrder M1, typename IntT1>
+void copy_to(NArrayInterface_<D0, T0, ND, M0, IntT0>& dst,
+             const NArrayInterface_<D1, T1, ND, M1, IntT1>& src) {
+  if (!std::equal(dst.shape().begin(), dst.shape().end(), src.shape().begin())) {
+    throw ShapeError("xmat::copy_to(): source and destination shape mismatch");
+  }
+  if (dst.numel() == 0) { return; }
+
+  const auto& dshape = dst.shape();
+  const auto& dstride = dst.stride();
+  const auto& sstride = src.stride();
+  const size_t dd = impl_copy::localdim(dshape, dstride);
+  const size_t sd = impl_copy::localdim(src.shape(), sstride);
+
+  // same local dim or type conversion: strided assignment
+  if (!std::is_same<T0, std::remove_const_t<T1>>::value || dd == sd || dd == ND || sd == ND) {
+    assign(dst, src);
+    return;
+  }
+
+  // tiled transpose of dims (dd, sd), odometer over the rest
+  size_t od[ND] = {};
+  size_t nod = 0;
+  for (size_t n = 0; n < ND; ++n) {
+    if (n != dd && n != sd) { od[nod++] = n; }
+  }
+
+  size_t index[ND] = {};
+  T0* pd = dst.ptr();
+  const T1* ps = src.ptr();
+  while (true) {
+    const IntT0 od0 = hidx::conv(index, dstride.begin(), ND, IntT0{0});
+    const IntT1 os0 = hidx::conv(index, sstride.begin(), ND, IntT1{0});
+    impl_copy::transpose2d(pd + od0, dstride[dd], dstride[sd],
+                           reinterpret_cast<const T0*>(ps + os0), sstride[dd], sstride[sd],
+                           static_cast<size_t>(dshape[dd]), static_cast<size_t>(dshape[sd]));
+    size_t k = 0;
+    for (; k < nod; ++k) {
+      const size_t n = od[nod - 1 - k];
+      if (++index[n] < static_cast<size_t>(dshape[n])) { break; }
+      index[n] = 0;
+    }
+    if (k == nod) { break; }
+  }
+}
+
+// for temporary views: copy_to(a.view<2>({...}), b)
+template<class D0, typename T0, size_t ND, MOrder M0, typename IntT0,
+         class D1, typename T1, MOrder M1, typename IntT1>
+void copy_to(NArrayInterface_<D0, T0, ND, M0, IntT0>&& dst,
+             const NArrayInterface_<D1, T1, ND, M1, IntT1>& src) {
+  copy_to(dst, src);
+}
+} // namespace xmat
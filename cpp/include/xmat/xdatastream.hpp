@@ -60,6 +60,9 @@ struct ByteRepack_<true> {
   static double repack(double x) { return x; }
   
   static float repack(float x) { return x; }
+
+  template<typename T>
+  static std::complex<T> repack(std::complex<T> x) { return {repack(x.real()), repack(x.imag())}; }
 };
 
 template<Endian endian> struct Pack : ByteRepack_<endian != Endian::native> { };
@@ -100,6 +103,28 @@ struct BBufStorage_ {
   BBufStorage_() { }
   BBufStorage_(const memory_source_t& memsrc) : memsource_{memsrc} {}
 
+  ~BBufStorage_() {
+    if (data_) { memsource_.deallocate(data_, cap_); }
+  }
+
+  BBufStorage_(const BBufStorage_&) = delete;
+  BBufStorage_& operator=(const BBufStorage_&) = delete;
+
+  BBufStorage_(BBufStorage_&& other) noexcept
+    : memsource_{other.memsource_}, data_{other.data_}, N_{other.N_}, cap_{other.cap_} {
+    other.data_ = nullptr;
+    other.N_ = other.cap_ = 0;
+  }
+
+  BBufStorage_& operator=(BBufStorage_&& other) noexcept {
+    using std::swap;
+    swap(memsource_, other.memsource_);
+    swap(data_, other.data_);
+    swap(N_, other.N_);
+    swap(cap_, other.cap_);
+    return *this;
+  }
+
   void size_request(size_t n) { if (n > N_ ) reserve(n); }
 
   size_t request_all() {
@@ -120,6 +145,7 @@ struct BBufStorage_ {
       if (ptr) {
         assert((data_ && N_) || (!data_ && !N_));
         std::copy_n(data_, N_, static_cast<char*>(ptr));
+        if (data_) { memsource_.deallocate(data_, cap_); }
       }
       else {
         throw DataStreamError("buff_storage_ms:reserve(). exceed memory_source space : ");
@@ -127,6 +153,7 @@ struct BBufStorage_ {
     }
     data_ = static_cast<char*>(ptr);
     N_ = n;
+    cap_ = nout;
   }
 
   char* data() noexcept { return data_; }
@@ -138,6 +165,7 @@ struct BBufStorage_ {
   memory_source_t memsource_;
   char* data_ = nullptr;
   size_t N_ = 0;
+  size_t cap_ = 0;  // bytes taken from memsource_
 };
 
 
@@ -404,7 +432,7 @@ struct IDStream_ : public IBBuffT {
   IDStream_& read(T* data, size_t n) {
     T tmp;
     for (; n != 0; --n, ++data) {
-      base_t::read(reinterpret_cast<const char*>(&tmp), sizeof(T));
+      base_t::read(reinterpret_cast<char*>(&tmp), sizeof(T));
       *data = repack_t::repack(tmp);
     }
     return *this;
@@ -533,6 +561,47 @@ inline constexpr size_t sizeof_data_stream_type(sf::xuint8_t id) noexcept {
 }
 
 
+// calls f(DataStreamTypeTag<T>{}) for the registered type T with `id`,
+// returns false for unknown ids and xvoid
+template<typename T> struct DataStreamTypeTag { using type = T; };
+
+template<typename F>
+bool visit_data_stream_type(sf::xuint8_t id, F&& f) {
+  using std::complex;
+
+  switch (id) {
+  case DataStreamType<  char                    >::id:  f(DataStreamTypeTag<char>{}); return true;
+
+  case DataStreamType<  std::int8_t             >::id:  f(DataStreamTypeTag<std::int8_t>{}); return true;
+  case DataStreamType<  std::int16_t            >::id:  f(DataStreamTypeTag<std::int16_t>{}); return true;
+  case DataStreamType<  std::int32_t            >::id:  f(DataStreamTypeTag<std::int32_t>{}); return true;
+  case DataStreamType<  std::int64_t            >::id:  f(DataStreamTypeTag<std::int64_t>{}); return true;
+
+  case DataStreamType<  complex<std::int8_t>    >::id:  f(DataStreamTypeTag<complex<std::int8_t>>{}); return true;
+  case DataStreamType<  complex<std::int16_t>   >::id:  f(DataStreamTypeTag<complex<std::int16_t>>{}); return true;
+  case DataStreamType<  complex<std::int32_t>   >::id:  f(DataStreamTypeTag<complex<std::int32_t>>{}); return true;
+  case DataStreamType<  complex<std::int64_t>   >::id:  f(DataStreamTypeTag<complex<std::int64_t>>{}); return true;
+
+  case DataStreamType<  std::uint8_t            >::id:  f(DataStreamTypeTag<std::uint8_t>{}); return true;
+  case DataStreamType<  std::uint16_t           >::id:  f(DataStreamTypeTag<std::uint16_t>{}); return true;
+  case DataStreamType<  std::uint32_t           >::id:  f(DataStreamTypeTag<std::uint32_t>{}); return true;
+  case DataStreamType<  std::uint64_t           >::id:  f(DataStreamTypeTag<std::uint64_t>{}); return true;
+
+  case DataStreamType<  complex<std::uint8_t>   >::id:  f(DataStreamTypeTag<complex<std::uint8_t>>{}); return true;
+  case DataStreamType<  complex<std::uint16_t>  >::id:  f(DataStreamTypeTag<complex<std::uint16_t>>{}); return true;
+  case DataStreamType<  complex<std::uint32_t>  >::id:  f(DataStreamTypeTag<complex<std::uint32_t>>{}); return true;
+  case DataStreamType<  complex<std::uint64_t>  >::id:  f(DataStreamTypeTag<complex<std::uint64_t>>{}); return true;
+
+  case DataStreamType<  float                   >::id:  f(DataStreamTypeTag<float>{}); return true;
+  case DataStreamType<  double                  >::id:  f(DataStreamTypeTag<double>{}); return true;
+
+  case DataStreamType<  complex<float>          >::id:  f(DataStreamTypeTag<complex<float>>{}); return true;
+  case DataStreamType<  complex<double>         >::id:  f(DataStreamTypeTag<complex<double>>{}); return true;
+  default: return false;
+  }
+}
+
+
 //////////////////////////////
 struct XHead {
   // ODStreamT = ODStream_<>
@@ -667,7 +736,7 @@ struct XBlock {
   std::size_t data_nbytes() const noexcept { return numel() * typesize(); }
 
   size_t numel() const noexcept {
-    sf::xuint8_t N = 1;
+    size_t N = 1;
     for (auto it = shape_.begin(), end = shape_.begin() + s_; it != end; ++it) {
       N *= *it;
     }
@@ -893,6 +962,14 @@ class IMapStream_ {
       return y;
     }
 
+    // converting: y = x * scale + offset for arrays, see xconvert.hpp
+    template<typename T, typename std::enable_if_t<serial::LoadTo<T>::enabled, int> = 0> 
+    T& get_to(T& y, double scale, double offset = 0) {
+      get_precond();
+      serial::LoadTo<T>::load(block_, *ids_, y, scale, offset);
+      return y;
+    }
+
     template<typename T, typename std::enable_if_t<serial::LoadPtr<T>::enabled, int> = 0> 
     T* get_to(T* y) {
       get_precond();
@@ -967,11 +1044,17 @@ class IMapStream_ {
 // ---------------------------
 using OBBuf       = OBBuf_<bbuf_memsource_default>;   // default_constructable
 using OBBufGMS    = OBBuf_<AllocatorMSGlobal<char>>;  // default_constructable
+using OBBufGMT    = OBBuf_<AllocatorMSGlobalMT<char>>;  // default_constructable, thread-safe
+using OBBufPMS    = OBBuf_<AllocatorMSPool<char>>;    // default_constructable, thread-safe
 using OBBufMS     = OBBuf_<AllocatorMSRef<char>>;     // non_default_constructable
+using OBBufSMS    = OBBuf_<AllocatorMSStack<char>>;   // non_default_constructable, LIFO deallocation
 
 using IBBuf       = IBBuf_<bbuf_memsource_default>;   // default_constructable
 using IBBufGMS    = IBBuf_<AllocatorMSGlobal<char>>;  // default_constructable
+using IBBufGMT    = IBBuf_<AllocatorMSGlobalMT<char>>;  // default_constructable, thread-safe
+using IBBufPMS    = IBBuf_<AllocatorMSPool<char>>;    // default_constructable, thread-safe
 using IBBufMS     = IBBuf_<AllocatorMSRef<char>>;     // non_default_constructable
+using IBBufSMS    = IBBuf_<AllocatorMSStack<char>>;   // non_default_constructable, LIFO deallocation
 
 template<Endian endian> using ODStreamFile  = ODStream_<std::ofstream,  endian>;
 template<Endian endian> using ODStream      = ODStream_<OBBuf,          endian>;
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+#include "xutil.hpp"
+#include "xdatastream.hpp"
+#include "xarray.hpp"
+#include "xserial.hpp"
+
+
+namespace xmat {
+
+class TypeError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+
+// ------------------------------------------------------------
+// Array with runtime ndim and element type
+// ------------------------------------------------------------
+// Element type is a DataStreamType id, ndim is up to sf::k_max_ndim. Typed
+// access goes through views:
+//
+//   auto x = xin.at("x").get<xmat::NArrayDyn>();
+//   if (x.is<float>() && x.ndim() == 2) {
+//     auto v = x.as<float, 2>();      // xmat::View_<float, 2, MOrder::C>
+//   }
+template<class MemSourceT>
+struct NArrayDyn_ {
+  using shape_t = XBlock::shape_t;
+  using storage_t = NArrayStorage_<char, MemSourceT>;
+
+  static constexpr bool k_has_default_constructor = std::is_default_constructible<MemSourceT>::value;
+
+  template<bool HDC = k_has_default_constructor, typename std::enable_if<HDC, int>::type = 0>
+  NArrayDyn_() {}
+
+  NArrayDyn_(const MemSourceT& memsrs) : storage_{memsrs} { }
+
+  template<bool HDC = k_has_default_constructor, typename std::enable_if<HDC, int>::type = 0>
+  NArrayDyn_(sf::xuint8_t tid, size_t ndim, const shape_t& shape, MOrder morder = MOrder::C)
+    : NArrayDyn_(MemSourceT{}) {
+    init(tid, ndim, shape, morder);
+  }
+
+  NArrayDyn_(sf::xuint8_t tid, size_t ndim, const shape_t& shape, MOrder morder, const MemSourceT& memsrs)
+    : NArrayDyn_(memsrs) {
+    init(tid, ndim, shape, morder);
+  }
+
+  // (re)allocates uninitialized data
+  void init(sf::xuint8_t tid, size_t ndim, const shape_t& shape, MOrder morder = MOrder::C) {
+    if (sizeof_data_stream_type(tid) == 0 || tid == DataStreamType<xvoid>::id) {
+      throw TypeError("xmat::NArrayDyn_::init(): unknown type id");
+    }
+    if (ndim > sf::k_max_ndim) {
+      throw ShapeError("xmat::NArrayDyn_::init(): ndim > sf::k_max_ndim");
+    }
+    tid_ = tid;
+    ndim_ = ndim;
+    morder_ = morder;
+    shape_.fill(0);
+    std::copy_n(shape.begin(), ndim, shape_.begin());
+
+    storage_t storage{storage_.memsource_};
+    if (const size_t n = nbytes()) { storage.init(n); }
+    swap(storage_, storage);
+  }
+
+  // type
+  // ----
+  sf::xuint8_t tid() const noexcept { return tid_; }
+
+  size_t typesize() const noexcept { return sizeof_data_stream_type(tid_); }
+
+  template<typename T>
+  bool is() const noexcept { return DataStreamType<T>::enabled && DataStreamType<T>::id == tid_; }
+
+  // shape
+  // -----
+  size_t ndim() const noexcept { return ndim_; }
+
+  const shape_t& shape() const noexcept { return shape_; }
+
+  MOrder morder() const noexcept { return morder_; }
+
+  size_t numel() const noexcept {
+    size_t n = 1;
+    for (size_t i = 0; i < ndim_; ++i) { n *= static_cast<size_t>(shape_[i]); }
+    return n;
+  }
+
+  size_t nbytes() const noexcept { return numel() * typesize(); }
+
+  void* data() noexcept { return storage_.data(); }
+
+  const void* data() const noexcept { return storage_.data(); }
+
+  // typed views: ND >= ndim(), missing dims have extent 1
+  // (leading dims for MOrder::C, trailing for MOrder::F)
+  template<typename T, size_t ND, MOrder MOrderT = MOrder::C>
+  View_<T, ND, MOrderT> as() {
+    return {static_cast<T*>(data()), index<T, ND, MOrderT>()};
+  }
+
+  template<typename T, size_t ND, MOrder MOrderT = MOrder::C>
+  View_<const T, ND, MOrderT> as() const {
+    return {static_cast<const T*>(data()), index<T, ND, MOrderT>()};
+  }
+
+ private:
+  template<typename T, size_t ND, MOrder MOrderT>
+  Index<ND> index() const {
+    if (!is<T>()) {
+      throw TypeError("xmat::NArrayDyn_::as<T, ND>(): wrong element type");
+    }
+    if (ND < ndim_) {
+      throw ShapeError("xmat::NArrayDyn_::as<T, ND>(): ND < ndim()");
+    }
+    if (MOrderT != morder_ && ndim_ > 1) {
+      throw ShapeError("xmat::NArrayDyn_::as<T, ND>(): wrong memory order");
+    }
+    Index<ND> out;
+    out.fill(1);
+    const size_t d0 = MOrderT == MOrder::C ? ND - ndim_ : 0;
+    std::copy_n(shape_.begin(), ndim_, out.begin() + d0);
+    return out;
+  }
+
+ public:
+  storage_t storage_;
+  shape_t shape_ = {};
+  size_t ndim_ = 0;
+  sf::xuint8_t tid_ = DataStreamType<xvoid>::id;
+  MOrder morder_ = MOrder::C;
+};
+
+using NArrayDyn = NArrayDyn_<std::allocator<char>>;
+
+
+namespace serial {
+
+// xmat::NArrayDyn_
+////////////////////////////////////////////////////////////////////////////////
+// data is written and read in one call for the element type of the block
+template<class MemSourceT>
+struct Dump<NArrayDyn_<MemSourceT>>
+{
+  static const bool enabled = true;
+  using array_t = NArrayDyn_<MemSourceT>;
+
+  template<typename ODStreamT>
+  static void dump(XBlock& block, ODStreamT& ods, const array_t& x) {
+    block.o_ = static_cast<char>(x.morder());
+    block.t_ = x.tid();
+    block.s_ = static_cast<sf::xuint8_t>(x.ndim());
+    block.shape_ = x.shape();
+    block.dump(ods);
+
+    const bool known = visit_data_stream_type(x.tid(), [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      ods.write(static_cast<const T*>(x.data()), x.numel());
+    });
+    assert(known || x.numel() == 0);
+    (void)known;
+  }
+};
+
+template<class MemSourceT>
+struct LoadTo<NArrayDyn_<MemSourceT>>
+{
+  static const bool enabled = true;
+  using array_t = NArrayDyn_<MemSourceT>;
+
+  template<typename IDStreamT>
+  static void load(XBlock& block, IDStreamT& ids, array_t& y) {
+    if (block.ndim() > sf::k_max_ndim) {
+      throw DeserializationError("wrong ndim");
+    }
+    if (block.morder() != 'C' && block.morder() != 'F') {
+      throw DeserializationError("wrong memory order");
+    }
+    if (sizeof_data_stream_type(block.tid()) == 0 || block.tid() == DataStreamType<xvoid>::id) {
+      throw DeserializationError("NArrayDyn_ load(): unknown scalar type");
+    }
+    y.init(block.tid(), block.ndim(), block.shape(), static_cast<MOrder>(block.morder()));
+
+    visit_data_stream_type(y.tid(), [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      ids.read(static_cast<T*>(y.data()), y.numel());
+    });
+  }
+};
+
+template<class MemSourceT>
+struct LoadArgs<NArrayDyn_<MemSourceT>>
+{
+  static const bool enabled = true;
+  using array_t = NArrayDyn_<MemSourceT>;
+
+  template<typename IDStreamT, typename ... Args>
+  static array_t load(XBlock& block, IDStreamT& ids, Args&&... args) {
+    array_t y{MemSourceT{std::forward<Args>(args)...}};
+    LoadTo<array_t>::load(block, ids, y);
+    return y;
+  }
+};
+
+template<class MemSourceT>
+struct Load<NArrayDyn_<MemSourceT>, std::enable_if_t<NArrayDyn_<MemSourceT>::k_has_default_constructor>>
+{
+  static const bool enabled = true;
+  using array_t = NArrayDyn_<MemSourceT>;
+
+  template<typename IDStreamT>
+  static array_t load(XBlock& block, IDStreamT& ids) {
+    return LoadArgs<array_t>::load(block, ids);
+  }
+};
+} // namespace serial
+} // namespace xmat
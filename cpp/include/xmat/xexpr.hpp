@@ -0,0 +1,480 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+
+#include <complex>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Lazy element-wise expressions
+// ------------------------------------------------------------
+// Operators over NArray_/View_ build a tree of small nodes. Nothing is
+// computed until the tree is assigned into a destination, then the whole
+// tree is evaluated in one fused loop without temporaries:
+//
+//   xmat::assign(y, a*b + c);
+//   xmat::assign(y.view<2>({sl::all, sl::ilen(0, 4)}), xmat::abs(a) > 0.5f);
+//
+// Operands of the same ndim are broadcast numpy-style: a dim of extent 1
+// is repeated (stride 0) along the extent of the other operand, e.g.
+//
+//   xmat::assign(y, x * gain.view<2>({sl::all, sl::nax}));  // [C, S] * [C, 1]
+//   xmat::assign(y, u.view<2>({sl::all, sl::nax}) * v.view<2>({sl::nax, sl::all}));
+//
+// Broadcasting is resolved once when the tree is built, the evaluation loop
+// only sees strides.
+//
+// Node interface (used by the evaluation loop):
+//   shape()          logical shape
+//   broadcast(shape) stretch extent-1 dims to `shape` (stride 0)
+//   ndcontig<M>()    number of jointly contiguous dims in M order
+//   inner(nd)        select dim `nd` as the inner loop dimension
+//   unit()           true if all terminals have unit inner stride
+//   seek(index)      move terminals to the row started at `index`
+//   step(i), lin(i)  i-th element of the row: strided and unit-stride
+template<typename E>
+struct Expr_ {
+  E& self() noexcept { return static_cast<E&>(*this); }
+
+  const E& self() const noexcept { return static_cast<const E&>(*this); }
+
+ protected:
+  Expr_() = default;
+};
+
+
+// terminal: strided read-only access to NArrayInterface_ data
+template<typename T, size_t ND>
+struct ExprTerm_ : public Expr_<ExprTerm_<T, ND>> {
+  using value_type = std::remove_const_t<T>;
+  using index_t = Index<ND>;
+  static const size_t ndim = ND;
+
+  template<typename IntT>
+  ExprTerm_(const T* ptr, const Index_<IntT, ND>& shape, const Index_<IntT, ND>& stride) noexcept
+  : ptr_{ptr}, cur_{ptr} {
+    shape_.fill(shape.begin());
+    stride_.fill(stride.begin());
+  }
+
+  const index_t& shape() const noexcept { return shape_; }
+
+  void broadcast(const index_t& shape) noexcept {
+    for (size_t d = 0; d < ND; ++d) {
+      if (shape_[d] != shape[d]) {
+        assert(shape_[d] == 1);
+        shape_[d] = shape[d];
+        stride_[d] = 0;
+      }
+    }
+  }
+
+  template<MOrder MOrderT>
+  size_t ndcontig() const noexcept {
+    return hidx::ndcontigous<MOrderT>(shape_.begin(), stride_.begin(), ND);
+  }
+
+  void inner(size_t nd) noexcept { istride_ = stride_[nd]; }
+
+  bool unit() const noexcept { return istride_ == 1; }
+
+  void seek(const size_t* index) noexcept {
+    cur_ = ptr_ + hidx::conv(index, stride_.begin(), ND, size_t{0});
+  }
+
+  value_type step(size_t i) const noexcept { return cur_[i * istride_]; }
+
+  value_type lin(size_t i) const noexcept { return cur_[i]; }
+
+  const T* ptr_ = nullptr;
+  const T* cur_ = nullptr;
+  index_t shape_;
+  index_t stride_;
+  size_t istride_ = 1;
+};
+
+
+// terminal: scalar, takes the shape of the other operand
+template<typename T, size_t ND>
+struct ExprScalar_ : public Expr_<ExprScalar_<T, ND>> {
+  using value_type = T;
+  using index_t = Index<ND>;
+  static const size_t ndim = ND;
+
+  template<typename U>
+  ExprScalar_(const U& x, const index_t& shape) noexcept : x_(static_cast<T>(x)), shape_{shape} {}
+
+  const index_t& shape() const noexcept { return shape_; }
+
+  void broadcast(const index_t& shape) noexcept { shape_ = shape; }
+
+  template<MOrder MOrderT>
+  size_t ndcontig() const noexcept { return ND; }
+
+  void inner(size_t) noexcept { }
+
+  bool unit() const noexcept { return true; }
+
+  void seek(const size_t*) noexcept { }
+
+  value_type step(size_t) const noexcept { return x_; }
+
+  value_type lin(size_t) const noexcept { return x_; }
+
+  T x_;
+  index_t shape_;
+};
+
+
+template<typename Op, typename E>
+struct ExprUnary_ : public Expr_<ExprUnary_<Op, E>> {
+  using value_type = std::decay_t<decltype(std::declval<const Op&>().apply(
+                                           std::declval<typename E::value_type>()))>;
+  using index_t = Index<E::ndim>;
+  static const size_t ndim = E::ndim;
+
+  explicit ExprUnary_(const E& e, const Op& op = Op{}) : e_{e}, op_{op} {}
+
+  const index_t& shape() const noexcept { return e_.shape(); }
+
+  void broadcast(const index_t& shape) noexcept { e_.broadcast(shape); }
+
+  template<MOrder MOrderT>
+  size_t ndcontig() const noexcept { return e_.template ndcontig<MOrderT>(); }
+
+  void inner(size_t nd) noexcept { e_.inner(nd); }
+
+  bool unit() const noexcept { return e_.unit(); }
+
+  void seek(const size_t* index) noexcept { e_.seek(index); }
+
+  value_type step(size_t i) const { return op_.apply(e_.step(i)); }
+
+  value_type lin(size_t i) const { return op_.apply(e_.lin(i)); }
+
+  E e_;
+  Op op_;
+};
+
+
+namespace impl_expr {
+
+// numpy rule per dim: equal extents, or one of them is 1
+template<size_t ND>
+bool broadcast_shape(const Index<ND>& s0, const Index<ND>& s1, Index<ND>& out) noexcept {
+  for (size_t d = 0; d < ND; ++d) {
+    if (s0[d] != s1[d] && s0[d] != 1 && s1[d] != 1) { return false; }
+    out[d] = s0[d] == 1 ? s1[d] : s0[d];
+  }
+  return true;
+}
+} // namespace impl_expr
+
+
+template<typename Op, typename E0, typename E1>
+struct ExprBinary_ : public Expr_<ExprBinary_<Op, E0, E1>> {
+  static_assert(E0::ndim == E1::ndim, "xmat::ExprBinary_: operands must have the same ndim");
+  using value_type = std::decay_t<decltype(std::declval<const Op&>().apply(
+                                           std::declval<typename E0::value_type>(),
+                                           std::declval<typename E1::value_type>()))>;
+  using index_t = Index<E0::ndim>;
+  static const size_t ndim = E0::ndim;
+
+  ExprBinary_(const E0& e0, const E1& e1, const Op& op = Op{}) : e0_{e0}, e1_{e1}, op_{op} {
+    if (!impl_expr::broadcast_shape(e0_.shape(), e1_.shape(), shape_)) {
+      throw ShapeError("xmat::ExprBinary_: operands are not broadcastable");
+    }
+    if (e0_.shape() != shape_) { e0_.broadcast(shape_); }
+    if (e1_.shape() != shape_) { e1_.broadcast(shape_); }
+  }
+
+  const index_t& shape() const noexcept { return shape_; }
+
+  void broadcast(const index_t& shape) noexcept {
+    shape_ = shape;
+    if (e0_.shape() != shape_) { e0_.broadcast(shape_); }
+    if (e1_.shape() != shape_) { e1_.broadcast(shape_); }
+  }
+
+  template<MOrder MOrderT>
+  size_t ndcontig() const noexcept {
+    return std::min(e0_.template ndcontig<MOrderT>(), e1_.template ndcontig<MOrderT>());
+  }
+
+  void inner(size_t nd) noexcept { e0_.inner(nd); e1_.inner(nd); }
+
+  bool unit() const noexcept { return e0_.unit() && e1_.unit(); }
+
+  void seek(const size_t* index) noexcept { e0_.seek(index); e1_.seek(index); }
+
+  value_type step(size_t i) const { return op_.apply(e0_.step(i), e1_.step(i)); }
+
+  value_type lin(size_t i) const { return op_.apply(e0_.lin(i), e1_.lin(i)); }
+
+  E0 e0_;
+  E1 e1_;
+  Op op_;
+  index_t shape_;
+};
+
+
+// element-wise operations
+// -----------------------
+namespace op {
+
+#define XMAT_EXPR_BINARY_OP(Name, Symbol)                                     \
+struct Name {                                                                 \
+  template<typename A, typename B>                                            \
+  static auto apply(const A& a, const B& b) -> decltype(a Symbol b) {         \
+    return a Symbol b;                                                        \
+  }                                                                           \
+};
+
+XMAT_EXPR_BINARY_OP(add,  +);
+XMAT_EXPR_BINARY_OP(sub,  -);
+XMAT_EXPR_BINARY_OP(mul,  *);
+XMAT_EXPR_BINARY_OP(div,  /);
+XMAT_EXPR_BINARY_OP(eq,   ==);
+XMAT_EXPR_BINARY_OP(ne,   !=);
+XMAT_EXPR_BINARY_OP(lt,   <);
+XMAT_EXPR_BINARY_OP(le,   <=);
+XMAT_EXPR_BINARY_OP(gt,   >);
+XMAT_EXPR_BINARY_OP(ge,   >=);
+#undef XMAT_EXPR_BINARY_OP
+
+struct neg {
+  template<typename A>
+  static A apply(const A& a) { return -a; }
+};
+
+struct abs {
+  template<typename A>
+  static auto apply(const A& a) -> decltype(std::abs(a)) { return std::abs(a); }
+};
+
+struct conj {
+  template<typename A>
+  static A apply(const A& a) { return a; }
+
+  template<typename A>
+  static std::complex<A> apply(const std::complex<A>& a) { return std::conj(a); }
+};
+
+struct real {
+  template<typename A>
+  static A apply(const A& a) { return a; }
+
+  template<typename A>
+  static A apply(const std::complex<A>& a) { return a.real(); }
+};
+
+struct imag {
+  template<typename A>
+  static A apply(const A&) { return A{0}; }
+
+  template<typename A>
+  static A apply(const std::complex<A>& a) { return a.imag(); }
+};
+
+struct exp {
+  template<typename A>
+  static auto apply(const A& a) -> decltype(std::exp(a)) { return std::exp(a); }
+};
+
+struct sqrt {
+  template<typename A>
+  static auto apply(const A& a) -> decltype(std::sqrt(a)) { return std::sqrt(a); }
+};
+
+// user's functor
+template<typename F>
+struct call {
+  template<typename ... Args>
+  auto apply(const Args& ... args) const -> decltype(std::declval<const F&>()(args...)) {
+    return f(args...);
+  }
+
+  F f;
+};
+} // namespace op
+
+
+namespace impl_expr {
+
+template<class D, typename T, size_t ND, MOrder MOrderT, typename IntT>
+ExprTerm_<const T, ND> term(const NArrayInterface_<D, T, ND, MOrderT, IntT>& x) noexcept {
+  return {x.ptr(), x.shape(), x.stride()};
+}
+
+template<typename E>
+const E& term(const Expr_<E>& e) noexcept { return e.self(); }
+
+template<typename ...> struct voider { using type = void; };
+
+template<typename U, typename = void>
+struct is_operand : std::false_type { };
+
+template<typename U>
+struct is_operand<U, typename voider<decltype(term(std::declval<const U&>()))>::type>
+  : std::true_type { };
+
+template<typename U> struct is_scalar : std::is_arithmetic<U> { };
+
+template<typename U> struct is_scalar<std::complex<U>> : std::true_type { };
+
+template<typename U>
+using term_t = std::decay_t<decltype(term(std::declval<const U&>()))>;
+
+// float scalar for complex<float> operand, otherwise scalar type as is
+template<typename S, typename V>
+struct scalar_type { using type = S; };
+
+template<typename S, typename U>
+struct scalar_type<S, std::complex<U>> {
+  using type = std::conditional_t<std::is_arithmetic<S>::value, U, S>;
+};
+
+template<typename S, typename A>
+using scalar_t = ExprScalar_<typename scalar_type<S, typename term_t<A>::value_type>::type,
+                             term_t<A>::ndim>;
+
+
+// Fused evaluation loop.
+// Inner run: `nc` most data-local dims which are jointly contiguous for the
+// destination and all terminals. Outer dims are walked by an index odometer.
+template<MOrder MOrderT, typename T, size_t ND, typename IntT, typename E>
+void eval(T* ptr, const Index_<IntT, ND>& shape, const Index_<IntT, ND>& stride, E& e) {
+  if (shape.numel() == 0) { return; }
+
+  const size_t nc = std::min(hidx::ndcontigous<MOrderT>(shape.begin(), stride.begin(), ND),
+                             e.template ndcontig<MOrderT>());
+  const size_t lowi = hidx::morderlowi(MOrderT, ND);
+
+  size_t len = 1;
+  for (size_t n = 0; n < nc; ++n) {
+    len *= shape[MOrderT == MOrder::C ? ND - 1 - n : n];
+  }
+
+  e.inner(lowi);
+  const IntT ds = stride[lowi];
+  const bool unit = ds == 1 && e.unit();
+
+  size_t index[ND] = {};
+  do {
+    T* p = ptr + hidx::conv(index, stride.begin(), ND, IntT{0});
+    e.seek(index);
+    if (unit) {
+      for (size_t i = 0; i < len; ++i) { p[i] = static_cast<T>(e.lin(i)); }
+    }
+    else {
+      for (size_t i = 0; i < len; ++i) { p[i * ds] = static_cast<T>(e.step(i)); }
+    }
+  } while (hidx::next_outer<MOrderT>(index, shape.begin(), ND, nc));
+}
+} // namespace impl_expr
+
+
+// operators
+// ---------
+#define XMAT_EXPR_BINARY_OPERATOR(Symbol, Op)                                         \
+template<typename A, typename B, std::enable_if_t<                                    \
+  impl_expr::is_operand<A>::value && impl_expr::is_operand<B>::value, int> = 0>       \
+ExprBinary_<op::Op, impl_expr::term_t<A>, impl_expr::term_t<B>>                       \
+operator Symbol(const A& a, const B& b) {                                             \
+  return {impl_expr::term(a), impl_expr::term(b)};                                    \
+}                                                                                     \
+                                                                                      \
+template<typename A, typename S, std::enable_if_t<                                    \
+  impl_expr::is_operand<A>::value && impl_expr::is_scalar<S>::value, int> = 0>        \
+ExprBinary_<op::Op, impl_expr::term_t<A>, impl_expr::scalar_t<S, A>>                  \
+operator Symbol(const A& a, const S& s) {                                             \
+  const auto& ta = impl_expr::term(a);                                                \
+  return {ta, {s, ta.shape()}};                                                       \
+}                                                                                     \
+                                                                                      \
+template<typename S, typename B, std::enable_if_t<                                    \
+  impl_expr::is_scalar<S>::value && impl_expr::is_operand<B>::value, int> = 0>        \
+ExprBinary_<op::Op, impl_expr::scalar_t<S, B>, impl_expr::term_t<B>>                  \
+operator Symbol(const S& s, const B& b) {                                             \
+  const auto& tb = impl_expr::term(b);                                                \
+  return {{s, tb.shape()}, tb};                                                       \
+}
+
+XMAT_EXPR_BINARY_OPERATOR(+,  add);
+XMAT_EXPR_BINARY_OPERATOR(-,  sub);
+XMAT_EXPR_BINARY_OPERATOR(*,  mul);
+XMAT_EXPR_BINARY_OPERATOR(/,  div);
+XMAT_EXPR_BINARY_OPERATOR(==, eq);
+XMAT_EXPR_BINARY_OPERATOR(!=, ne);
+XMAT_EXPR_BINARY_OPERATOR(<,  lt);
+XMAT_EXPR_BINARY_OPERATOR(<=, le);
+XMAT_EXPR_BINARY_OPERATOR(>,  gt);
+XMAT_EXPR_BINARY_OPERATOR(>=, ge);
+#undef XMAT_EXPR_BINARY_OPERATOR
+
+
+#define XMAT_EXPR_UNARY_FUNCTION(Name, Op)                                            \
+template<typename A, std::enable_if_t<impl_expr::is_operand<A>::value, int> = 0>      \
+ExprUnary_<op::Op, impl_expr::term_t<A>> Name(const A& a) {                           \
+  return ExprUnary_<op::Op, impl_expr::term_t<A>>{impl_expr::term(a)};                \
+}
+
+XMAT_EXPR_UNARY_FUNCTION(operator-, neg);
+XMAT_EXPR_UNARY_FUNCTION(abs,       abs);
+XMAT_EXPR_UNARY_FUNCTION(conj,      conj);
+XMAT_EXPR_UNARY_FUNCTION(real,      real);
+XMAT_EXPR_UNARY_FUNCTION(imag,      imag);
+XMAT_EXPR_UNARY_FUNCTION(exp,       exp);
+XMAT_EXPR_UNARY_FUNCTION(sqrt,      sqrt);
+#undef XMAT_EXPR_UNARY_FUNCTION
+
+
+// map(f, a), map(f, a, b): element-wise call of user's functor
+template<typename F, typename A, std::enable_if_t<impl_expr::is_operand<A>::value, int> = 0>
+ExprUnary_<op::call<F>, impl_expr::term_t<A>> map(F f, const A& a) {
+  return ExprUnary_<op::call<F>, impl_expr::term_t<A>>{impl_expr::term(a), {f}};
+}
+
+template<typename F, typename A, typename B, std::enable_if_t<
+  impl_expr::is_operand<A>::value && impl_expr::is_operand<B>::value, int> = 0>
+ExprBinary_<op::call<F>, impl_expr::term_t<A>, impl_expr::term_t<B>> map(F f, const A& a, const B& b) {
+  return {impl_expr::term(a), impl_expr::term(b), {f}};
+}
+
+
+// evaluation
+// ----------
+// expression is broadcast to the dst shape. Reading and writing
+// the same elements (y = y*2) is fine, partially overlapped views are not.
+template<class D, typename T, size_t ND, MOrder MOrderT, typename IntT, typename E>
+void assign(NArrayInterface_<D, T, ND, MOrderT, IntT>& dst, const Expr_<E>& expr) {
+  static_assert(E::ndim == ND, "xmat::assign(): expression and destination ndim mismatch");
+  E e = expr.self();
+  if (!std::equal(dst.shape().begin(), dst.shape().end(), e.shape().begin())) {
+    Index<ND> shape;
+    shape.fill(dst.shape().begin());
+    Index<ND> out;
+    if (!impl_expr::broadcast_shape(e.shape(), shape, out) || out != shape) {
+      throw ShapeError("xmat::assign(): expression is not broadcastable to destination shape");
+    }
+    e.broadcast(shape);
+  }
+  impl_expr::eval<MOrderT>(dst.ptr(), dst.shape(), dst.stride(), e);
+}
+
+// for temporary views: assign(a.view<2>({...}), expr)
+template<class D, typename T, size_t ND, MOrder MOrderT, typename IntT, typename E>
+void assign(NArrayInterface_<D, T, ND, MOrderT, IntT>&& dst, const Expr_<E>& expr) {
+  assign(dst, expr);
+}
+} // namespace xmat
@@ -0,0 +1,709 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+
+#include <complex>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XMAT_FFT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+#include "xthreadpool.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// FFT along an axis
+// ------------------------------------------------------------
+//   xmat::fft<1>(y, x);     // complex [C, N] -> [C, N], along N
+//   xmat::ifft<1>(x, y);    // scaled by 1/N
+//   xmat::rfft<1>(y, r);    // real [C, N] -> complex [C, N/2+1]
+//   xmat::irfft<1>(r, y);   // complex [C, N/2+1] -> real [C, N]
+//
+// Mixed radix 4, 2, 3, 5 and generic radix up to k_max_radix, Bluestein
+// for lengths with larger prime factors. Plans depend on the length and the
+// real type only, they are created once and cached: FftPlan_<R>::get(n).
+//
+// The other axes form a batch of independent transforms. They are gathered
+// W at a time into SIMD lanes (4 for float, 2 for double with SSE2), so one
+// butterfly processes W transforms. Any strides, dst may be src for fft/ifft.
+// Threaded versions at the end: xmat::par::fft/ifft/rfft/irfft.
+namespace impl_fft {
+
+constexpr size_t k_max_radix = 64;
+
+// vector of W lanes: scalar fallback
+template<typename R>
+struct Vec {
+  using type = R;
+  static constexpr size_t width = 1;
+
+  static type zero() noexcept { return R{0}; }
+  static type set1(R x) noexcept { return x; }
+  static type load(const R* p) noexcept { return *p; }
+  static void store(R* p, type v) noexcept { *p = v; }
+  static type add(type a, type b) noexcept { return a + b; }
+  static type sub(type a, type b) noexcept { return a - b; }
+  static type mul(type a, type b) noexcept { return a * b; }
+};
+
+#if defined(XMAT_FFT_SSE2)
+template<>
+struct Vec<float> {
+  using type = __m128;
+  static constexpr size_t width = 4;
+
+  static type zero() noexcept { return _mm_setzero_ps(); }
+  static type set1(float x) noexcept { return _mm_set1_ps(x); }
+  static type load(const float* p) noexcept { return _mm_loadu_ps(p); }
+  static void store(float* p, type v) noexcept { _mm_storeu_ps(p, v); }
+  static type add(type a, type b) noexcept { return _mm_add_ps(a, b); }
+  static type sub(type a, type b) noexcept { return _mm_sub_ps(a, b); }
+  static type mul(type a, type b) noexcept { return _mm_mul_ps(a, b); }
+};
+
+template<>
+struct Vec<double> {
+  using type = __m128d;
+  static constexpr size_t width = 2;
+
+  static type zero() noexcept { return _mm_setzero_pd(); }
+  static type set1(double x) noexcept { return _mm_set1_pd(x); }
+  static type load(const double* p) noexcept { return _mm_loadu_pd(p); }
+  static void store(double* p, type v) noexcept { _mm_storeu_pd(p, v); }
+  static type add(type a, type b) noexcept { return _mm_add_pd(a, b); }
+  static type sub(type a, type b) noexcept { return _mm_sub_pd(a, b); }
+  static type mul(type a, type b) noexcept { return _mm_mul_pd(a, b); }
+};
+#endif
+
+
+// Butterfly element: W complex values of W transforms, split re/im.
+// Explicit arithmetic, std::complex operator* is slow without -ffast-math.
+// scalar lane
+template<typename R>
+struct Cx {
+  static constexpr size_t width = 1;
+
+  static Cx make(const R* re, const R* im) noexcept { return {re[0], im[0]}; }
+  void split(R* re_, R* im_) const noexcept { re_[0] = re; im_[0] = im; }
+
+  friend Cx operator+(const Cx& a, const Cx& b) noexcept { return {a.re + b.re, a.im + b.im}; }
+  friend Cx operator-(const Cx& a, const Cx& b) noexcept { return {a.re - b.re, a.im - b.im}; }
+  friend Cx operator*(const Cx& a, R s) noexcept { return {a.re * s, a.im * s}; }
+  Cx& operator+=(const Cx& b) noexcept { re += b.re; im += b.im; return *this; }
+
+  R re, im;
+};
+
+// SIMD lanes
+template<typename R, size_t W>
+struct CxV {
+  using V = Vec<R>;
+  using vec_t = typename V::type;
+  static constexpr size_t width = W;
+
+  static CxV make(const R* re, const R* im) noexcept { return {V::load(re), V::load(im)}; }
+  void split(R* re_, R* im_) const noexcept { V::store(re_, re); V::store(im_, im); }
+
+  friend CxV operator+(const CxV& a, const CxV& b) noexcept {
+    return {V::add(a.re, b.re), V::add(a.im, b.im)};
+  }
+  friend CxV operator-(const CxV& a, const CxV& b) noexcept {
+    return {V::sub(a.re, b.re), V::sub(a.im, b.im)};
+  }
+  friend CxV operator*(const CxV& a, R s) noexcept {
+    const vec_t v = V::set1(s);
+    return {V::mul(a.re, v), V::mul(a.im, v)};
+  }
+  CxV& operator+=(const CxV& b) noexcept { return *this = *this + b; }
+
+  vec_t re, im;
+};
+
+// element of W lanes for real type R
+template<typename R, size_t W>
+using elem_t = std::conditional_t<W == 1, Cx<R>, CxV<R, W>>;
+
+template<typename R>
+constexpr size_t simd_width() noexcept { return Vec<R>::width; }
+
+template<typename E> E zero() noexcept { E e; const decltype(e.re) z{}; e.re = z; e.im = z; return e; }
+
+template<typename R>
+Cx<R> cmul(const Cx<R>& a, const std::complex<R>& w) noexcept {
+  return {a.re * w.real() - a.im * w.imag(), a.re * w.imag() + a.im * w.real()};
+}
+
+template<typename R, size_t W>
+CxV<R, W> cmul(const CxV<R, W>& a, const std::complex<R>& w) noexcept {
+  using V = Vec<R>;
+  const auto wr = V::set1(w.real()), wi = V::set1(w.imag());
+  return {V::sub(V::mul(a.re, wr), V::mul(a.im, wi)), V::add(V::mul(a.re, wi), V::mul(a.im, wr))};
+}
+
+// a * (-i)
+template<typename E>
+E rot(const E& a) noexcept { E out; out.re = a.im; out.im = (zero<E>() - a).re; return out; }
+
+template<typename E>
+E conj(const E& a) noexcept { E out; out.re = a.re; out.im = (zero<E>() - a).im; return out; }
+} // namespace impl_fft
+
+
+// ------------------------------------------------------------
+// FftPlan_: factors and twiddles of the forward transform of length n
+// ------------------------------------------------------------
+template<typename R>
+class FftPlan_ {
+ public:
+  using complex_t = std::complex<R>;
+
+  explicit FftPlan_(size_t n) : n_{n} {
+    twiddles(tw_, n_, n_);
+    // real transform of length 2n uses this plan: exp(-2*pi*i*k / 2n)
+    twiddles(rtw_, 2 * n_, n_ + 1);
+
+    size_t p = 4, m = n_;
+    bool small = true;
+    while (m > 1) {
+      while (m % p) {
+        p = p == 4 ? 2 : p == 2 ? 3 : p + 2;
+        if (p * p > m) { p = m; }
+      }
+      m /= p;
+      factors_.push_back(p);
+      factors_.push_back(m);
+      small = small && p <= impl_fft::k_max_radix;
+    }
+    if (!small) { init_bluestein(); }
+  }
+
+  // cached plan, shared between threads
+  static std::shared_ptr<const FftPlan_> get(size_t n) {
+    static std::mutex mutex;
+    static std::map<size_t, std::shared_ptr<const FftPlan_>> cache;
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      auto it = cache.find(n);
+      if (it != cache.end()) { return it->second; }
+    }
+    auto plan = std::make_shared<const FftPlan_>(n);  // may get() a sub-plan
+    std::lock_guard<std::mutex> lock{mutex};
+    return cache.emplace(n, std::move(plan)).first->second;
+  }
+
+  size_t size() const noexcept { return n_; }
+
+  // elements of scratch memory for exec()
+  size_t worksize() const noexcept { return 2 * m_; }
+
+  // out := DFT(in), in and out don't overlap
+  template<typename E>
+  void exec(const E* in, E* out, E* work) const noexcept {
+    if (n_ <= 1) {
+      if (n_ == 1) { out[0] = in[0]; }
+      return;
+    }
+    if (!sub_) {
+      work_(out, in, 1, factors_.data());
+      return;
+    }
+    // Bluestein: DFT as a convolution with the chirp of power-of-two length m
+    E* a = work;
+    E* b = work + m_;
+    for (size_t k = 0; k < n_; ++k) { a[k] = impl_fft::cmul(in[k], chirp_[k]); }
+    std::fill(a + n_, a + m_, impl_fft::zero<E>());
+    sub_->exec(a, b, static_cast<E*>(nullptr));
+    for (size_t k = 0; k < m_; ++k) { b[k] = impl_fft::cmul(impl_fft::conj(b[k]), filter_[k]); }
+    sub_->exec(b, a, static_cast<E*>(nullptr));
+    for (size_t k = 0; k < n_; ++k) { out[k] = impl_fft::cmul(impl_fft::conj(a[k]), chirp_[k]); }
+  }
+
+  const complex_t* rtwiddles() const noexcept { return rtw_.data(); }
+
+ private:
+  static void twiddles(std::vector<complex_t>& tw, size_t n, size_t count) {
+    const double pi = std::acos(-1.0);
+    tw.resize(count);
+    for (size_t k = 0; k < count; ++k) {
+      const double phase = -2.0 * pi * static_cast<double>(k) / static_cast<double>(n);
+      tw[k] = {static_cast<R>(std::cos(phase)), static_cast<R>(std::sin(phase))};
+    }
+  }
+
+  void init_bluestein() {
+    const double pi = std::acos(-1.0);
+    m_ = size_t{1} << next_pow2(2 * n_ - 1);
+    sub_ = get(m_);
+
+    // chirp[k] = exp(-i*pi*k^2/n), k^2 mod 2n keeps the phase exact
+    chirp_.resize(n_);
+    for (size_t k = 0; k < n_; ++k) {
+      const size_t k2 = static_cast<size_t>((static_cast<unsigned long long>(k) * k) % (2 * n_));
+      const double phase = -pi * static_cast<double>(k2) / static_cast<double>(n_);
+      chirp_[k] = {static_cast<R>(std::cos(phase)), static_cast<R>(std::sin(phase))};
+    }
+
+    // conj(DFT(conj(chirp) wrapped around)) / m: inverse DFT is done via conj
+    using E = impl_fft::Cx<R>;
+    std::vector<E> h(m_, impl_fft::zero<E>()), hf(m_);
+    for (size_t k = 0; k < n_; ++k) {
+      h[k] = {chirp_[k].real(), -chirp_[k].imag()};
+      if (k) { h[m_ - k] = h[k]; }
+    }
+    sub_->exec(h.data(), hf.data(), static_cast<E*>(nullptr));
+    filter_.resize(m_);
+    const R scale = R{1} / static_cast<R>(m_);
+    for (size_t k = 0; k < m_; ++k) { filter_[k] = {hf[k].re * scale, -hf[k].im * scale}; }
+  }
+
+  // KissFFT-style recursive decimation in time
+  template<typename E>
+  void work_(E* out, const E* f, size_t fstride, const size_t* factors) const noexcept {
+    const size_t p = factors[0], m = factors[1];
+    E* const beg = out;
+    E* const end = out + p * m;
+    if (m == 1) {
+      do { *out = *f; f += fstride; } while (++out != end);
+    }
+    else {
+      do { work_(out, f, fstride * p, factors + 2); f += fstride; } while ((out += m) != end);
+    }
+    switch (p) {
+      case 2: bfly2(beg, fstride, m); break;
+      case 3: bfly3(beg, fstride, m); break;
+      case 4: bfly4(beg, fstride, m); break;
+      case 5: bfly5(beg, fstride, m); break;
+      default: bflyp(beg, fstride, m, p); break;
+    }
+  }
+
+  template<typename E>
+  void bfly2(E* f, size_t fs, size_t m) const noexcept {
+    for (size_t u = 0; u < m; ++u) {
+      const E t = impl_fft::cmul(f[m + u], tw_[u * fs]);
+      f[m + u] = f[u] - t;
+      f[u] += t;
+    }
+  }
+
+  template<typename E>
+  void bfly3(E* f, size_t fs, size_t m) const noexcept {
+    const R epi3 = tw_[fs * m].imag();
+    for (size_t k = 0; k < m; ++k) {
+      const E s1 = impl_fft::cmul(f[k + m], tw_[k * fs]);
+      const E s2 = impl_fft::cmul(f[k + 2 * m], tw_[2 * k * fs]);
+      const E s3 = s1 + s2;
+      const E s0 = impl_fft::rot((s1 - s2) * epi3);
+      const E h = f[k] - s3 * R(0.5);
+      f[k] += s3;
+      f[k + 2 * m] = h + s0;
+      f[k + m] = h - s0;
+    }
+  }
+
+  template<typename E>
+  void bfly4(E* f, size_t fs, size_t m) const noexcept {
+    for (size_t k = 0; k < m; ++k) {
+      const E s0 = impl_fft::cmul(f[k + m], tw_[k * fs]);
+      const E s1 = impl_fft::cmul(f[k + 2 * m], tw_[2 * k * fs]);
+      const E s2 = impl_fft::cmul(f[k + 3 * m], tw_[3 * k * fs]);
+      const E s5 = f[k] - s1;
+      const E f0 = f[k] + s1;
+      const E s3 = s0 + s2;
+      const E s4 = impl_fft::rot(s0 - s2);
+      f[k + 2 * m] = f0 - s3;
+      f[k] = f0 + s3;
+      f[k + m] = s5 + s4;
+      f[k + 3 * m] = s5 - s4;
+    }
+  }
+
+  template<typename E>
+  void bfly5(E* f, size_t fs, size_t m) const noexcept {
+    const complex_t ya = tw_[fs * m], yb = tw_[fs * 2 * m];
+    for (size_t u = 0; u < m; ++u) {
+      const E s0 = f[u];
+      const E s1 = impl_fft::cmul(f[u + m], tw_[u * fs]);
+      const E s2 = impl_fft::cmul(f[u + 2 * m], tw_[2 * u * fs]);
+      const E s3 = impl_fft::cmul(f[u + 3 * m], tw_[3 * u * fs]);
+      const E s4 = impl_fft::cmul(f[u + 4 * m], tw_[4 * u * fs]);
+      const E s7 = s1 + s4, s10 = s1 - s4, s8 = s2 + s3, s9 = s2 - s3;
+
+      f[u] = s0 + s7 + s8;
+      const E s5 = s0 + s7 * ya.real() + s8 * yb.real();
+      const E s6 = impl_fft::rot(s10 * ya.imag() + s9 * yb.imag());
+      f[u + m] = s5 - s6;
+      f[u + 4 * m] = s5 + s6;
+      const E s11 = s0 + s7 * yb.real() + s8 * ya.real();
+      const E s12 = impl_fft::rot(s9 * ya.imag() - s10 * yb.imag());
+      f[u + 2 * m] = s11 + s12;
+      f[u + 3 * m] = s11 - s12;
+    }
+  }
+
+  template<typename E>
+  void bflyp(E* f, size_t fs, size_t m, size_t p) const noexcept {
+    assert(p <= impl_fft::k_max_radix);
+    E scratch[impl_fft::k_max_radix];
+    for (size_t u = 0; u < m; ++u) {
+      for (size_t q = 0, k = u; q < p; ++q, k += m) { scratch[q] = f[k]; }
+      for (size_t q = 0, k = u; q < p; ++q, k += m) {
+        size_t twi = 0;
+        f[k] = scratch[0];
+        for (size_t j = 1; j < p; ++j) {
+          twi += fs * k;
+          if (twi >= n_) { twi -= n_; }
+          f[k] += impl_fft::cmul(scratch[j], tw_[twi]);
+        }
+      }
+    }
+  }
+
+  size_t n_;
+  std::vector<size_t> factors_;
+  std::vector<complex_t> tw_;
+  std::vector<complex_t> rtw_;
+
+  // Bluestein
+  size_t m_ = 0;
+  std::shared_ptr<const FftPlan_> sub_;
+  std::vector<complex_t> chirp_;
+  std::vector<complex_t> filter_;
+};
+
+using FftPlanF = FftPlan_<float>;
+using FftPlanD = FftPlan_<double>;
+
+
+namespace impl_fft {
+
+enum class Kind { forward, inverse, r2c, c2r };
+
+template<typename T> struct real_type { using type = T; };
+template<typename T> struct real_type<std::complex<T>> { using type = T; };
+
+// batch of 1D lines along `Axis`: element k of line j is at
+// src + soff[j] + k*ss, dst + doff[j] + k*ds
+template<typename TS, typename TD>
+struct Lines {
+  const TS* src = nullptr;
+  TD* dst = nullptr;
+  ptrdiff_t ss = 0, ds = 0;
+  size_t ns = 0, nd = 0;
+  std::vector<std::pair<ptrdiff_t, ptrdiff_t>> off;
+};
+
+// lines in memory order of src, neighbours along the most data-local dim
+template<size_t Axis, class D0, typename TD, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename TS, MOrder MOrderT1, typename IntT1>
+Lines<std::remove_const_t<TS>, TD> lines(NArrayInterface_<D0, TD, ND, MOrderT0, IntT0>& dst,
+                                         const NArrayInterface_<D1, TS, ND, MOrderT1, IntT1>& src) {
+  Lines<std::remove_const_t<TS>, TD> out;
+  out.src = src.ptr();
+  out.dst = dst.ptr();
+  out.ss = static_cast<ptrdiff_t>(src.stride()[Axis]);
+  out.ds = static_cast<ptrdiff_t>(dst.stride()[Axis]);
+  out.ns = src.shape()[Axis];
+  out.nd = dst.shape()[Axis];
+
+  auto shape = src.shape();
+  shape[Axis] = 1;
+  if (shape.numel() == 0) { return out; }
+  out.off.reserve(shape.numel());
+
+  size_t index[ND] = {};
+  do {
+    out.off.emplace_back(hidx::conv(index, src.stride().begin(), ND, ptrdiff_t{0}),
+                         hidx::conv(index, dst.stride().begin(), ND, ptrdiff_t{0}));
+  } while (hidx::next_outer<MOrderT1>(index, shape.begin(), ND, 0));
+  return out;
+}
+
+template<typename R> void put(std::complex<R>& y, R re, R im) noexcept { y = {re, im}; }
+template<typename R> void put(R& y, R re, R) noexcept { y = re; }
+
+// Transforms lines [j0, j1) W at a time. Real transforms of even length 2n
+// run a complex transform of length n on z[k] = x[2k] + i*x[2k+1],
+// odd lengths the full complex transform.
+template<Kind K, size_t W, typename R, typename TS, typename TD>
+void run_lanes(const FftPlan_<R>& plan, const Lines<TS, TD>& ls, size_t j0, size_t j1, bool packed) {
+  using E = elem_t<R, W>;
+  const size_t n = plan.size(), h = n / 2;
+  const std::complex<R>* rtw = plan.rtwiddles();
+  std::vector<E> in(n + 1), out(n + 1), work(plan.worksize());
+  R re[W], im[W];
+
+  for (size_t j = j0; j + W <= j1; j += W) {
+    const TS* s[W];
+    TD* d[W];
+    for (size_t w = 0; w < W; ++w) {
+      s[w] = ls.src + ls.off[j + w].first;
+      d[w] = ls.dst + ls.off[j + w].second;
+    }
+    const auto load = [&](size_t k) {
+      for (size_t w = 0; w < W; ++w) {
+        const auto x = s[w][static_cast<ptrdiff_t>(k) * ls.ss];
+        re[w] = std::real(x);
+        im[w] = std::imag(x);
+      }
+      return E::make(re, im);
+    };
+    const auto store = [&](size_t k, const E& y) {
+      y.split(re, im);
+      for (size_t w = 0; w < W; ++w) { put(d[w][static_cast<ptrdiff_t>(k) * ls.ds], re[w], im[w]); }
+    };
+
+    // gather, inverse transforms as conj(DFT(conj(x)))
+    if (K == Kind::forward) {
+      for (size_t k = 0; k < n; ++k) { in[k] = load(k); }
+    }
+    else if (K == Kind::inverse) {
+      for (size_t k = 0; k < n; ++k) { in[k] = conj(load(k)); }
+    }
+    else if (K == Kind::r2c && packed) {
+      for (size_t k = 0; k < n; ++k) {
+        for (size_t w = 0; w < W; ++w) {
+          re[w] = std::real(s[w][static_cast<ptrdiff_t>(2 * k) * ls.ss]);
+          im[w] = std::real(s[w][static_cast<ptrdiff_t>(2 * k + 1) * ls.ss]);
+        }
+        in[k] = E::make(re, im);
+      }
+    }
+    else if (K == Kind::r2c) {
+      for (size_t k = 0; k < n; ++k) { in[k] = load(k); }
+    }
+    else if (packed) {
+      // Z[k] = Fe[k] + i*Fo[k] from the half spectrum X[0..n]
+      for (size_t k = 0; k <= n; ++k) { out[k] = load(k); }
+      for (size_t k = 0; k < n; ++k) {
+        const E xk = out[k], xc = conj(out[n - k]);
+        const E fe = (xk + xc) * R(0.5);
+        const E fo = cmul(xk - xc, std::conj(rtw[k])) * R(0.5);
+        in[k] = conj(fe - rot(fo));
+      }
+    }
+    else {
+      // Hermitian spectrum
+      for (size_t k = 0; k <= h; ++k) {
+        const E x = load(k);
+        in[k] = conj(x);
+        if (k) { in[n - k] = x; }
+      }
+    }
+
+    plan.exec(in.data(), out.data(), work.data());
+
+    // scatter
+    if (K == Kind::forward) {
+      for (size_t k = 0; k < n; ++k) { store(k, out[k]); }
+    }
+    else if (K == Kind::inverse) {
+      const R scale = R{1} / static_cast<R>(n);
+      for (size_t k = 0; k < n; ++k) { store(k, conj(out[k]) * scale); }
+    }
+    else if (K == Kind::r2c && packed) {
+      for (size_t k = 0; k <= n; ++k) {
+        const E zk = out[k % n], zc = conj(out[(n - k) % n]);
+        const E fe = (zk + zc) * R(0.5);
+        const E fo = rot(zk - zc) * R(0.5);
+        store(k, fe + cmul(fo, rtw[k]));
+      }
+    }
+    else if (K == Kind::r2c) {
+      for (size_t k = 0; k <= h; ++k) { store(k, out[k]); }
+    }
+    else if (packed) {
+      const R scale = R{1} / static_cast<R>(n);
+      for (size_t k = 0; k < n; ++k) {
+        out[k].split(re, im);
+        for (size_t w = 0; w < W; ++w) {
+          d[w][static_cast<ptrdiff_t>(2 * k) * ls.ds] = re[w] * scale;
+          d[w][static_cast<ptrdiff_t>(2 * k + 1) * ls.ds] = -im[w] * scale;
+        }
+      }
+    }
+    else {
+      const R scale = R{1} / static_cast<R>(n);
+      for (size_t k = 0; k < n; ++k) { store(k, out[k] * scale); }
+    }
+  }
+}
+
+template<Kind K, typename R, typename TS, typename TD>
+void run(const Lines<TS, TD>& ls, size_t j0, size_t j1) {
+  constexpr bool real = K == Kind::r2c || K == Kind::c2r;
+  const size_t n = K == Kind::c2r ? ls.nd : ls.ns;
+  if (n == 0 || j0 >= j1) { return; }
+  const bool packed = real && n % 2 == 0;
+  const auto plan = FftPlan_<R>::get(packed ? n / 2 : n);
+
+  constexpr size_t W = simd_width<R>();
+  const size_t jw = j0 + (j1 - j0) / W * W;
+  run_lanes<K, W>(*plan, ls, j0, jw, packed);
+  if (W > 1) { run_lanes<K, 1>(*plan, ls, jw, j1, packed); }
+}
+
+// shapes: equal except `Axis`, where c2c: n -> n, r2c: n -> n/2+1, c2r: n/2+1 -> n
+template<Kind K, size_t Axis, typename IntT0, typename IntT1, size_t ND>
+void check(const Index_<IntT0, ND>& dshape, const Index_<IntT1, ND>& sshape, const char* what) {
+  static_assert(Axis < ND, "xmat::fft(): Axis must be less than ND");
+  for (size_t d = 0; d < ND; ++d) {
+    size_t expect = sshape[d];
+    if (d == Axis && K == Kind::r2c) { expect = sshape[d] / 2 + 1; }
+    if (d == Axis && K == Kind::c2r) { expect = dshape[d] / 2 + 1 == sshape[d] ? dshape[d] : size_t(-1); }
+    if (dshape[d] != expect) { throw ShapeError(what); }
+  }
+}
+
+// element types, shapes and the lines of a transform
+template<Kind K, size_t Axis, class D0, typename TD, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename TS, MOrder MOrderT1, typename IntT1>
+Lines<std::remove_const_t<TS>, TD> prepare(NArrayInterface_<D0, TD, ND, MOrderT0, IntT0>& dst,
+                                           const NArrayInterface_<D1, TS, ND, MOrderT1, IntT1>& src) {
+  using R = typename real_type<TD>::type;
+  using S = std::remove_const_t<TS>;
+  static_assert(std::is_floating_point<R>::value, "xmat::fft(): float or double data expected");
+  static_assert(K == Kind::c2r ? std::is_same<TD, R>::value : std::is_same<TD, std::complex<R>>::value,
+                "xmat::fft(): wrong dst type, complex (fft, ifft, rfft) or real (irfft)");
+  static_assert(K == Kind::r2c ? std::is_same<S, R>::value : std::is_same<S, std::complex<R>>::value,
+                "xmat::fft(): wrong src type, complex (fft, ifft, irfft) or real (rfft) of dst's precision");
+  check<K, Axis>(dst.shape(), src.shape(),
+                 K == Kind::r2c ? "xmat::rfft(): dst.shape()[Axis] must be n/2+1 of src" :
+                 K == Kind::c2r ? "xmat::irfft(): src.shape()[Axis] must be n/2+1 of dst" :
+                                  "xmat::fft(): shape mismatch");
+  return lines<Axis>(dst, src);
+}
+
+template<Kind K, size_t Axis, class D0, typename TD, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void transform(NArrayInterface_<D0, TD, ND, MOrderT0, IntT0>& dst, const S& src) {
+  const auto ls = prepare<K, Axis>(dst, src);
+  run<K, typename real_type<TD>::type>(ls, 0, ls.off.size());
+}
+} // namespace impl_fft
+
+
+// complex -> complex along `Axis`
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void fft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src) {
+  impl_fft::transform<impl_fft::Kind::forward, Axis>(dst, src);
+}
+
+// inverse, scaled by 1/n
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void ifft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src) {
+  impl_fft::transform<impl_fft::Kind::inverse, Axis>(dst, src);
+}
+
+// real -> complex, n -> n/2+1 along `Axis`
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void rfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src) {
+  impl_fft::transform<impl_fft::Kind::r2c, Axis>(dst, src);
+}
+
+// complex -> real, n/2+1 -> n along `Axis`, n := dst.shape()[Axis]. scaled by 1/n
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void irfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src) {
+  impl_fft::transform<impl_fft::Kind::c2r, Axis>(dst, src);
+}
+
+// for temporary views: fft<1>(y.view<2>({...}), x)
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void fft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src) { fft<Axis>(dst, src); }
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void ifft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src) { ifft<Axis>(dst, src); }
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void rfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src) { rfft<Axis>(dst, src); }
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void irfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src) { irfft<Axis>(dst, src); }
+
+
+namespace par {
+
+namespace impl_par {
+
+// batch of transforms split into chunks of whole SIMD groups
+template<impl_fft::Kind K, size_t Axis, class D0, typename TD, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void fft(NArrayInterface_<D0, TD, ND, MOrderT0, IntT0>& dst, const S& src, size_t grain, ThreadPool& pool) {
+  using R = typename impl_fft::real_type<TD>::type;
+  const auto ls = impl_fft::prepare<K, Axis>(dst, src);
+  const size_t nlines = ls.off.size();
+  auto pl = plan(nlines * std::max(ls.ns, ls.nd), nlines, grain, pool.size());
+  pl.rows = align_up_(pl.rows, impl_fft::simd_width<R>());
+  pl.nchunk = nlines ? (nlines + pl.rows - 1) / pl.rows : 1;
+
+  pool.parallel_for(pl.nchunk, [&](size_t ch) {
+    const size_t j0 = ch * pl.rows;
+    impl_fft::run<K, R>(ls, j0, std::min(j0 + pl.rows, nlines));
+  });
+}
+} // namespace impl_par
+
+
+// xmat::fft/ifft/rfft/irfft, the batch along the other axes is split between threads
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void fft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src,
+         size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  impl_par::fft<impl_fft::Kind::forward, Axis>(dst, src, grain, pool);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void ifft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src,
+          size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  impl_par::fft<impl_fft::Kind::inverse, Axis>(dst, src, grain, pool);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void rfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src,
+          size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  impl_par::fft<impl_fft::Kind::r2c, Axis>(dst, src, grain, pool);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void irfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src,
+           size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  impl_par::fft<impl_fft::Kind::c2r, Axis>(dst, src, grain, pool);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void fft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src,
+        size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  fft<Axis>(dst, src, grain, pool);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void ifft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src,
+         size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  ifft<Axis>(dst, src, grain, pool);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void rfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src,
+         size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  rfft<Axis>(dst, src, grain, pool);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void irfft(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src,
+          size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  irfft<Axis>(dst, src, grain, pool);
+}
+} // namespace par
+} // namespace xmat
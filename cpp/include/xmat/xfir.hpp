@@ -0,0 +1,375 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+
+#include <complex>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+#include "xlinalg.hpp"
+#include "xfft.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Streaming FIR filter along an axis
+// ------------------------------------------------------------
+//   xmat::FirFilter<std::complex<float>, float> fir{taps};
+//   for (auto& block : blocks) {        // [channels, samples]
+//     fir.apply<1>(y, block);           // y[n] = sum_k taps[k] * x[n-k]
+//   }
+//
+// The last inputs of every line are kept between calls, so consecutive
+// blocks of any size are filtered as one stream. The batch (all positions
+// along the other axes) must not change until reset().
+//
+// Short filters are convolved directly, SIMD across output samples on
+// separate re/im planes. Long ones use overlap-save with a cached FFT plan,
+// SIMD across lines. Polyphase rate change, Rate{U, 1} or Rate{1, D}:
+// interpolation computes U short sub-filters per input, decimation only
+// the kept outputs. Taps are real (H = real type of T) or of type T.
+
+enum class FirMethod { automatic, direct, fft };
+
+// integer rate change: up-sampling by `up` or down-sampling by `down`
+struct Rate {
+  size_t up = 1;
+  size_t down = 1;
+};
+
+namespace impl_fir {
+
+// FirMethod::automatic uses FFT overlap-save above this many taps x real
+// planes convolved (1 real, 2 complex data, 4 complex data and taps)
+constexpr size_t k_fft_taps = 128;
+
+template<typename R> void split(R x, R& re, R&) noexcept { re = x; }
+template<typename R> void split(const std::complex<R>& x, R& re, R& im) noexcept { re = x.real(); im = x.imag(); }
+template<typename R> void join(R& y, R re, R) noexcept { y = re; }
+template<typename R> void join(std::complex<R>& y, R re, R im) noexcept { y = {re, im}; }
+
+// y[m] += sum_k h[k] * x[m*step + k], m < ny
+template<typename R>
+void conv(const R* h, size_t nh, const R* x, size_t step, R* y, size_t ny) noexcept {
+  using V = impl_linalg::Vec<R>;
+  constexpr size_t W = V::width;
+  if (step == 1) {
+    // 4 vectors of outputs in registers, taps broadcast
+    size_t m = 0;
+    for (; m + 4 * W <= ny; m += 4 * W) {
+      auto a0 = V::load(y + m), a1 = V::load(y + m + W), a2 = V::load(y + m + 2 * W), a3 = V::load(y + m + 3 * W);
+      const R* xm = x + m;
+      for (size_t k = 0; k < nh; ++k) {
+        const auto hk = V::set1(h[k]);
+        a0 = V::madd(hk, V::load(xm + k), a0);
+        a1 = V::madd(hk, V::load(xm + k + W), a1);
+        a2 = V::madd(hk, V::load(xm + k + 2 * W), a2);
+        a3 = V::madd(hk, V::load(xm + k + 3 * W), a3);
+      }
+      V::store(y + m, a0);
+      V::store(y + m + W, a1);
+      V::store(y + m + 2 * W, a2);
+      V::store(y + m + 3 * W, a3);
+    }
+    for (; m < ny; ++m) {
+      R s = y[m];
+      for (size_t k = 0; k < nh; ++k) { s += h[k] * x[m + k]; }
+      y[m] = s;
+    }
+    return;
+  }
+  // decimation: one dot product per output
+  for (size_t m = 0; m < ny; ++m) {
+    const R* xm = x + m * step;
+    auto acc = V::zero();
+    size_t k = 0;
+    for (; k + W <= nh; k += W) { acc = V::madd(V::load(h + k), V::load(xm + k), acc); }
+    R lanes[W];
+    V::store(lanes, acc);
+    R s = y[m];
+    for (size_t w = 0; w < W; ++w) { s += lanes[w]; }
+    for (; k < nh; ++k) { s += h[k] * xm[k]; }
+    y[m] = s;
+  }
+}
+} // namespace impl_fir
+
+
+template<typename T, typename H = T>
+class FirFilter_ {
+ public:
+  using value_type = T;
+  using tap_type = H;
+  using real_t = typename impl_fft::real_type<T>::type;
+
+  static_assert(std::is_floating_point<real_t>::value,
+                "xmat::FirFilter_: float, double or their complex expected");
+  static_assert(std::is_same<H, T>::value || std::is_same<H, real_t>::value,
+                "xmat::FirFilter_: taps must be of type T or its real type");
+
+  explicit FirFilter_(std::vector<H> taps, FirMethod method = FirMethod::automatic)
+  : FirFilter_(std::move(taps), Rate{}, method) { }
+
+  FirFilter_(std::vector<H> taps, Rate rate, FirMethod method = FirMethod::automatic)
+  : taps_(std::move(taps)), rate_(rate) {
+    if (taps_.empty()) { throw std::invalid_argument("xmat::FirFilter_: no taps"); }
+    if (rate_.up == 0 || rate_.down == 0 || (rate_.up > 1 && rate_.down > 1)) {
+      throw std::invalid_argument("xmat::FirFilter_: Rate{up, 1} or Rate{1, down} expected");
+    }
+    const bool resample = rate_.up > 1 || rate_.down > 1;
+    if (method == FirMethod::fft && resample) {
+      throw std::invalid_argument("xmat::FirFilter_: polyphase filters are direct");
+    }
+    method_ = method != FirMethod::automatic ? method :
+              !resample && taps_.size() * nplanes() > impl_fir::k_fft_taps ? FirMethod::fft : FirMethod::direct;
+
+    if (method_ == FirMethod::fft) { init_fft(); }
+    else { init_direct(); }
+  }
+
+  size_t ntaps() const noexcept { return taps_.size(); }
+  const std::vector<H>& taps() const noexcept { return taps_; }
+  FirMethod method() const noexcept { return method_; }
+  Rate rate() const noexcept { return rate_; }
+
+  // outputs of the next block of n inputs
+  size_t out_size(size_t n) const noexcept {
+    if (rate_.up > 1) { return n * rate_.up; }
+    if (rate_.down > 1) { return n > phase_ ? (n - phase_ + rate_.down - 1) / rate_.down : 0; }
+    return n;
+  }
+
+  // forget the stream: zero history, any batch shape
+  void reset() noexcept {
+    state_.clear();
+    nlines_ = 0;
+    phase_ = 0;
+  }
+
+  // filter the next block along `Axis`, dst.shape()[Axis] == out_size(src.shape()[Axis])
+  template<size_t Axis, class D0, size_t ND, MOrder MOrderT0, typename IntT0,
+           class D1, typename TS, MOrder MOrderT1, typename IntT1>
+  void apply(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst,
+             const NArrayInterface_<D1, TS, ND, MOrderT1, IntT1>& src) {
+    static_assert(Axis < ND, "xmat::FirFilter_::apply(): Axis must be less than ND");
+    static_assert(std::is_same<std::remove_const_t<TS>, T>::value,
+                  "xmat::FirFilter_::apply(): src and dst must be of the filter's value_type");
+    for (size_t d = 0; d < ND; ++d) {
+      const size_t expect = d == Axis ? out_size(src.shape()[d]) : src.shape()[d];
+      if (dst.shape()[d] != expect) {
+        throw ShapeError("xmat::FirFilter_::apply(): dst.shape()[Axis] must be out_size(n), other dims equal");
+      }
+    }
+
+    const auto ls = impl_fft::lines<Axis>(dst, src);
+    if (state_.empty() && nlines_ == 0) {
+      nlines_ = ls.off.size();
+      state_.assign(nlines_ * hist(), T{0});
+    }
+    else if (ls.off.size() != nlines_) {
+      throw ShapeError("xmat::FirFilter_::apply(): the batch has changed, reset() the filter");
+    }
+    if (ls.ns == 0 || nlines_ == 0) { return; }
+
+    if (method_ == FirMethod::fft) {
+      constexpr size_t W = impl_fft::simd_width<real_t>();
+      const size_t jw = nlines_ / W * W;
+      run_fft<W>(ls, 0, jw);
+      if (W > 1) { run_fft<1>(ls, jw, nlines_); }
+    }
+    else {
+      run_direct(ls);
+    }
+    if (rate_.down > 1) { phase_ = phase_ + ls.nd * rate_.down - ls.ns; }
+  }
+
+  template<size_t Axis, class D0, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+  void apply(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src) {
+    apply<Axis>(dst, src);
+  }
+
+ private:
+  static constexpr bool k_complex = !std::is_same<T, real_t>::value;
+  static constexpr bool k_complex_taps = !std::is_same<H, real_t>::value;
+
+  // inputs kept per line
+  size_t hist() const noexcept { return nh_ - 1; }
+
+  static constexpr size_t nplanes() noexcept { return k_complex_taps ? 4 : k_complex ? 2 : 1; }
+
+  // reversed taps as re/im planes, sub-filter p of the polyphase
+  // interpolator at p*nh_: taps[j*U + p], zero padded
+  void init_direct() {
+    const size_t up = rate_.up, nt = taps_.size();
+    nh_ = (nt + up - 1) / up;
+    hre_.assign(up * nh_, real_t{0});
+    him_.assign(up * nh_, real_t{0});
+    hneg_.assign(up * nh_, real_t{0});
+    for (size_t p = 0; p < up; ++p) {
+      for (size_t j = 0; j < nh_ && j * up + p < nt; ++j) {
+        real_t re{0}, im{0};
+        impl_fir::split(taps_[j * up + p], re, im);
+        hre_[p * nh_ + nh_ - 1 - j] = re;
+        him_[p * nh_ + nh_ - 1 - j] = im;
+        hneg_[p * nh_ + nh_ - 1 - j] = -im;
+      }
+    }
+  }
+
+  // overlap-save: transforms of m_ >= 4*ntaps, m_ - ntaps + 1 new outputs each
+  void init_fft() {
+    using E = impl_fft::Cx<real_t>;
+    nh_ = taps_.size();
+    m_ = size_t{1} << next_pow2(std::max<size_t>(4 * nh_, 64));
+    plan_ = FftPlan_<real_t>::get(m_);
+
+    std::vector<E> h(m_, impl_fft::zero<E>()), hf(m_), work(plan_->worksize());
+    for (size_t k = 0; k < nh_; ++k) { impl_fir::split(taps_[k], h[k].re, h[k].im); }
+    plan_->exec(h.data(), hf.data(), work.data());
+    hf_.resize(m_);
+    const real_t scale = real_t{1} / static_cast<real_t>(m_);
+    for (size_t k = 0; k < m_; ++k) { hf_[k] = {hf[k].re * scale, hf[k].im * scale}; }
+  }
+
+  // y += taps (p-th sub-filter) * x, on re/im planes
+  void conv(size_t p, const real_t* xr, const real_t* xi, size_t step,
+            real_t* yr, real_t* yi, size_t ny) const noexcept {
+    const real_t* hr = hre_.data() + p * nh_;
+    impl_fir::conv(hr, nh_, xr, step, yr, ny);
+    if (k_complex) { impl_fir::conv(hr, nh_, xi, step, yi, ny); }
+    if (k_complex_taps) {
+      impl_fir::conv(hneg_.data() + p * nh_, nh_, xi, step, yr, ny);
+      impl_fir::conv(him_.data() + p * nh_, nh_, xr, step, yi, ny);
+    }
+  }
+
+  // one line at a time: history and block into planes, filter, scatter
+  template<typename TS, typename TD>
+  void run_direct(const impl_fft::Lines<TS, TD>& ls) {
+    const size_t nh = hist(), n = ls.ns, nout = ls.nd, up = rate_.up;
+    std::vector<real_t> xr(nh + n), xi(k_complex ? nh + n : 0);
+    std::vector<real_t> yr(std::max(nout, n)), yi(k_complex ? yr.size() : 0);
+    std::vector<real_t> pr(up > 1 ? n : 0), pi(up > 1 && k_complex ? n : 0);
+    real_t dummy{0};
+
+    for (size_t j = 0; j < nlines_; ++j) {
+      const TS* s = ls.src + ls.off[j].first;
+      TD* d = ls.dst + ls.off[j].second;
+      T* st = state_.data() + j * nh;
+      real_t* xi_ = k_complex ? xi.data() : nullptr;
+      real_t* yi_ = k_complex ? yi.data() : nullptr;
+
+      for (size_t k = 0; k < nh; ++k) { impl_fir::split(st[k], xr[k], k_complex ? xi[k] : dummy); }
+      for (size_t k = 0; k < n; ++k) {
+        impl_fir::split(s[static_cast<ptrdiff_t>(k) * ls.ss], xr[nh + k], k_complex ? xi[nh + k] : dummy);
+      }
+
+      std::fill(yr.begin(), yr.end(), real_t{0});
+      std::fill(yi.begin(), yi.end(), real_t{0});
+      if (up > 1) {
+        for (size_t p = 0; p < up; ++p) {
+          std::fill(pr.begin(), pr.end(), real_t{0});
+          std::fill(pi.begin(), pi.end(), real_t{0});
+          conv(p, xr.data(), xi_, 1, pr.data(), k_complex ? pi.data() : nullptr, n);
+          for (size_t m = 0; m < n; ++m) {
+            yr[m * up + p] = pr[m];
+            if (k_complex) { yi[m * up + p] = pi[m]; }
+          }
+        }
+      }
+      else {
+        conv(0, xr.data() + phase_, k_complex ? xi_ + phase_ : nullptr, rate_.down, yr.data(), yi_, nout);
+      }
+
+      for (size_t k = 0; k < nout; ++k) {
+        impl_fir::join(d[static_cast<ptrdiff_t>(k) * ls.ds], yr[k], k_complex ? yi[k] : real_t{0});
+      }
+      for (size_t k = 0; k < nh; ++k) {
+        impl_fir::join(st[k], xr[n + k], k_complex ? xi[n + k] : real_t{0});
+      }
+    }
+  }
+
+  // W lines at a time in SIMD lanes, segments of m_ inputs overlap by ntaps-1
+  template<size_t W, typename TS, typename TD>
+  void run_fft(const impl_fft::Lines<TS, TD>& ls, size_t j0, size_t j1) {
+    using E = impl_fft::elem_t<real_t, W>;
+    const size_t nh = hist(), n = ls.ns, len = nh + n, hop = m_ - nh;
+    std::vector<real_t> xr(W * len), xi(W * len);
+    std::vector<E> a(m_), b(m_), work(plan_->worksize());
+    real_t re[W], im[W];
+
+    for (size_t j = j0; j + W <= j1; j += W) {
+      for (size_t w = 0; w < W; ++w) {
+        const TS* s = ls.src + ls.off[j + w].first;
+        const T* st = state_.data() + (j + w) * nh;
+        real_t* r = xr.data() + w * len;
+        real_t* i = xi.data() + w * len;
+        for (size_t k = 0; k < nh; ++k) { i[k] = real_t{0}; impl_fir::split(st[k], r[k], i[k]); }
+        for (size_t k = 0; k < n; ++k) {
+          i[nh + k] = real_t{0};
+          impl_fir::split(s[static_cast<ptrdiff_t>(k) * ls.ss], r[nh + k], i[nh + k]);
+        }
+      }
+
+      for (size_t pos = 0; pos < n; pos += hop) {
+        for (size_t k = 0; k < m_; ++k) {
+          if (pos + k < len) {
+            for (size_t w = 0; w < W; ++w) { re[w] = xr[w * len + pos + k]; im[w] = xi[w * len + pos + k]; }
+            a[k] = E::make(re, im);
+          }
+          else {
+            a[k] = impl_fft::zero<E>();
+          }
+        }
+        plan_->exec(a.data(), b.data(), work.data());
+        for (size_t k = 0; k < m_; ++k) { b[k] = impl_fft::conj(impl_fft::cmul(b[k], hf_[k])); }
+        plan_->exec(b.data(), a.data(), work.data());
+
+        const size_t cnt = std::min(hop, n - pos);
+        for (size_t k = 0; k < cnt; ++k) {
+          a[nh + k].split(re, im);
+          for (size_t w = 0; w < W; ++w) {
+            TD* d = ls.dst + ls.off[j + w].second;
+            impl_fir::join(d[static_cast<ptrdiff_t>(pos + k) * ls.ds], re[w], -im[w]);
+          }
+        }
+      }
+
+      for (size_t w = 0; w < W; ++w) {
+        T* st = state_.data() + (j + w) * nh;
+        for (size_t k = 0; k < nh; ++k) { impl_fir::join(st[k], xr[w * len + n + k], xi[w * len + n + k]); }
+      }
+    }
+  }
+
+  std::vector<H> taps_;
+  Rate rate_;
+  FirMethod method_ = FirMethod::direct;
+  size_t nh_ = 0;  // taps per (sub-)filter
+
+  // direct: reversed taps, him_ negated in hneg_
+  std::vector<real_t> hre_, him_, hneg_;
+
+  // overlap-save
+  size_t m_ = 0;
+  std::shared_ptr<const FftPlan_<real_t>> plan_;
+  std::vector<std::complex<real_t>> hf_;
+
+  // stream state: nlines_ x hist() last inputs, next decimated output
+  std::vector<T> state_;
+  size_t nlines_ = 0;
+  size_t phase_ = 0;
+};
+
+template<typename T, typename H = T>
+using FirFilter = FirFilter_<T, H>;
+} // namespace xmat
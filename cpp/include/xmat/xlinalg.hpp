@@ -0,0 +1,500 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cstdlib>
+
+#include <complex>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XMAT_LINALG_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+#include "xthreadpool.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Matrix products over 2D/1D arrays and views
+// ------------------------------------------------------------
+//   xmat::matmul(C, A, B);                  // C = A*B
+//   xmat::gemm(C, A, B, alpha, beta);       // C = alpha*A*B + beta*C
+//   xmat::gemv(y, A, x, alpha, beta);       // y = alpha*A*x + beta*y
+//
+// Operands may have any strides: C- and F-order arrays, strided and
+// transposed views (`a.permute({1, 0})`) are used in place. C must not
+// overlap A or B.
+//
+// gemm is cache-blocked as in GotoBLAS: KCxNC panels of B and MCxKC panels
+// of A are packed into contiguous buffers, an MRxNR register tile of C is
+// computed by a micro-kernel. Complex operands are packed as separate
+// real/imag planes, so float, double, complex<float> and complex<double>
+// share the same SIMD kernels. Threaded versions at the end: xmat::par::gemm/matmul().
+namespace impl_linalg {
+
+template<typename T> struct is_complex : std::false_type { };
+template<typename T> struct is_complex<std::complex<T>> : std::true_type { };
+
+// vector of W lanes: scalar fallback
+template<typename R>
+struct Vec {
+  using type = R;
+  static constexpr size_t width = 1;
+
+  static type zero() noexcept { return R{0}; }
+  static type set1(R x) noexcept { return x; }
+  static type load(const R* p) noexcept { return *p; }
+  static void store(R* p, type v) noexcept { *p = v; }
+  static type madd(type a, type b, type c) noexcept { return c + a * b; }  // c + a*b
+  static type msub(type a, type b, type c) noexcept { return c - a * b; }  // c - a*b
+};
+
+#if defined(XMAT_LINALG_SSE2)
+template<>
+struct Vec<float> {
+  using type = __m128;
+  static constexpr size_t width = 4;
+
+  static type zero() noexcept { return _mm_setzero_ps(); }
+  static type set1(float x) noexcept { return _mm_set1_ps(x); }
+  static type load(const float* p) noexcept { return _mm_loadu_ps(p); }
+  static void store(float* p, type v) noexcept { _mm_storeu_ps(p, v); }
+  static type madd(type a, type b, type c) noexcept { return _mm_add_ps(c, _mm_mul_ps(a, b)); }
+  static type msub(type a, type b, type c) noexcept { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+};
+
+template<>
+struct Vec<double> {
+  using type = __m128d;
+  static constexpr size_t width = 2;
+
+  static type zero() noexcept { return _mm_setzero_pd(); }
+  static type set1(double x) noexcept { return _mm_set1_pd(x); }
+  static type load(const double* p) noexcept { return _mm_loadu_pd(p); }
+  static void store(double* p, type v) noexcept { _mm_storeu_pd(p, v); }
+  static type madd(type a, type b, type c) noexcept { return _mm_add_pd(c, _mm_mul_pd(a, b)); }
+  static type msub(type a, type b, type c) noexcept { return _mm_sub_pd(c, _mm_mul_pd(a, b)); }
+};
+#endif
+
+
+// Blocking parameters.
+// R - real type of packed buffers, CW - 2 for complex (re/im planes)
+// MR x NR tile keeps MR*NR/W (x2 for complex) accumulators in registers.
+template<typename T>
+struct Gemm {
+  using real_t = T;
+  static constexpr size_t CW = 1;
+  static constexpr size_t MR = 4;
+  static constexpr size_t NR = sizeof(T) == 4 ? 8 : 4;
+  static constexpr size_t KC = 256;
+  static constexpr size_t MC = 96;
+  static constexpr size_t NC = 2048;
+};
+
+template<typename T>
+struct Gemm<std::complex<T>> {
+  using real_t = T;
+  static constexpr size_t CW = 2;
+  static constexpr size_t MR = sizeof(T) == 4 ? 4 : 2;
+  static constexpr size_t NR = 4;
+  static constexpr size_t KC = 256;
+  static constexpr size_t MC = 96;
+  static constexpr size_t NC = 1024;
+};
+
+
+// element <-> packed planes
+template<typename R>
+void put(R* p, size_t, const R& x) noexcept { *p = x; }
+
+template<typename R>
+void put(R* p, size_t im, const std::complex<R>& x) noexcept { p[0] = x.real(); p[im] = x.imag(); }
+
+template<typename T, typename R, std::enable_if_t<!is_complex<T>::value, int> = 0>
+T get(const R* p, size_t) noexcept { return *p; }
+
+template<typename T, typename R, std::enable_if_t<is_complex<T>::value, int> = 0>
+T get(const R* p, size_t im) noexcept { return {p[0], p[im]}; }
+
+
+// A[mc, kc] -> panels of MR rows: [panel][k][plane][MR], zero-padded
+template<typename T>
+void pack_a(const T* a, ptrdiff_t rs, ptrdiff_t cs, size_t mc, size_t kc,
+            typename Gemm<T>::real_t* out) noexcept {
+  constexpr size_t MR = Gemm<T>::MR, CW = Gemm<T>::CW;
+  for (size_t i0 = 0; i0 < mc; i0 += MR) {
+    const size_t mr = std::min(MR, mc - i0);
+    for (size_t k = 0; k < kc; ++k, out += MR * CW) {
+      const T* ak = a + static_cast<ptrdiff_t>(i0) * rs + static_cast<ptrdiff_t>(k) * cs;
+      size_t r = 0;
+      for (; r < mr; ++r) { put(out + r, MR, ak[static_cast<ptrdiff_t>(r) * rs]); }
+      for (; r < MR; ++r) { put(out + r, MR, T{0}); }
+    }
+  }
+}
+
+// B[kc, nc] -> panels of NR columns: [panel][k][plane][NR], zero-padded
+template<typename T>
+void pack_b(const T* b, ptrdiff_t rs, ptrdiff_t cs, size_t kc, size_t nc,
+            typename Gemm<T>::real_t* out) noexcept {
+  constexpr size_t NR = Gemm<T>::NR, CW = Gemm<T>::CW;
+  for (size_t j0 = 0; j0 < nc; j0 += NR) {
+    const size_t nr = std::min(NR, nc - j0);
+    for (size_t k = 0; k < kc; ++k, out += NR * CW) {
+      const T* bk = b + static_cast<ptrdiff_t>(k) * rs + static_cast<ptrdiff_t>(j0) * cs;
+      size_t c = 0;
+      for (; c < nr; ++c) { put(out + c, NR, bk[static_cast<ptrdiff_t>(c) * cs]); }
+      for (; c < NR; ++c) { put(out + c, NR, T{0}); }
+    }
+  }
+}
+
+
+// f(0), ..., f(N-1) unrolled at compile time: keeps the accumulators of
+// the register tile in registers without relying on -O3 loop unrolling
+template<size_t N>
+struct Unroll {
+  template<typename F>
+  static void run(F&& f) { Unroll<N - 1>::run(f); f(N - 1); }
+};
+
+template<>
+struct Unroll<0> {
+  template<typename F>
+  static void run(F&&) { }
+};
+
+
+// tile[MR][NR] = sum_k a[k][:] x b[k][:]
+template<typename R, size_t MR, size_t NR>
+void kernel(size_t kc, const R* a, const R* b, R* tile) noexcept {
+  using V = Vec<R>;
+  constexpr size_t W = V::width, NV = NR / W;
+  static_assert(NR % W == 0, "xmat::impl_linalg::kernel(): NR must be a multiple of the SIMD width");
+
+  typename V::type acc[MR][NV];
+  Unroll<MR * NV>::run([&](size_t i) { acc[i / NV][i % NV] = V::zero(); });
+  for (size_t k = 0; k < kc; ++k, a += MR, b += NR) {
+    typename V::type bv[NV];
+    Unroll<NV>::run([&](size_t v) { bv[v] = V::load(b + v * W); });
+    Unroll<MR>::run([&](size_t r) {
+      const auto ar = V::set1(a[r]);
+      Unroll<NV>::run([&](size_t v) { acc[r][v] = V::madd(ar, bv[v], acc[r][v]); });
+    });
+  }
+  Unroll<MR * NV>::run([&](size_t i) { V::store(tile + i * W, acc[i / NV][i % NV]); });
+}
+
+// complex: planes re/im for a, b and tile
+template<typename R, size_t MR, size_t NR>
+void kernel_cx(size_t kc, const R* a, const R* b, R* tile) noexcept {
+  using V = Vec<R>;
+  constexpr size_t W = V::width, NV = NR / W;
+  static_assert(NR % W == 0, "xmat::impl_linalg::kernel_cx(): NR must be a multiple of the SIMD width");
+
+  typename V::type re[MR][NV], im[MR][NV];
+  Unroll<MR * NV>::run([&](size_t i) { re[i / NV][i % NV] = im[i / NV][i % NV] = V::zero(); });
+  for (size_t k = 0; k < kc; ++k, a += 2 * MR, b += 2 * NR) {
+    typename V::type bre[NV], bim[NV];
+    Unroll<NV>::run([&](size_t v) {
+      bre[v] = V::load(b + v * W);
+      bim[v] = V::load(b + NR + v * W);
+    });
+    Unroll<MR>::run([&](size_t r) {
+      const auto ar = V::set1(a[r]);
+      const auto ai = V::set1(a[MR + r]);
+      Unroll<NV>::run([&](size_t v) {
+        re[r][v] = V::msub(ai, bim[v], V::madd(ar, bre[v], re[r][v]));
+        im[r][v] = V::madd(ai, bre[v], V::madd(ar, bim[v], im[r][v]));
+      });
+    });
+  }
+  Unroll<MR * NV>::run([&](size_t i) {
+    V::store(tile + i * W, re[i / NV][i % NV]);
+    V::store(tile + MR * NR + i * W, im[i / NV][i % NV]);
+  });
+}
+
+template<typename T, std::enable_if_t<!is_complex<T>::value, int> = 0>
+void micro(size_t kc, const typename Gemm<T>::real_t* a,
+           const typename Gemm<T>::real_t* b, typename Gemm<T>::real_t* tile) noexcept {
+  kernel<typename Gemm<T>::real_t, Gemm<T>::MR, Gemm<T>::NR>(kc, a, b, tile);
+}
+
+template<typename T, std::enable_if_t<is_complex<T>::value, int> = 0>
+void micro(size_t kc, const typename Gemm<T>::real_t* a,
+           const typename Gemm<T>::real_t* b, typename Gemm<T>::real_t* tile) noexcept {
+  kernel_cx<typename Gemm<T>::real_t, Gemm<T>::MR, Gemm<T>::NR>(kc, a, b, tile);
+}
+
+
+// C[m, n] *= beta, beta == 0 overwrites (NaN in C are not propagated)
+template<typename T>
+void scale(T* c, ptrdiff_t rs, ptrdiff_t cs, size_t m, size_t n, const T& beta) noexcept {
+  if (beta == T{1}) { return; }
+  for (size_t i = 0; i < m; ++i) {
+    T* ci = c + static_cast<ptrdiff_t>(i) * rs;
+    for (size_t j = 0; j < n; ++j) {
+      T& x = ci[static_cast<ptrdiff_t>(j) * cs];
+      x = beta == T{0} ? T{0} : x * beta;
+    }
+  }
+}
+
+// C = alpha*A*B + beta*C, A[m, k], B[k, n], strides in elements
+template<typename T>
+void gemm(size_t m, size_t n, size_t k, const T& alpha,
+          const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+          const T* b, ptrdiff_t rsb, ptrdiff_t csb,
+          const T& beta, T* c, ptrdiff_t rsc, ptrdiff_t csc) {
+  using G = Gemm<T>;
+  using R = typename G::real_t;
+  constexpr size_t MR = G::MR, NR = G::NR, CW = G::CW;
+  constexpr size_t KC = G::KC, MC = G::MC, NC = G::NC;
+
+  scale(c, rsc, csc, m, n, beta);
+  if (m == 0 || n == 0 || k == 0 || alpha == T{0}) { return; }
+
+  const size_t kcmax = std::min(KC, k);
+  const size_t mcmax = align_up_(std::min(MC, m), MR);
+  const size_t ncmax = align_up_(std::min(NC, n), NR);
+  std::vector<R> abuf(mcmax * kcmax * CW), bbuf(kcmax * ncmax * CW);
+  R tile[MR * NR * CW];
+
+  for (size_t jc = 0; jc < n; jc += NC) {
+    const size_t nc = std::min(NC, n - jc);
+    for (size_t pc = 0; pc < k; pc += KC) {
+      const size_t kc = std::min(KC, k - pc);
+      pack_b(b + static_cast<ptrdiff_t>(pc) * rsb + static_cast<ptrdiff_t>(jc) * csb,
+             rsb, csb, kc, nc, bbuf.data());
+
+      for (size_t ic = 0; ic < m; ic += MC) {
+        const size_t mc = std::min(MC, m - ic);
+        pack_a(a + static_cast<ptrdiff_t>(ic) * rsa + static_cast<ptrdiff_t>(pc) * csa,
+               rsa, csa, mc, kc, abuf.data());
+
+        for (size_t jr = 0; jr < nc; jr += NR) {
+          const size_t nr = std::min(NR, nc - jr);
+          for (size_t ir = 0; ir < mc; ir += MR) {
+            const size_t mr = std::min(MR, mc - ir);
+            micro<T>(kc, abuf.data() + ir * kc * CW, bbuf.data() + jr * kc * CW, tile);
+
+            T* cij = c + static_cast<ptrdiff_t>(ic + ir) * rsc + static_cast<ptrdiff_t>(jc + jr) * csc;
+            for (size_t r = 0; r < mr; ++r) {
+              for (size_t q = 0; q < nr; ++q) {
+                cij[static_cast<ptrdiff_t>(r) * rsc + static_cast<ptrdiff_t>(q) * csc] +=
+                  alpha * get<T>(tile + r * NR + q, MR * NR);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// y = alpha*A*x + beta*y, A[m, n]
+// unit column stride: dot product per row, otherwise axpy per column
+template<typename T>
+void gemv(size_t m, size_t n, const T& alpha,
+          const T* a, ptrdiff_t rsa, ptrdiff_t csa,
+          const T* x, ptrdiff_t sx,
+          const T& beta, T* y, ptrdiff_t sy) {
+  scale(y, sy, 1, m, 1, beta);
+  if (m == 0 || n == 0 || alpha == T{0}) { return; }
+
+  if (csa == 1 || (rsa != 1 && std::abs(csa) <= std::abs(rsa))) {
+    for (size_t i = 0; i < m; ++i) {
+      const T* ai = a + static_cast<ptrdiff_t>(i) * rsa;
+      T s{0};
+      if (csa == 1 && sx == 1) {
+        for (size_t j = 0; j < n; ++j) { s += ai[j] * x[j]; }
+      }
+      else {
+        for (size_t j = 0; j < n; ++j) {
+          s += ai[static_cast<ptrdiff_t>(j) * csa] * x[static_cast<ptrdiff_t>(j) * sx];
+        }
+      }
+      y[static_cast<ptrdiff_t>(i) * sy] += alpha * s;
+    }
+  }
+  else {
+    for (size_t j = 0; j < n; ++j) {
+      const T* aj = a + static_cast<ptrdiff_t>(j) * csa;
+      const T xj = alpha * x[static_cast<ptrdiff_t>(j) * sx];
+      if (rsa == 1 && sy == 1) {
+        for (size_t i = 0; i < m; ++i) { y[i] += aj[i] * xj; }
+      }
+      else {
+        for (size_t i = 0; i < m; ++i) {
+          y[static_cast<ptrdiff_t>(i) * sy] += aj[static_cast<ptrdiff_t>(i) * rsa] * xj;
+        }
+      }
+    }
+  }
+}
+
+template<typename T0, typename T1>
+using same_t = std::is_same<std::remove_const_t<T0>, std::remove_const_t<T1>>;
+} // namespace impl_linalg
+
+
+// C = alpha*A*B + beta*C
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void gemm(NArrayInterface_<DC, T, 2, MOrderC, IntC>& c,
+          const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+          const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b,
+          const T& alpha = T{1}, const T& beta = T{0}) {
+  static_assert(impl_linalg::same_t<T, TA>::value && impl_linalg::same_t<T, TB>::value,
+                "xmat::gemm(): operands must have the same element type");
+  const size_t m = c.shape()[0], n = c.shape()[1], k = a.shape()[1];
+  if (a.shape()[0] != m || b.shape()[0] != k || b.shape()[1] != n) {
+    throw ShapeError("xmat::gemm(): shape mismatch, expected C[m, n], A[m, k], B[k, n]");
+  }
+  impl_linalg::gemm<T>(m, n, k, alpha,
+                       a.ptr(), a.stride()[0], a.stride()[1],
+                       b.ptr(), b.stride()[0], b.stride()[1],
+                       beta, c.ptr(), c.stride()[0], c.stride()[1]);
+}
+
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void gemm(NArrayInterface_<DC, T, 2, MOrderC, IntC>&& c,
+          const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+          const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b,
+          const T& alpha = T{1}, const T& beta = T{0}) {
+  gemm(c, a, b, alpha, beta);
+}
+
+
+// C = A*B
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void matmul(NArrayInterface_<DC, T, 2, MOrderC, IntC>& c,
+            const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+            const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b) {
+  gemm(c, a, b);
+}
+
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void matmul(NArrayInterface_<DC, T, 2, MOrderC, IntC>&& c,
+            const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+            const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b) {
+  gemm(c, a, b);
+}
+
+
+// y = alpha*A*x + beta*y
+template<class DY, typename T, MOrder MOrderY, typename IntY,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DX, typename TX, MOrder MOrderX, typename IntX>
+void gemv(NArrayInterface_<DY, T, 1, MOrderY, IntY>& y,
+          const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+          const NArrayInterface_<DX, TX, 1, MOrderX, IntX>& x,
+          const T& alpha = T{1}, const T& beta = T{0}) {
+  static_assert(impl_linalg::same_t<T, TA>::value && impl_linalg::same_t<T, TX>::value,
+                "xmat::gemv(): operands must have the same element type");
+  const size_t m = y.shape()[0], n = x.shape()[0];
+  if (a.shape()[0] != m || a.shape()[1] != n) {
+    throw ShapeError("xmat::gemv(): shape mismatch, expected y[m], A[m, n], x[n]");
+  }
+  impl_linalg::gemv<T>(m, n, alpha, a.ptr(), a.stride()[0], a.stride()[1],
+                       x.ptr(), x.stride()[0], beta, y.ptr(), y.stride()[0]);
+}
+
+template<class DY, typename T, MOrder MOrderY, typename IntY,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DX, typename TX, MOrder MOrderX, typename IntX>
+void gemv(NArrayInterface_<DY, T, 1, MOrderY, IntY>&& y,
+          const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+          const NArrayInterface_<DX, TX, 1, MOrderX, IntX>& x,
+          const T& alpha = T{1}, const T& beta = T{0}) {
+  gemv(y, a, x, alpha, beta);
+}
+
+
+namespace par {
+
+// C = alpha*A*B + beta*C: rows (or columns if N > M) of C are split into
+// chunks of whole register tiles, every chunk packs its own panels.
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void gemm(NArrayInterface_<DC, T, 2, MOrderC, IntC>& c,
+          const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+          const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b,
+          const T& alpha = T{1}, const T& beta = T{0},
+          size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  static_assert(impl_linalg::same_t<T, TA>::value && impl_linalg::same_t<T, TB>::value,
+                "xmat::par::gemm(): operands must have the same element type");
+  const size_t m = c.shape()[0], n = c.shape()[1], k = a.shape()[1];
+  if (a.shape()[0] != m || b.shape()[0] != k || b.shape()[1] != n) {
+    throw ShapeError("xmat::par::gemm(): shape mismatch, expected C[m, n], A[m, k], B[k, n]");
+  }
+  using G = impl_linalg::Gemm<T>;
+  const bool by_rows = m >= n;
+  const size_t nrows = by_rows ? m : n;
+  const size_t tile = by_rows ? G::MR : G::NR;
+  auto pl = impl_par::plan(m * n * std::max(k, size_t{1}), nrows, grain, pool.size());
+  pl.rows = align_up_(pl.rows, tile);
+  pl.nchunk = nrows ? (nrows + pl.rows - 1) / pl.rows : 1;
+
+  pool.parallel_for(pl.nchunk, [&](size_t ch) {
+    const size_t i0 = ch * pl.rows, len = std::min(i0 + pl.rows, nrows) - i0;
+    const ptrdiff_t da = by_rows ? static_cast<ptrdiff_t>(i0 * a.stride()[0]) : 0;
+    const ptrdiff_t db = by_rows ? 0 : static_cast<ptrdiff_t>(i0 * b.stride()[1]);
+    const ptrdiff_t dc = static_cast<ptrdiff_t>(i0 * c.stride()[by_rows ? 0 : 1]);
+    impl_linalg::gemm<T>(by_rows ? len : m, by_rows ? n : len, k, alpha,
+                         a.ptr() + da, a.stride()[0], a.stride()[1],
+                         b.ptr() + db, b.stride()[0], b.stride()[1],
+                         beta, c.ptr() + dc, c.stride()[0], c.stride()[1]);
+  });
+}
+
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void gemm(NArrayInterface_<DC, T, 2, MOrderC, IntC>&& c,
+          const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+          const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b,
+          const T& alpha = T{1}, const T& beta = T{0},
+          size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  gemm(c, a, b, alpha, beta, grain, pool);
+}
+
+// C = A*B
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void matmul(NArrayInterface_<DC, T, 2, MOrderC, IntC>& c,
+            const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+            const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b,
+            size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  gemm(c, a, b, T{1}, T{0}, grain, pool);
+}
+
+template<class DC, typename T, MOrder MOrderC, typename IntC,
+         class DA, typename TA, MOrder MOrderA, typename IntA,
+         class DB, typename TB, MOrder MOrderB, typename IntB>
+void matmul(NArrayInterface_<DC, T, 2, MOrderC, IntC>&& c,
+            const NArrayInterface_<DA, TA, 2, MOrderA, IntA>& a,
+            const NArrayInterface_<DB, TB, 2, MOrderB, IntB>& b,
+            size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  gemm(c, a, b, T{1}, T{0}, grain, pool);
+}
+} // namespace par
+} // namespace xmat
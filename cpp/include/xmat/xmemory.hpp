@@ -2,11 +2,15 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <array>
 #include <algorithm>
+#include <atomic>
 #include <exception>
 #include <memory>
+#include <mutex>
 #include <type_traits>
 #include <new>
 
@@ -125,7 +129,7 @@ struct MemorySourceBase {
                        size_t* nout, std::nothrow_t) noexcept {
     const size_t np = p() - p_prev();
     if (static_cast<char*>(ptr) != p_prev() || nmin > np + space()) {
-      nout = 0;
+      *nout = 0;
       return nullptr;
     }
     *nout = std::min(nmax, np + space());
@@ -185,11 +189,13 @@ struct TypedMemorySourceBase : protected MSBDerived {
   static constexpr size_t sizeoft = sizeof(T);
 
   T* allocate(size_t n) {
-    return static_cast<T*>(base_t::template allocate_aln<Aln>(sizeoft));
+    return static_cast<T*>(base_t::template allocate_aln<Aln>(sizeoft*n));
   }
 
   T* reserve(size_t nmin, size_t nmax, size_t* nout) {
-    return static_cast<T*>(base_t::reserve(nmin*sizeoft, nmax*sizeoft, sizeoft, nout));
+    T* ptr = static_cast<T*>(base_t::reserve(nmin*sizeoft, nmax*sizeoft, sizeoft, nout));
+    *nout /= sizeoft;
+    return ptr;
   }
 
   T* extend(T* ptr, size_t n) {
@@ -197,7 +203,9 @@ struct TypedMemorySourceBase : protected MSBDerived {
   }
 
   T* extend_reserve(T* ptr, size_t nmin, size_t nmax, size_t* nout) {
-    return static_cast<T*>(base_t::extend_reserve(ptr, nmin*sizeoft, nmax*sizeoft, sizeoft, nout));
+    T* optr = static_cast<T*>(base_t::extend_reserve(ptr, nmin*sizeoft, nmax*sizeoft, sizeoft, nout));
+    *nout /= sizeoft;
+    return optr;
   }
 
   // nothrow-methods
@@ -207,7 +215,7 @@ struct TypedMemorySourceBase : protected MSBDerived {
   }
 
   T* allocate(size_t n, std::nothrow_t) noexcept {
-    return static_cast<T*>(base_t::template allocate_aln<Aln>(sizeoft, std::nothrow));
+    return static_cast<T*>(base_t::template allocate_aln<Aln>(sizeoft*n, std::nothrow));
   }
 
   T* reserve(size_t nmin, size_t nmax, size_t* nout, std::nothrow_t) noexcept {
@@ -287,6 +295,158 @@ struct MemorySourceRef : public MemorySourceBase<MemorySourceRef> {
 };
 
 
+// stack (LIFO) memory source
+// --------------------------
+// Takes blocks from a MemorySource like MemorySourceRef, but every block is
+// preceded by a small header, so deallocate() gives the memory back:
+// freeing the top block rolls p() back to where it was before the block,
+// a block freed out of order is marked and goes back together with the
+// blocks above it. extend() grows the top block in place.
+//   xmat::MemorySource ms{buf, n};
+//   xmat::NArraySMS<float, 2> a{{8, 256}, &ms};
+//   auto m = xmat::MemorySourceStack{&ms}.mark();
+//   ...
+//   xmat::MemorySourceStack{&ms}.rewind(m);       // frees all taken after m
+// From reset() on, all blocks of the MemorySource must be taken through
+// MemorySourceStack, and blocks freed by rewind() must not be deallocated.
+struct MemorySourceStack : public MemorySourceBase<MemorySourceStack> {
+  struct Marker {
+    char* p;
+    char* p_prev;
+  };
+
+  MemorySourceStack() = default;
+
+  MemorySourceStack(MemorySource* memsource) : memsource_{memsource} {}
+
+  void* allocate(size_t n) {
+    void* out = allocate(n, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* allocate(size_t n, size_t aln) {
+    void* out = allocate(n, aln, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  template<size_t Aln>
+  void* allocate_aln(size_t n) {
+    void* out = allocate_aln<Aln>(n, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* reserve(size_t nmin, size_t nmax, size_t factor, size_t* nout) {
+    void* out = reserve(nmin, nmax, factor, nout, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  // nothrow methods
+  // ---------------
+  void* allocate(size_t n, std::nothrow_t) noexcept { return take_(n, 1); }
+
+  void* allocate(size_t n, size_t aln, std::nothrow_t) noexcept {
+    assert((aln & (aln - 1)) == 0 && "Aln must be a pow of 2");
+    return take_(n, aln);
+  }
+
+  template<size_t Aln>
+  void* allocate_aln(size_t n, std::nothrow_t) noexcept {
+    static_assert((Aln & (Aln - 1)) == 0, "Aln must be a pow of 2");
+    return take_(n, Aln);
+  }
+
+  // Returns:
+  //  *nout >= nmin, *nout <= nmax, *nout % factor := 0
+  void* reserve(size_t nmin, size_t nmax, size_t factor,
+                size_t* nout, std::nothrow_t) noexcept {
+    constexpr size_t aln = alignof(std::max_align_t);
+    const size_t pad = pad_(aln);
+    if (pad > space() || space() - pad < nmin) {
+      *nout = 0;
+      return nullptr;
+    }
+    *nout = std::min(nmax, space() - pad);
+    *nout = (*nout / factor) * factor;
+    return take_(*nout, aln);
+  }
+
+  void deallocate(void* ptr, size_t /*n*/) noexcept {
+    if (!ptr) { return; }
+    char* q = static_cast<char*>(ptr);
+    if (q != p_prev()) {
+      Header h = header_(q);
+      h.freed = 1;
+      std::memcpy(q - sizeof(Header), &h, sizeof(Header));
+      return;
+    }
+    do { pop_(); } while (has_block_() && header_(p_prev()).freed);
+  }
+
+  Marker mark() noexcept { return {p(), p_prev()}; }
+
+  void rewind(const Marker& m) noexcept {
+    assert(m.p <= p() && "the mark was rewound already");
+    space() += static_cast<size_t>(p() - m.p);
+    p() = m.p;
+    p_prev() = m.p_prev;
+  }
+
+  // access
+  // ------
+  char*&  buf() noexcept { assert(memsource_); return memsource_->buf(); }
+  size_t& N() noexcept { assert(memsource_); return memsource_->N(); }
+  size_t N() const noexcept { assert(memsource_); return memsource_->N(); }
+  size_t& space() noexcept { assert(memsource_); return memsource_->space(); }
+  size_t space() const noexcept { assert(memsource_); return memsource_->space(); }
+  char*&  p() noexcept { assert(memsource_); return memsource_->p(); }
+  char*&  p_prev() noexcept { assert(memsource_); return memsource_->p_prev(); }
+
+  MemorySource* memsource_ = nullptr;
+
+ private:
+  struct Header {
+    char* top;      // p() before the block
+    char* prev;     // p_prev() before the block
+    size_t freed;
+  };
+
+  static Header header_(const char* q) noexcept {
+    Header h;
+    std::memcpy(&h, q - sizeof(Header), sizeof(Header));
+    return h;
+  }
+
+  bool has_block_() noexcept { return p_prev() >= buf() + sizeof(Header); }
+
+  // bytes from p() to an `aln`-aligned block start, the header included
+  size_t pad_(size_t aln) noexcept {
+    const uintptr_t q = reinterpret_cast<uintptr_t>(p()) + sizeof(Header);
+    return sizeof(Header) + static_cast<size_t>((aln - q % aln) % aln);
+  }
+
+  void* take_(size_t n, size_t aln) noexcept {
+    const size_t pad = pad_(aln);
+    if (pad > space() || n > space() - pad) { return nullptr; }
+    const Header h{p(), p_prev(), 0};
+    char* q = p() + pad;
+    std::memcpy(q - sizeof(Header), &h, sizeof(Header));
+    space() -= pad;
+    return update_(q, n);
+  }
+
+  void pop_() noexcept {
+    const Header h = header_(p_prev());
+    space() += static_cast<size_t>(p() - h.top);
+    p() = h.top;
+    p_prev() = h.prev;
+  }
+};
+
+
 // global no-thread-save memory source
 // -----------------------------------
 struct MemorySourceGlobal : public MemorySourceBase<MemorySourceGlobal> {
@@ -308,7 +468,52 @@ struct MemorySourceGlobal : public MemorySourceBase<MemorySourceGlobal> {
   }
 
   static MemorySource& reset(size_t n) {
+    owned_().reset(new char[n]);
+    get().reset(owned_().get(), n);
+    return get();
+  }
+
+  // on a buffer of the caller, e.g. xmat::MappedBuffer, it must outlive the use
+  static MemorySource& reset(char* buf, size_t n) {
+    owned_().reset();
+    get().reset(buf, n);
+    return get();
+  }
+
+ private:
+  static std::unique_ptr<char[]>& owned_() {
     static std::unique_ptr<char[]> uptr;
+    return uptr;
+  }
+};
+
+
+// per-thread memory source
+// ------------------------
+// The same as MemorySourceGlobal, but every thread has its own MemorySource
+// and buffer, so no locking is needed. Meant for memory that lives for one
+// frame (a message, its decoded arrays, the reply), see ArenaScope.
+struct MemorySourceThread : public MemorySourceBase<MemorySourceThread> {
+  using memsource_t = MemorySource;
+
+  MemorySourceThread() = default;
+
+  // access
+  // ------
+  static char*&  buf() noexcept { return get().buf(); }
+  static size_t& N() noexcept { return get().N(); }
+  static size_t& space() noexcept { return get().space(); }
+  static char*&  p() noexcept { return get().p(); }
+  static char*&  p_prev() noexcept {  return get().p_prev(); }
+
+  static memsource_t& get() noexcept {
+    static thread_local memsource_t s;
+    return s;
+  }
+
+  // once per thread, before the first allocation
+  static MemorySource& reset(size_t n) {
+    static thread_local std::unique_ptr<char[]> uptr;
     uptr.reset(new char[n]);
     get().reset(uptr.get(), n);
     return get();
@@ -316,17 +521,550 @@ struct MemorySourceGlobal : public MemorySourceBase<MemorySourceGlobal> {
 };
 
 
-// allocators based on: MemorySourceRef, MemorySourceGlobal
-// --------------------------------------------------------
+// rewinds a MemorySource to the state it had on entry to the scope:
+//   xmat::MemorySourceThread::reset(1 << 20);
+//   for (;;) {
+//     xmat::ArenaScope scope;                      // MemorySourceThread::get()
+//     xmat::IBBufMS ibuf{scope.source()};
+//     xmat::NArrayMS<float, 2> a{{8, 256}, scope.source()};
+//     ...
+//   }                                              // a, ibuf, then scope
+// Everything allocated inside must be destroyed before the scope.
+class ArenaScope {
+ public:
+  ArenaScope() noexcept : ArenaScope(MemorySourceThread::get()) {}
+
+  explicit ArenaScope(MemorySource& ms) noexcept
+    : ms_{&ms}, p_{ms.p()}, p_prev_{ms.p_prev()}, space_{ms.space()} {}
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  ~ArenaScope() { rewind(); }
+
+  // frees everything allocated since entry, the scope stays open
+  void rewind() noexcept {
+    ms_->p() = p_;
+    ms_->p_prev() = p_prev_;
+    ms_->space() = space_;
+  }
+
+  MemorySource* source() const noexcept { return ms_; }
+
+  // bytes taken since entry
+  size_t used() const noexcept { return space_ - ms_->space(); }
+
+ private:
+  MemorySource* ms_;
+  char* p_;
+  char* p_prev_;
+  size_t space_;
+};
+
+
+// global thread-safe memory source
+// --------------------------------
+// Lock-free bump arena: any thread may allocate at any time.
+//   xmat::MemorySourceGlobalMT::reset(1 << 26);   // before the threads start
+//   xmat::NArrayGMT<float, 2> a{{8, 1024}};       // from any thread
+//
+// Blocks up to k_fast_align alignment are taken with one atomic fetch_add,
+// larger alignments and reserve() with a compare-exchange loop. Every thread
+// remembers its last block: extend()/extend_reserve() grow it in place and
+// deallocate() gives it back while no other block was taken after it,
+// otherwise they fail (nullptr) and deallocate() keeps the memory until
+// reset(). reset() must not race with allocations.
+struct MemorySourceGlobalMT : public MemorySourceBase<MemorySourceGlobalMT> {
+  static constexpr size_t k_fast_align = alignof(std::max_align_t);
+
+  MemorySourceGlobalMT() = default;
+
+  void* allocate(size_t n) {
+    void* out = allocate(n, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* allocate(size_t n, size_t aln) {
+    void* out = allocate(n, aln, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  template<size_t Aln>
+  void* allocate_aln(size_t n) { return allocate(n, Aln); }
+
+  void* reserve(size_t nmin, size_t nmax, size_t factor, size_t* nout) {
+    void* out = reserve(nmin, nmax, factor, nout, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* extend(void* ptr, size_t n) {
+    void* out = extend(ptr, n, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* extend_reserve(void* ptr, size_t nmin, size_t nmax, size_t factor, size_t* nout) {
+    void* out = extend_reserve(ptr, nmin, nmax, factor, nout, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  // nothrow methods
+  // ---------------
+  void* allocate(size_t n, std::nothrow_t) noexcept { return allocate(n, k_fast_align, std::nothrow); }
+
+  void* allocate(size_t n, size_t aln, std::nothrow_t) noexcept {
+    assert((aln & (aln - 1)) == 0 && "Aln must be a pow of 2");
+    State& s = state();
+    if (aln <= k_fast_align) {
+      const size_t m = align_up_(std::max<size_t>(n, 1), k_fast_align);
+      if (s.off.load(std::memory_order_relaxed) + m > s.N) { return nullptr; }
+      const size_t off = s.off.fetch_add(m, std::memory_order_acq_rel);
+      if (off + m > s.N) {
+        size_t end = off + m;  // give back unless somebody is already behind
+        s.off.compare_exchange_strong(end, off, std::memory_order_acq_rel);
+        return nullptr;
+      }
+      return take_(s, off, off + m);
+    }
+    size_t off = s.off.load(std::memory_order_relaxed);
+    size_t start = 0, end = 0;
+    do {
+      start = align_off_(s, off, aln);
+      end = start + align_up_(std::max<size_t>(n, 1), k_fast_align);
+      if (end > s.N) { return nullptr; }
+    } while (!s.off.compare_exchange_weak(off, end, std::memory_order_acq_rel));
+    return take_(s, start, end);
+  }
+
+  template<size_t Aln>
+  void* allocate_aln(size_t n, std::nothrow_t) noexcept {
+    static_assert((Aln & (Aln - 1)) == 0, "Aln must be a pow of 2");
+    return allocate(n, Aln, std::nothrow);
+  }
+
+  // Returns:
+  //  *nout >= nmin, *nout <= nmax, *nout % factor := 0
+  void* reserve(size_t nmin, size_t nmax, size_t factor,
+                size_t* nout, std::nothrow_t) noexcept {
+    State& s = state();
+    size_t off = s.off.load(std::memory_order_relaxed);
+    size_t start = 0, end = 0;
+    do {
+      start = align_off_(s, off, k_fast_align);
+      const size_t space = start < s.N ? s.N - start : 0;
+      if (space < nmin) {
+        *nout = 0;
+        return nullptr;
+      }
+      *nout = (std::min(nmax, space) / factor) * factor;
+      end = std::min(start + align_up_(*nout, k_fast_align), s.N);
+    } while (!s.off.compare_exchange_weak(off, end, std::memory_order_acq_rel));
+    return take_(s, start, end);
+  }
+
+  // the calling thread's last block, in place
+  void* extend(void* ptr, size_t n, std::nothrow_t) noexcept {
+    size_t nout = 0;
+    return extend_reserve(ptr, n, n, 1, &nout, std::nothrow);
+  }
+
+  // Returns:
+  //  *nout >= nmin, *nout <= nmax, *nout % factor := 0
+  void* extend_reserve(void* ptr, size_t nmin, size_t nmax, size_t factor,
+                       size_t* nout, std::nothrow_t) noexcept {
+    State& s = state();
+    Last& last = last_();
+    *nout = 0;
+    if (!ptr || ptr != last.ptr || last.epoch != s.epoch) { return nullptr; }
+    const size_t start = static_cast<size_t>(static_cast<char*>(ptr) - s.buf);
+    const size_t space = s.N - start;
+    if (nmin > space) { return nullptr; }
+    const size_t n = (std::min(nmax, space) / factor) * factor;
+    const size_t end_new = std::min(start + align_up_(n, k_fast_align), s.N);
+    size_t end = last.end;
+    if (!s.off.compare_exchange_strong(end, end_new, std::memory_order_acq_rel)) { return nullptr; }
+    last.end = end_new;
+    *nout = n;
+    return ptr;
+  }
+
+  // a block of n bytes goes back to the arena if it is on top: freed in
+  // reverse order of allocation, like arrays of a scope, all of them do
+  void deallocate(void* ptr, size_t n) noexcept {
+    State& s = state();
+    if (!ptr) { return; }
+    Last& last = last_();
+    if (ptr == last.ptr) { last.ptr = nullptr; }
+    const size_t start = static_cast<size_t>(static_cast<char*>(ptr) - s.buf);
+    size_t end = std::min(start + align_up_(std::max<size_t>(n, 1), k_fast_align), s.N);
+    s.off.compare_exchange_strong(end, start, std::memory_order_acq_rel);
+  }
+
+ public:
+  // arena of n bytes aligned to 64, drops the previous one
+  static void reset(size_t n) {
+    State& s = state();
+    s.owned.reset(new char[n + 64]);
+    s.buf = s.owned.get() + (64 - reinterpret_cast<uintptr_t>(s.owned.get()) % 64) % 64;
+    s.N = n;
+    s.off.store(0, std::memory_order_relaxed);
+    ++s.epoch;
+  }
+
+  // everything allocated is dropped
+  static void reset() noexcept {
+    State& s = state();
+    s.off.store(0, std::memory_order_relaxed);
+    ++s.epoch;
+  }
+
+  // access methods
+  // --------------
+  static size_t used() noexcept { return std::min(state().off.load(std::memory_order_relaxed), state().N); }
+  static size_t size() noexcept { return state().N; }
+  static size_t N() noexcept { return state().N; }
+  static size_t space() noexcept { return state().N - used(); }
+
+ private:
+  struct State {
+    std::unique_ptr<char[]> owned;
+    char* buf = nullptr;
+    size_t N = 0;
+    size_t epoch = 0;
+    alignas(64) std::atomic<size_t> off{0};  // first free byte
+  };
+
+  // the last block taken by this thread
+  struct Last {
+    void* ptr = nullptr;
+    size_t end = 0;
+    size_t epoch = 0;
+  };
+
+  static State& state() noexcept {
+    static State s;
+    return s;
+  }
+
+  static Last& last_() noexcept {
+    static thread_local Last l;
+    return l;
+  }
+
+  static size_t align_off_(const State& s, size_t off, size_t aln) noexcept {
+    const uintptr_t p = reinterpret_cast<uintptr_t>(s.buf) + off;
+    return off + static_cast<size_t>((aln - p % aln) % aln);
+  }
+
+  static void* take_(const State& s, size_t start, size_t end) noexcept {
+    Last& last = last_();
+    last.ptr = s.buf + start;
+    last.end = end;
+    last.epoch = s.epoch;
+    return last.ptr;
+  }
+};
+
+
+// size-class pool memory source
+// -----------------------------
+// For arrays and buffers of recurring sizes: blocks of power-of-two size
+// classes (64 B .. 128 MB) are kept on free lists after deallocate() and
+// handed out again in O(1), without touching the system allocator.
+//   xmat::NArrayPMS<std::complex<float>, 2> a{{64, 4096}};   // any thread
+//
+// Every thread has its own lists (no locking), up to k_cache_bytes per class;
+// beyond that and at thread exit blocks go to shared lists under a mutex,
+// which a thread looks into before it takes a new block from the system.
+// Blocks are aligned to k_align, larger alignments and blocks above the
+// largest class bypass the lists. extend()/extend_reserve() grow a block in
+// place up to the size of its class. stats() are of the calling thread.
+struct MemorySourcePool : public MemorySourceBase<MemorySourcePool> {
+  static constexpr size_t k_align = 64;
+  static constexpr size_t k_min_log2 = 6;
+  static constexpr size_t k_max_log2 = 27;
+  static constexpr size_t k_classes = k_max_log2 - k_min_log2 + 1;
+  static constexpr size_t k_cache_bytes = size_t{1} << 24;
+
+  struct Stats {
+    size_t hits = 0;     // from the thread's lists
+    size_t shared = 0;   // from the shared lists
+    size_t misses = 0;   // new block from the system
+    size_t direct = 0;   // not pooled: too large or over-aligned
+  };
+
+  MemorySourcePool() = default;
+
+  void* allocate(size_t n) {
+    void* out = allocate(n, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* allocate(size_t n, size_t aln) {
+    void* out = allocate(n, aln, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  template<size_t Aln>
+  void* allocate_aln(size_t n) {
+    void* out = allocate_aln<Aln>(n, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* reserve(size_t nmin, size_t nmax, size_t factor, size_t* nout) {
+    void* out = reserve(nmin, nmax, factor, nout, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* extend(void* ptr, size_t n) {
+    void* out = extend(ptr, n, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  void* extend_reserve(void* ptr, size_t nmin, size_t nmax, size_t factor, size_t* nout) {
+    void* out = extend_reserve(ptr, nmin, nmax, factor, nout, std::nothrow);
+    if (!out) throw std::bad_alloc();
+    return out;
+  }
+
+  // nothrow methods
+  // ---------------
+  void* allocate(size_t n, std::nothrow_t) noexcept { return take_(n, k_align); }
+
+  void* allocate(size_t n, size_t aln, std::nothrow_t) noexcept {
+    assert((aln & (aln - 1)) == 0 && "Aln must be a pow of 2");
+    return take_(n, aln);
+  }
+
+  template<size_t Aln>
+  void* allocate_aln(size_t n, std::nothrow_t) noexcept {
+    static_assert((Aln & (Aln - 1)) == 0, "Aln must be a pow of 2");
+    return take_(n, Aln);
+  }
+
+  // the whole class of nmin
+  // Returns:
+  //  *nout >= nmin, *nout <= nmax, *nout % factor := 0
+  void* reserve(size_t nmin, size_t nmax, size_t factor,
+                size_t* nout, std::nothrow_t) noexcept {
+    void* ptr = take_(nmin, k_align);
+    *nout = ptr ? fit_(capacity(ptr), nmin, nmax, factor) : 0;
+    return ptr;
+  }
+
+  void* extend(void* ptr, size_t n, std::nothrow_t) noexcept {
+    return ptr && n <= capacity(ptr) ? ptr : nullptr;
+  }
+
+  // Returns:
+  //  *nout >= nmin, *nout <= nmax, *nout % factor := 0
+  void* extend_reserve(void* ptr, size_t nmin, size_t nmax, size_t factor,
+                       size_t* nout, std::nothrow_t) noexcept {
+    if (!ptr || nmin > capacity(ptr)) {
+      *nout = 0;
+      return nullptr;
+    }
+    *nout = fit_(capacity(ptr), nmin, nmax, factor);
+    return ptr;
+  }
+
+  void deallocate(void* ptr, size_t /*n*/) noexcept {
+    if (!ptr) { return; }
+    const Header h = header_(ptr);
+    if (h.cls >= k_classes) {
+      std::free(h.raw);
+      return;
+    }
+    List& l = cache_().lists[h.cls];
+    if ((l.count + 1) << (h.cls + k_min_log2) <= k_cache_bytes) {
+      l.push(ptr);
+      return;
+    }
+    Shared& sh = shared_();
+    std::lock_guard<std::mutex> lock{sh.mutex};
+    sh.lists[h.cls].push(ptr);
+  }
+
+ public:
+  // usable bytes of a block
+  static size_t capacity(const void* ptr) noexcept {
+    const Header h = header_(ptr);
+    return h.cls < k_classes ? class_size_(h.cls) : h.size;
+  }
+
+  static Stats stats() noexcept { return cache_().stats; }
+  static void reset_stats() noexcept { cache_().stats = Stats{}; }
+
+  // gives the free blocks of the calling thread and the shared ones back to
+  // the system
+  static void trim() noexcept {
+    cache_().release();
+    Shared& sh = shared_();
+    std::lock_guard<std::mutex> lock{sh.mutex};
+    sh.release();
+  }
+
+  // access methods
+  // --------------
+  // the largest pooled block
+  static size_t N() noexcept { return class_size_(k_classes - 1); }
+  static size_t space() noexcept { return N(); }
+
+ private:
+  static constexpr uint32_t k_direct = ~uint32_t{0};
+
+  // just before every block
+  struct Header {
+    void* raw;      // from std::malloc
+    uint32_t cls;   // k_direct: not pooled
+    uint32_t size;  // usable bytes of k_direct blocks, saturated
+  };
+
+  struct List {
+    void* head = nullptr;
+    size_t count = 0;
+
+    void push(void* ptr) noexcept {
+      std::memcpy(ptr, &head, sizeof(void*));
+      head = ptr;
+      ++count;
+    }
+
+    void* pop() noexcept {
+      void* ptr = head;
+      if (ptr) {
+        std::memcpy(&head, ptr, sizeof(void*));
+        --count;
+      }
+      return ptr;
+    }
+
+    void release() noexcept {
+      while (void* ptr = pop()) { std::free(header_(ptr).raw); }
+    }
+  };
+
+  struct Shared {
+    std::mutex mutex;
+    List lists[k_classes];
+
+    void release() noexcept { for (List& l : lists) { l.release(); } }
+    ~Shared() { release(); }
+  };
+
+  struct Cache {
+    List lists[k_classes];
+    Stats stats;
+
+    void release() noexcept { for (List& l : lists) { l.release(); } }
+
+    // at thread exit the blocks are left to the other threads
+    ~Cache() {
+      Shared& sh = shared_();
+      std::lock_guard<std::mutex> lock{sh.mutex};
+      for (size_t c = 0; c < k_classes; ++c) {
+        while (void* ptr = lists[c].pop()) { sh.lists[c].push(ptr); }
+      }
+    }
+  };
+
+  static Shared& shared_() noexcept {
+    static Shared s;
+    return s;
+  }
+
+  static Cache& cache_() noexcept {
+    static thread_local Cache c;
+    return c;
+  }
+
+  static constexpr size_t class_size_(size_t cls) noexcept { return size_t{1} << (cls + k_min_log2); }
+
+  static size_t class_of_(size_t n) noexcept {
+    size_t cls = 0;
+    while (class_size_(cls) < n && cls < k_classes) { ++cls; }
+    return cls;
+  }
+
+  static size_t fit_(size_t cap, size_t nmin, size_t nmax, size_t factor) noexcept {
+    return std::max(nmin, (std::min(nmax, cap) / factor) * factor);
+  }
+
+  static Header header_(const void* ptr) noexcept {
+    Header h;
+    std::memcpy(&h, static_cast<const char*>(ptr) - sizeof(Header), sizeof(Header));
+    return h;
+  }
+
+  // n bytes from std::malloc, aligned to aln, the header in front
+  static void* system_(size_t n, size_t aln, uint32_t cls) noexcept {
+    if (n > SIZE_MAX - aln - sizeof(Header)) { return nullptr; }
+    char* raw = static_cast<char*>(std::malloc(n + aln + sizeof(Header)));
+    if (!raw) { return nullptr; }
+    const uintptr_t q = reinterpret_cast<uintptr_t>(raw) + sizeof(Header);
+    char* ptr = raw + sizeof(Header) + static_cast<size_t>((aln - q % aln) % aln);
+    const Header h{raw, cls, static_cast<uint32_t>(std::min<size_t>(n, UINT32_MAX))};
+    std::memcpy(ptr - sizeof(Header), &h, sizeof(Header));
+    return ptr;
+  }
+
+  static void* take_(size_t n, size_t aln) noexcept {
+    Cache& c = cache_();
+    const size_t cls = class_of_(n);
+    if (cls >= k_classes || aln > k_align) {
+      ++c.stats.direct;
+      return system_(n, std::max(aln, size_t{k_align}), k_direct);
+    }
+    if (void* ptr = c.lists[cls].pop()) {
+      ++c.stats.hits;
+      return ptr;
+    }
+    {
+      Shared& sh = shared_();
+      std::lock_guard<std::mutex> lock{sh.mutex};
+      if (void* ptr = sh.lists[cls].pop()) {
+        ++c.stats.shared;
+        return ptr;
+      }
+    }
+    ++c.stats.misses;
+    return system_(class_size_(cls), k_align, static_cast<uint32_t>(cls));
+  }
+};
+
+// allocators based on: MemorySourceRef, MemorySourceStack, MemorySourceGlobal, MemorySourceThread,
+//                      MemorySourceGlobalMT, MemorySourcePool
+// -------------------------------------------------------------------------------------------------
 template<typename T, size_t Aln = alignof(T)>
 using AllocatorMS = TypedMemorySourceBase<T, Aln, MemorySource>;
 
 template<typename T, size_t Aln = alignof(T)>
 using AllocatorMSRef = TypedMemorySourceBase<T, Aln, MemorySourceRef>;
 
+template<typename T, size_t Aln = alignof(T)>
+using AllocatorMSStack = TypedMemorySourceBase<T, Aln, MemorySourceStack>;
+
 template<typename T, size_t Aln = alignof(T)>
 using AllocatorMSGlobal = TypedMemorySourceBase<T, Aln, MemorySourceGlobal>;
 
+template<typename T, size_t Aln = alignof(T)>
+using AllocatorMSGlobalMT = TypedMemorySourceBase<T, Aln, MemorySourceGlobalMT>;
+
+template<typename T, size_t Aln = alignof(T)>
+using AllocatorMSThread = TypedMemorySourceBase<T, Aln, MemorySourceThread>;
+
+template<typename T, size_t Aln = alignof(T)>
+using AllocatorMSPool = TypedMemorySourceBase<T, Aln, MemorySourcePool>;
+
 
 // So, there are classes for memory:
 // -------------------------------------------
@@ -334,7 +1072,11 @@ using AllocatorMSGlobal = TypedMemorySourceBase<T, Aln, MemorySourceGlobal>;
 // -------------------------------------------
 // MemorySource        ->   AllocatorMS<T, Aln>   (**not used)
 // MemorySourceRef     ->   AllocatorMSRef<T, Aln>
+// MemorySourceStack   ->   AllocatorMSStack<T, Aln>      (deallocate gives back)
 // MemorySourceGlobal  ->   AllocatorMSGlobal<T, Aln>
+// MemorySourceGlobalMT ->  AllocatorMSGlobalMT<T, Aln>   (thread-safe)
+// MemorySourceThread  ->   AllocatorMSThread<T, Aln>     (one per thread)
+// MemorySourcePool    ->   AllocatorMSPool<T, Aln>       (thread-safe, size classes)
 //        the same as  ->   std::allocator<T>
 
 } // namespace xmat
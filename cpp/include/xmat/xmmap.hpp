@@ -0,0 +1,206 @@
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XMAT_MMAP_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// c-lang
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+// cpp-lang
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+// project
+#include "xutil.hpp"
+#include "xmemory.hpp"
+
+
+// Memory for latency-critical buffers: page faults happen at construction,
+// not on the first touch of the data.
+//   xmat::MappedBuffer mb{1 << 26, {xmat::HugePages::transparent, true, true}};
+//   xmat::MemorySourceGlobal::reset(mb.data(), mb.size());   // backing store
+//   xmat::MemorySourceMapped ms{1 << 26};                    // standalone
+//   xmat::NArrayMS<float, 2> a{{64, 4096}, &ms};
+namespace xmat {
+
+// pages asked for; MappedBuffer::pages() tells what was taken
+enum class HugePages : int {
+  none        = 0,   // normal pages
+  transparent = 1,   // madvise(MADV_HUGEPAGE) on a huge-page aligned range
+  explicit_   = 2,   // MAP_HUGETLB from the reserved pool, else transparent
+};
+
+struct MapOptions {
+  HugePages huge = HugePages::transparent;
+  bool populate = true;   // pre-fault every page
+  bool lock = false;      // mlock, needs RLIMIT_MEMLOCK or CAP_IPC_LOCK
+  size_t huge_page_size = size_t{1} << 21;
+};
+
+
+// Anonymous private mapping of at least n bytes. Falls back step by step:
+// MAP_HUGETLB -> transparent huge pages -> normal pages, a failed mlock
+// leaves locked() false. Throws std::bad_alloc only if no memory is mapped.
+// Without mmap (e.g. Windows) the memory is from the heap, pre-faulted.
+class MappedBuffer {
+ public:
+  MappedBuffer() = default;
+
+  explicit MappedBuffer(size_t n, const MapOptions& opt = {}) : size_{n} {
+    if (!n) { return; }
+#ifdef XMAT_MMAP_POSIX
+    if (opt.huge == HugePages::explicit_ && map_hugetlb_(n, opt)) {
+      pages_ = HugePages::explicit_;
+    } else {
+      map_(n, opt);
+    }
+    if (!populated_ && opt.populate) { touch_(page_size_()); }
+    if (opt.lock) { locked_ = ::mlock(data_, size_) == 0; }
+#else
+    heap_.reset(new char[n + 64]);
+    data_ = heap_.get() + (64 - reinterpret_cast<uintptr_t>(heap_.get()) % 64) % 64;
+    if (opt.populate) { touch_(4096); }
+#endif
+  }
+
+  ~MappedBuffer() { release_(); }
+
+  MappedBuffer(const MappedBuffer&) = delete;
+  MappedBuffer& operator=(const MappedBuffer&) = delete;
+
+  MappedBuffer(MappedBuffer&& other) noexcept { swap(*this, other); }
+
+  MappedBuffer& operator=(MappedBuffer&& other) noexcept {
+    MappedBuffer tmp{std::move(other)};
+    swap(*this, tmp);
+    return *this;
+  }
+
+  friend void swap(MappedBuffer& lhs, MappedBuffer& rhs) noexcept {
+    using std::swap;
+    swap(lhs.data_, rhs.data_);
+    swap(lhs.size_, rhs.size_);
+    swap(lhs.base_, rhs.base_);
+    swap(lhs.mapped_, rhs.mapped_);
+    swap(lhs.pages_, rhs.pages_);
+    swap(lhs.populated_, rhs.populated_);
+    swap(lhs.locked_, rhs.locked_);
+    swap(lhs.heap_, rhs.heap_);
+  }
+
+  char* data() noexcept { return data_; }
+  const char* data() const noexcept { return data_; }
+  size_t size() const noexcept { return size_; }
+
+  // bytes mapped, the size rounded up to pages
+  size_t mapped() const noexcept { return mapped_; }
+
+  HugePages pages() const noexcept { return pages_; }
+  bool populated() const noexcept { return populated_; }
+  bool locked() const noexcept { return locked_; }
+
+ private:
+#ifdef XMAT_MMAP_POSIX
+  static size_t page_size_() noexcept {
+    const long n = ::sysconf(_SC_PAGESIZE);
+    return n > 0 ? static_cast<size_t>(n) : 4096;
+  }
+
+  static size_t round_up_(size_t n, size_t m) noexcept { return (n + m - 1) / m * m; }
+
+  bool map_hugetlb_(size_t n, const MapOptions& opt) noexcept {
+#ifdef MAP_HUGETLB
+    const size_t len = round_up_(n, opt.huge_page_size);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+    bool populate = false;
+#ifdef MAP_POPULATE
+    if (opt.populate) { flags |= MAP_POPULATE; populate = true; }
+#endif
+    void* p = ::mmap(nullptr, len, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (p == MAP_FAILED) { return false; }
+    base_ = data_ = static_cast<char*>(p);
+    mapped_ = len;
+    populated_ = populate;
+    return true;
+#else
+    (void)n; (void)opt;
+    return false;
+#endif
+  }
+
+  // normal pages, madvise'd on a huge-page aligned range if asked for
+  void map_(size_t n, const MapOptions& opt) {
+    const size_t page = page_size_();
+    const bool thp = opt.huge != HugePages::none;
+    const size_t len = round_up_(n, thp ? opt.huge_page_size : page);
+    const size_t slack = thp ? opt.huge_page_size : 0;
+    void* p = ::mmap(nullptr, len + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) { throw std::bad_alloc(); }
+    base_ = static_cast<char*>(p);
+    mapped_ = len + slack;
+    data_ = base_;
+    if (thp) {
+      // trim to an aligned range: [base_, data_) and the tail go back
+      const uintptr_t q = reinterpret_cast<uintptr_t>(base_);
+      data_ = base_ + (opt.huge_page_size - q % opt.huge_page_size) % opt.huge_page_size;
+      if (data_ != base_) { ::munmap(base_, static_cast<size_t>(data_ - base_)); }
+      if (data_ + len != base_ + mapped_) { ::munmap(data_ + len, static_cast<size_t>(base_ + mapped_ - data_ - len)); }
+      base_ = data_;
+      mapped_ = len;
+#ifdef MADV_HUGEPAGE
+      if (::madvise(data_, len, MADV_HUGEPAGE) == 0) { pages_ = HugePages::transparent; }
+#endif
+    }
+  }
+#endif
+
+  // one write per page; on madvise'd memory the first write faults in a whole huge page
+  void touch_(size_t page) noexcept {
+    volatile char* p = data_;
+    for (size_t off = 0; off < size_; off += page) { p[off] = 0; }
+    populated_ = true;
+  }
+
+  void release_() noexcept {
+#ifdef XMAT_MMAP_POSIX
+    if (base_) { ::munmap(base_, mapped_); }
+#endif
+    base_ = data_ = nullptr;
+    size_ = mapped_ = 0;
+  }
+
+  char* data_ = nullptr;
+  size_t size_ = 0;
+  char* base_ = nullptr;    // of the mapping
+  size_t mapped_ = 0;
+  HugePages pages_ = HugePages::none;
+  bool populated_ = false;
+  bool locked_ = false;
+  std::unique_ptr<char[]> heap_;  // without mmap
+};
+
+
+// MemorySource on its own MappedBuffer, for NArrayMS, OBBufMS, MemorySourceStack...
+struct MemorySourceMapped : public MemorySource {
+  explicit MemorySourceMapped(size_t n, const MapOptions& opt = {}) : buffer_{n, opt} {
+    reset(buffer_.data(), buffer_.size());
+  }
+
+  MemorySourceMapped(MemorySourceMapped&&) = default;
+  MemorySourceMapped& operator=(MemorySourceMapped&&) = default;
+
+  const MappedBuffer& buffer() const noexcept { return buffer_; }
+
+ private:
+  MappedBuffer buffer_;
+};
+
+} // namespace xmat
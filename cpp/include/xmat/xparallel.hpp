@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+#include "xexpr.hpp"
+#include "xreduce.hpp"
+#include "xthreadpool.hpp"
+
+
+namespace xmat {
+namespace par {
+
+// ------------------------------------------------------------
+// parallel algorithms over NArrayInterface_
+// ------------------------------------------------------------
+// Element-wise chunks along the least data-local dim, see xthreadpool.hpp.
+
+namespace impl_par {
+
+// f(x) for every element, inner loop over the contiguous run
+template<typename T, size_t ND, MOrder MOrderT, typename IntT, typename F>
+void for_each_seq(View_<T, ND, MOrderT, IntT> x, F& f) {
+  const auto& rv = x.ravel();
+  if (rv.numel() == 0) { return; }
+  const size_t nc = rv.ndcontig();
+  size_t len = 1;
+  for (size_t k = 0; k < nc; ++k) { len *= rv.shape[MOrderT == MOrder::C ? ND - 1 - k : k]; }
+  const IntT s = rv.leaststride();
+
+  size_t index[ND] = {};
+  do {
+    T* p = x.ptr() + hidx::conv(index, rv.stride.begin(), ND, IntT{0});
+    if (s == 1) { for (size_t i = 0; i < len; ++i) { f(p[i]); } }
+    else        { for (size_t i = 0; i < len; ++i) { f(p[i * s]); } }
+  } while (hidx::next_outer<MOrderT>(index, rv.shape.begin(), ND, nc));
+}
+} // namespace impl_par
+
+
+// f(x) for every element
+template<class D, typename T, size_t ND, MOrder MOrderT, typename IntT, typename F>
+void for_each(NArrayInterface_<D, T, ND, MOrderT, IntT>& x, F f,
+              size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  const size_t d = hidx::morderhidhi(MOrderT, ND);
+  const auto pl = impl_par::plan(x.numel(), x.shape()[d], grain, pool.size());
+  pool.parallel_for(pl.nchunk, [&](size_t c) {
+    const size_t i0 = c * pl.rows, i1 = std::min(i0 + pl.rows, x.shape()[d]);
+    auto fc = f;
+    impl_par::for_each_seq(impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1), fc);
+  });
+}
+
+template<class D, typename T, size_t ND, MOrder MOrderT, typename IntT, typename F>
+void for_each(NArrayInterface_<D, T, ND, MOrderT, IntT>&& x, F f,
+              size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  for_each(x, f, grain, pool);
+}
+
+
+// dst = f(src), dst = f(a, b)
+template<class D0, typename T0, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename T1, MOrder MOrderT1, typename IntT1, typename F>
+void transform(NArrayInterface_<D0, T0, ND, MOrderT0, IntT0>& dst,
+               const NArrayInterface_<D1, T1, ND, MOrderT1, IntT1>& src, F f,
+               size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  if (dst.shape() != src.shape()) { throw ShapeError("xmat::par::transform(): shape mismatch"); }
+  const size_t d = hidx::morderhidhi(MOrderT0, ND);
+  const auto pl = impl_par::plan(dst.numel(), dst.shape()[d], grain, pool.size());
+  pool.parallel_for(pl.nchunk, [&](size_t c) {
+    const size_t i0 = c * pl.rows, i1 = std::min(i0 + pl.rows, dst.shape()[d]);
+    assign(impl_par::chunk(dst.ptr(), dst.ravel(), d, i0, i1),
+           map(f, impl_par::chunk(src.ptr(), src.ravel(), d, i0, i1)));
+  });
+}
+
+template<class D0, typename T0, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename T1, MOrder MOrderT1, typename IntT1,
+         class D2, typename T2, MOrder MOrderT2, typename IntT2, typename F>
+void transform(NArrayInterface_<D0, T0, ND, MOrderT0, IntT0>& dst,
+               const NArrayInterface_<D1, T1, ND, MOrderT1, IntT1>& a,
+               const NArrayInterface_<D2, T2, ND, MOrderT2, IntT2>& b, F f,
+               size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  if (dst.shape() != a.shape() || dst.shape() != b.shape()) {
+    throw ShapeError("xmat::par::transform(): shape mismatch");
+  }
+  const size_t d = hidx::morderhidhi(MOrderT0, ND);
+  const auto pl = impl_par::plan(dst.numel(), dst.shape()[d], grain, pool.size());
+  pool.parallel_for(pl.nchunk, [&](size_t c) {
+    const size_t i0 = c * pl.rows, i1 = std::min(i0 + pl.rows, dst.shape()[d]);
+    assign(impl_par::chunk(dst.ptr(), dst.ravel(), d, i0, i1),
+           map(f, impl_par::chunk(a.ptr(), a.ravel(), d, i0, i1),
+                  impl_par::chunk(b.ptr(), b.ravel(), d, i0, i1)));
+  });
+}
+
+template<class D0, typename T0, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename T1, MOrder MOrderT1, typename IntT1, typename F>
+void transform(NArrayInterface_<D0, T0, ND, MOrderT0, IntT0>&& dst,
+               const NArrayInterface_<D1, T1, ND, MOrderT1, IntT1>& src, F f,
+               size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  transform(dst, src, f, grain, pool);
+}
+
+
+// reduce with xmat::rd reducer: par::reduce(x, rd::sum{})
+template<typename R, class D, typename T, size_t ND, MOrder MOrderT, typename IntT,
+         typename std::enable_if_t<std::is_class<typename R::template impl<T>>::value, int> = 0>
+auto reduce(const NArrayInterface_<D, T, ND, MOrderT, IntT>& x, R,
+            size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  using impl_t = typename R::template impl<T>;
+  const size_t d = hidx::morderhidhi(MOrderT, ND);
+  const size_t nrows = x.shape()[d];
+  const auto pl = impl_par::plan(x.numel(), nrows, grain, pool.size());
+  const size_t row_numel = nrows ? x.numel() / nrows : 0;
+
+  std::vector<typename impl_t::acc_t> part(pl.nchunk, impl_t::init());
+  pool.parallel_for(pl.nchunk, [&](size_t c) {
+    const size_t i0 = c * pl.rows, i1 = std::min(i0 + pl.rows, nrows);
+    part[c] = impl_reduce::reduce_acc<impl_t>(impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1),
+                                              i0 * row_numel);
+  });
+
+  auto acc = impl_t::init();
+  for (const auto& p : part) { impl_t::merge(acc, p); }
+  return impl_t::final(acc, x.numel());
+}
+
+// reduce with associative binary operation: op(...op(op(init, x0), x1)...)
+template<class D, typename T, size_t ND, MOrder MOrderT, typename IntT, typename U, typename BinaryOp>
+U reduce(const NArrayInterface_<D, T, ND, MOrderT, IntT>& x, U init, BinaryOp op,
+         size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  const size_t d = hidx::morderhidhi(MOrderT, ND);
+  const size_t nrows = x.shape()[d];
+  const auto pl = impl_par::plan(x.numel(), nrows, grain, pool.size());
+
+  std::vector<std::pair<bool, U>> part(pl.nchunk, {false, init});
+  pool.parallel_for(pl.nchunk, [&](size_t c) {
+    const size_t i0 = c * pl.rows, i1 = std::min(i0 + pl.rows, nrows);
+    auto& acc = part[c];
+    auto f = [&acc, &op](const T& v) {
+      if (acc.first) { acc.second = op(acc.second, v); }
+      else { acc = {true, static_cast<U>(v)}; }
+    };
+    impl_par::for_each_seq(impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1), f);
+  });
+
+  for (const auto& p : part) {
+    if (p.first) { init = op(init, p.second); }
+  }
+  return init;
+}
+} // namespace par
+} // namespace xmat
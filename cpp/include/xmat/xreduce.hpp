@@ -0,0 +1,354 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+
+#include <complex>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Reductions along an axis
+// ------------------------------------------------------------
+//   xmat::NArray<float, 2> y{{C, N}};
+//   xmat::reduce<1>(y, x, xmat::rd::sum{});     // x: [C, K, N] -> y: [C, N]
+//   auto s = xmat::reduce(x, xmat::rd::norm{});  // all elements
+//
+// Output is a preallocated array of rank ND-1, nothing is allocated.
+// min/max/argmin/argmax compare complex values by magnitude.
+namespace impl_reduce {
+
+template<typename T> struct real_type { using type = T; };
+template<typename T> struct real_type<std::complex<T>> { using type = T; };
+
+// integer data is averaged in double
+template<typename T>
+using float_t = std::conditional_t<std::is_integral<T>::value, double, T>;
+
+template<typename T> T key(const T& x) noexcept { return x; }
+template<typename T> T key(const std::complex<T>& x) noexcept { return std::norm(x); }
+
+template<typename T> T sqr(const T& x) noexcept { return x * x; }
+template<typename T> T sqr(const std::complex<T>& x) noexcept { return std::norm(x); }
+
+// real(conj(a) * b)
+template<typename T> T dotc(const T& a, const T& b) noexcept { return a * b; }
+template<typename T> T dotc(const std::complex<T>& a, const std::complex<T>& b) noexcept {
+  return a.real() * b.real() + a.imag() * b.imag();
+}
+
+template<typename T, typename K>
+struct ValueKey { T v; K key; };
+
+template<typename K>
+struct IndexKey { size_t i; K key; };
+
+template<typename F, typename R>
+struct MeanM2 { F mean; R m2; size_t n; };
+} // namespace impl_reduce
+
+
+// Reducer: impl<T> provides
+//   acc_t                    accumulator
+//   init()                   empty accumulator
+//   step(acc, x, k)          add x, which has index k along reduced axis
+//   merge(acc, other)        add other accumulator (partial result)
+//   final(acc, n)            result for n reduced elements
+namespace rd {
+
+struct sum {
+  template<typename T> struct impl {
+    using acc_t = T;
+    static acc_t init() noexcept { return T{0}; }
+    static void step(acc_t& a, const T& x, size_t) noexcept { a += x; }
+    static void merge(acc_t& a, const acc_t& b) noexcept { a += b; }
+    static T final(const acc_t& a, size_t) noexcept { return a; }
+  };
+};
+
+struct prod {
+  template<typename T> struct impl {
+    using acc_t = T;
+    static acc_t init() noexcept { return T{1}; }
+    static void step(acc_t& a, const T& x, size_t) noexcept { a *= x; }
+    static void merge(acc_t& a, const acc_t& b) noexcept { a *= b; }
+    static T final(const acc_t& a, size_t) noexcept { return a; }
+  };
+};
+
+struct max {
+  template<typename T> struct impl {
+    using key_t = typename impl_reduce::real_type<T>::type;
+    using acc_t = impl_reduce::ValueKey<T, key_t>;
+    static acc_t init() noexcept { return {T{0}, std::numeric_limits<key_t>::lowest()}; }
+    static void step(acc_t& a, const T& x, size_t) noexcept {
+      const key_t k = impl_reduce::key(x);
+      if (k > a.key) { a.key = k; a.v = x; }
+    }
+    static void merge(acc_t& a, const acc_t& b) noexcept { if (b.key > a.key) { a = b; } }
+    static T final(const acc_t& a, size_t) noexcept { return a.v; }
+  };
+};
+
+struct min {
+  template<typename T> struct impl {
+    using key_t = typename impl_reduce::real_type<T>::type;
+    using acc_t = impl_reduce::ValueKey<T, key_t>;
+    static acc_t init() noexcept { return {T{0}, std::numeric_limits<key_t>::max()}; }
+    static void step(acc_t& a, const T& x, size_t) noexcept {
+      const key_t k = impl_reduce::key(x);
+      if (k < a.key) { a.key = k; a.v = x; }
+    }
+    static void merge(acc_t& a, const acc_t& b) noexcept { if (b.key < a.key) { a = b; } }
+    static T final(const acc_t& a, size_t) noexcept { return a.v; }
+  };
+};
+
+// the first index on ties
+struct argmax {
+  template<typename T> struct impl {
+    using key_t = typename impl_reduce::real_type<T>::type;
+    using acc_t = impl_reduce::IndexKey<key_t>;
+    static acc_t init() noexcept { return {size_t(-1), std::numeric_limits<key_t>::lowest()}; }
+    static void step(acc_t& a, const T& x, size_t k) noexcept {
+      const key_t kx = impl_reduce::key(x);
+      if (kx > a.key || a.i == size_t(-1)) { a.key = kx; a.i = k; }
+    }
+    static void merge(acc_t& a, const acc_t& b) noexcept {
+      if (b.key > a.key || (b.key == a.key && b.i < a.i)) { a = b; }
+    }
+    static size_t final(const acc_t& a, size_t) noexcept { return a.i; }
+  };
+};
+
+struct argmin {
+  template<typename T> struct impl {
+    using key_t = typename impl_reduce::real_type<T>::type;
+    using acc_t = impl_reduce::IndexKey<key_t>;
+    static acc_t init() noexcept { return {size_t(-1), std::numeric_limits<key_t>::max()}; }
+    static void step(acc_t& a, const T& x, size_t k) noexcept {
+      const key_t kx = impl_reduce::key(x);
+      if (kx < a.key || a.i == size_t(-1)) { a.key = kx; a.i = k; }
+    }
+    static void merge(acc_t& a, const acc_t& b) noexcept {
+      if (b.key < a.key || (b.key == a.key && b.i < a.i)) { a = b; }
+    }
+    static size_t final(const acc_t& a, size_t) noexcept { return a.i; }
+  };
+};
+
+struct mean {
+  template<typename T> struct impl {
+    using float_t = impl_reduce::float_t<T>;
+    using real_t = typename impl_reduce::real_type<float_t>::type;
+    using acc_t = float_t;
+    static acc_t init() noexcept { return float_t{0}; }
+    static void step(acc_t& a, const T& x, size_t) noexcept { a += static_cast<float_t>(x); }
+    static void merge(acc_t& a, const acc_t& b) noexcept { a += b; }
+    static float_t final(const acc_t& a, size_t n) noexcept { return a / static_cast<real_t>(n); }
+  };
+};
+
+// population variance (ddof = 0), Welford's single pass
+struct var {
+  template<typename T> struct impl {
+    using float_t = impl_reduce::float_t<T>;
+    using real_t = typename impl_reduce::real_type<float_t>::type;
+    using acc_t = impl_reduce::MeanM2<float_t, real_t>;
+    static acc_t init() noexcept { return {float_t{0}, real_t{0}, 0}; }
+    static void step(acc_t& a, const T& x_, size_t) noexcept {
+      const float_t x = static_cast<float_t>(x_);
+      const float_t d = x - a.mean;
+      a.mean += d / static_cast<real_t>(++a.n);
+      a.m2 += impl_reduce::dotc(d, x - a.mean);
+    }
+    static void merge(acc_t& a, const acc_t& b) noexcept {
+      if (!b.n) { return; }
+      if (!a.n) { a = b; return; }
+      const real_t na = static_cast<real_t>(a.n), nb = static_cast<real_t>(b.n);
+      const real_t n = na + nb;
+      const float_t d = b.mean - a.mean;
+      a.mean += d * (nb / n);
+      a.m2 += b.m2 + impl_reduce::sqr(d) * (na * nb / n);
+      a.n += b.n;
+    }
+    static real_t final(const acc_t& a, size_t n) noexcept { return a.m2 / static_cast<real_t>(n); }
+  };
+};
+
+// L2 norm
+struct norm {
+  template<typename T> struct impl {
+    using real_t = typename impl_reduce::real_type<impl_reduce::float_t<T>>::type;
+    using acc_t = real_t;
+    static acc_t init() noexcept { return real_t{0}; }
+    static void step(acc_t& a, const T& x, size_t) noexcept {
+      a += impl_reduce::sqr(static_cast<impl_reduce::float_t<T>>(x));
+    }
+    static void merge(acc_t& a, const acc_t& b) noexcept { a += b; }
+    static real_t final(const acc_t& a, size_t) noexcept { return std::sqrt(a); }
+  };
+};
+} // namespace rd
+
+
+namespace impl_reduce {
+
+// number of independent accumulators for a run, lets the compiler vectorize
+// the loop without reassociation of one accumulator
+constexpr size_t k_lanes = 8;
+
+// accumulators kept on stack for one block of outputs
+constexpr size_t k_block = 64;
+
+// reduce n elements: p[0], p[s], p[2s], ...; k0 - index of the first one
+template<typename I, typename T, typename IntT>
+typename I::acc_t reduce_run(const T* p, size_t n, IntT s, size_t k0) {
+  typename I::acc_t acc[k_lanes];
+  for (auto& a : acc) { a = I::init(); }
+
+  size_t k = 0;
+  if (s == 1) {
+    for (; k + k_lanes <= n; k += k_lanes) {
+      for (size_t j = 0; j < k_lanes; ++j) { I::step(acc[j], p[k + j], k0 + k + j); }
+    }
+  }
+  else {
+    for (; k + k_lanes <= n; k += k_lanes) {
+      for (size_t j = 0; j < k_lanes; ++j) { I::step(acc[j], p[(k + j) * s], k0 + k + j); }
+    }
+  }
+  for (size_t j = 0; k < n; ++k, ++j) { I::step(acc[j], p[k * s], k0 + k); }
+
+  for (size_t j = 1; j < k_lanes; ++j) { I::merge(acc[0], acc[j]); }
+  return acc[0];
+}
+
+// reduce `len` independent rows at once: out[i] = R(p[i*xs + k*sa], k < n)
+// the inner loop goes along the rows, so it is unit-stride for contiguous data
+template<typename I, typename U, typename T, typename IntT0, typename IntT1>
+void reduce_rows(const T* p, IntT0 xs, U* q, IntT1 qs, size_t len, size_t n, IntT0 sa) {
+  typename I::acc_t acc[k_block];
+
+  for (size_t i0 = 0; i0 < len; i0 += k_block) {
+    const size_t m = std::min(k_block, len - i0);
+    for (size_t i = 0; i < m; ++i) { acc[i] = I::init(); }
+
+    const T* pk = p + i0 * xs;
+    if (xs == 1) {
+      for (size_t k = 0; k < n; ++k, pk += sa) {
+        for (size_t i = 0; i < m; ++i) { I::step(acc[i], pk[i], k); }
+      }
+    }
+    else {
+      for (size_t k = 0; k < n; ++k, pk += sa) {
+        for (size_t i = 0; i < m; ++i) { I::step(acc[i], pk[i * xs], k); }
+      }
+    }
+
+    U* qi = q + i0 * qs;
+    for (size_t i = 0; i < m; ++i) { qi[i * qs] = static_cast<U>(I::final(acc[i], n)); }
+  }
+}
+} // namespace impl_reduce
+
+
+// reduce along `Axis`. out.shape() := x.shape() without `Axis`
+template<size_t Axis, typename R,
+         class D0, typename U, size_t NDo, MOrder MOrderT0, typename IntT0,
+         class D1, typename T, size_t ND, MOrder MOrderT1, typename IntT1>
+void reduce(NArrayInterface_<D0, U, NDo, MOrderT0, IntT0>& out,
+            const NArrayInterface_<D1, T, ND, MOrderT1, IntT1>& x, R) {
+  static_assert(Axis < ND, "xmat::reduce(): Axis must be less than ND");
+  static_assert(NDo + 1 == ND, "xmat::reduce(): output must have ndim := ND-1");
+  using impl_t = typename R::template impl<T>;
+
+  const auto rest = x.ravel().template drop<1>({Axis});
+  if (!std::equal(rest.shape.begin(), rest.shape.end(), out.shape().begin())) {
+    throw ShapeError("xmat::reduce(): wrong output shape");
+  }
+  if (rest.numel() == 0) { return; }
+
+  const size_t n = x.shape()[Axis];
+  const IntT1 sa = x.stride()[Axis];
+
+  // inner run: dims which are jointly contiguous for `x` without `Axis` and `out`
+  const size_t nc = std::min(rest.ndcontig(),
+                             hidx::ndcontigous<MOrderT1>(out.shape().begin(), out.stride().begin(), NDo));
+  const size_t lowi = hidx::morderlowi(MOrderT1, NDo);
+  size_t len = 1;
+  for (size_t k = 0; k < nc; ++k) {
+    len *= rest.shape[MOrderT1 == MOrder::C ? NDo - 1 - k : k];
+  }
+  const IntT1 xs = rest.stride[lowi];
+  const IntT0 qs = out.stride()[lowi];
+
+  // `Axis` is the most data-local: reduce each output along its own run,
+  // otherwise reduce a block of neighbour outputs at once
+  const bool along = sa < xs;
+
+  size_t index[NDo] = {};
+  do {
+    const T* p = x.ptr() + hidx::conv(index, rest.stride.begin(), NDo, IntT1{0});
+    U* q = out.ptr() + hidx::conv(index, out.stride().begin(), NDo, IntT0{0});
+    if (along) {
+      for (size_t i = 0; i < len; ++i) {
+        q[i * qs] = static_cast<U>(impl_t::final(impl_reduce::reduce_run<impl_t>(p + i * xs, n, sa, 0), n));
+      }
+    }
+    else {
+      impl_reduce::reduce_rows<impl_t>(p, xs, q, qs, len, n, sa);
+    }
+  } while (hidx::next_outer<MOrderT1>(index, rest.shape.begin(), NDo, nc));
+}
+
+template<size_t Axis, typename R,
+         class D0, typename U, size_t NDo, MOrder MOrderT0, typename IntT0,
+         class D1, typename T, size_t ND, MOrder MOrderT1, typename IntT1>
+void reduce(NArrayInterface_<D0, U, NDo, MOrderT0, IntT0>&& out,
+            const NArrayInterface_<D1, T, ND, MOrderT1, IntT1>& x, R r) {
+  reduce<Axis>(out, x, r);
+}
+
+
+namespace impl_reduce {
+
+// accumulator over all elements; k0 - flat index of the first one
+template<typename I, class D, typename T, size_t ND, MOrder MOrderT, typename IntT>
+typename I::acc_t reduce_acc(const NArrayInterface_<D, T, ND, MOrderT, IntT>& x, size_t k0 = 0) {
+  auto acc = I::init();
+  if (x.numel() == 0) { return acc; }
+
+  const size_t nc = x.ravel().ndcontig();
+  size_t len = 1;
+  for (size_t k = 0; k < nc; ++k) {
+    len *= x.shape()[MOrderT == MOrder::C ? ND - 1 - k : k];
+  }
+  const IntT s = x.ravel().leaststride();
+
+  size_t index[ND] = {};
+  do {
+    const T* p = x.ptr() + hidx::conv(index, x.stride().begin(), ND, IntT{0});
+    I::merge(acc, reduce_run<I>(p, len, s, k0));
+    k0 += len;
+  } while (hidx::next_outer<MOrderT>(index, x.shape().begin(), ND, nc));
+  return acc;
+}
+} // namespace impl_reduce
+
+
+// reduce all elements; arg-reducers return a flat index in MOrderT order
+template<typename R, class D, typename T, size_t ND, MOrder MOrderT, typename IntT>
+auto reduce(const NArrayInterface_<D, T, ND, MOrderT, IntT>& x, R) {
+  using impl_t = typename R::template impl<T>;
+  return impl_t::final(impl_reduce::reduce_acc<impl_t>(x), x.numel());
+}
+} // namespace xmat
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cstdint>
+
+#include <array>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XMAT_SELECT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define XMAT_SELECT_AVX2 1
+#include <immintrin.h>
+#endif
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Index and mask selection
+// ------------------------------------------------------------
+//   xmat::take<0>(y, x, {2, 5, 7});        // y[k, :] = x[idx[k], :]
+//   xmat::put<1>(x, idx, y);               // x[:, idx[k]] = y[:, k]
+//   size_t n = xmat::compress(v, x, mask); // v[j] = x[i] where mask[i], in x's memory order
+//   xmat::expand(x, mask, v);              // x[i] = v[j] where mask[i]
+//
+// Destinations are preallocated: take/put check the shapes and throw
+// ShapeError, indices out of range throw std::out_of_range before anything
+// is written. Indices are a std::vector, a braced list or a 1D array of
+// integers; with put, repeated indices keep the last value.
+//
+// Along an outer axis whole rows are copied; along the most data-local axis
+// elements are gathered, with AVX2 gathers for 4- and 8-byte types when
+// compiled for AVX2. compress/expand skip or copy 16-element runs of
+// all-false/all-true byte masks found with SSE2, stores of mixed runs are
+// branchless.
+namespace impl_select {
+
+// containers: std::vector, std::initializer_list, std::array
+template<typename I>
+auto isize(const I& idx) -> decltype(idx.size(), size_t()) { return idx.size(); }
+
+template<class D, typename T, MOrder MOrderT, typename IntT>
+size_t isize(const NArrayInterface_<D, T, 1, MOrderT, IntT>& idx) { return idx.shape()[0]; }
+
+template<typename I>
+auto iat(const I& idx, size_t k) -> decltype(idx.size(), ptrdiff_t()) {
+  return static_cast<ptrdiff_t>(idx.begin()[k]);
+}
+
+template<class D, typename T, MOrder MOrderT, typename IntT>
+ptrdiff_t iat(const NArrayInterface_<D, T, 1, MOrderT, IntT>& idx, size_t k) {
+  return static_cast<ptrdiff_t>(idx.at(k));
+}
+
+// element offsets of the selected indices along a dim with `stride`
+template<typename I>
+std::vector<ptrdiff_t> offsets(const I& idx, size_t extent, ptrdiff_t stride) {
+  const size_t n = isize(idx);
+  std::vector<ptrdiff_t> out(n);
+  for (size_t k = 0; k < n; ++k) {
+    const ptrdiff_t i = iat(idx, k);
+    if (i < 0 || static_cast<size_t>(i) >= extent) {
+      throw std::out_of_range("xmat::take/put: index out of range");
+    }
+    out[k] = i * stride;
+  }
+  return out;
+}
+
+// calls f(index) for every line along dim `line` of `shape`, index[line] = 0
+template<MOrder MOrderT, size_t ND, class Shape, typename F>
+void for_lines(const Shape& shape, size_t line, F&& f) {
+  std::array<size_t, ND> sh;
+  for (size_t i = 0; i < ND; ++i) {
+    if (!shape[i]) { return; }
+    sh[i] = i == line ? 1 : static_cast<size_t>(shape[i]);
+  }
+  std::array<size_t, ND> index{};
+  do { f(index); } while (hidx::next_outer<MOrderT>(index.data(), sh.data(), ND, 0));
+}
+
+template<size_t ND, class Stride>
+ptrdiff_t offset(const std::array<size_t, ND>& index, const Stride& stride) {
+  return hidx::conv(index.data(), stride.begin(), ND, ptrdiff_t{0});
+}
+
+// n elements with strides
+template<typename T>
+void copy_run(T* d, ptrdiff_t ds, const T* s, ptrdiff_t ss, size_t n) noexcept {
+  if (ds == 1 && ss == 1) {
+    std::copy_n(s, n, d);
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) { d[i * ds] = s[i * ss]; }
+}
+
+#if defined(XMAT_SELECT_AVX2)
+// 8 (4-byte T) or 4 (8-byte T) elements per gather, contiguous d
+template<typename T>
+size_t gather_simd(T* d, const T* s, const ptrdiff_t* off, size_t n, std::integral_constant<size_t, 4>) noexcept {
+  size_t k = 0;
+  for (; k + 8 <= n; k += 8) {
+    const __m256i o = _mm256_setr_epi32(int(off[k]), int(off[k + 1]), int(off[k + 2]), int(off[k + 3]),
+                                        int(off[k + 4]), int(off[k + 5]), int(off[k + 6]), int(off[k + 7]));
+    const __m256i v = _mm256_i32gather_epi32(reinterpret_cast<const int*>(s), o, 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + k), v);
+  }
+  return k;
+}
+
+template<typename T>
+size_t gather_simd(T* d, const T* s, const ptrdiff_t* off, size_t n, std::integral_constant<size_t, 8>) noexcept {
+  size_t k = 0;
+  for (; k + 4 <= n; k += 4) {
+    const __m256i o = _mm256_setr_epi64x(off[k], off[k + 1], off[k + 2], off[k + 3]);
+    const __m256i v = _mm256_i64gather_epi64(reinterpret_cast<const long long*>(s), o, 8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + k), v);
+  }
+  return k;
+}
+
+template<typename T, size_t N>
+size_t gather_simd(T*, const T*, const ptrdiff_t*, size_t, std::integral_constant<size_t, N>) noexcept { return 0; }
+#endif
+
+// d[k * ds] = s[off[k]]
+template<typename T>
+void gather(T* d, ptrdiff_t ds, const T* s, const std::vector<ptrdiff_t>& off, bool narrow) noexcept {
+  const size_t n = off.size();
+  size_t k = 0;
+#if defined(XMAT_SELECT_AVX2)
+  if (ds == 1 && narrow && std::is_trivially_copyable<T>::value) {
+    k = gather_simd(d, s, off.data(), n, std::integral_constant<size_t, sizeof(T)>{});
+  }
+#endif
+  (void)narrow;
+  for (; k < n; ++k) { d[k * ds] = s[off[k]]; }
+}
+
+// d[off[k]] = s[k * ss]
+template<typename T>
+void scatter(T* d, const std::vector<ptrdiff_t>& off, const T* s, ptrdiff_t ss) noexcept {
+  for (size_t k = 0, n = off.size(); k < n; ++k) { d[off[k]] = s[k * ss]; }
+}
+
+// offsets fit the 32-bit gather lanes
+inline bool narrow(const std::vector<ptrdiff_t>& off) noexcept {
+  return std::all_of(off.begin(), off.end(), [](ptrdiff_t o) { return o >= 0 && o <= INT32_MAX; });
+}
+
+template<size_t Axis, class D, class S>
+void check_shapes(const D& a, const S& b, size_t n, const char* msg) {
+  for (size_t i = 0; i < D::ndim; ++i) {
+    const size_t ea = static_cast<size_t>(a.shape()[i]), eb = static_cast<size_t>(b.shape()[i]);
+    if (i == Axis ? ea != n : ea != eb) { throw ShapeError(msg); }
+  }
+}
+
+// dst[..., k, ...] = src[..., idx[k], ...]
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S, class I>
+void take(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src, const I& idx) {
+  static_assert(Axis < ND, "xmat::take: Axis >= ndim");
+  static_assert(S::ndim == ND, "xmat::take: ndim mismatch");
+  static_assert(std::is_same<T, typename S::value_type>::value, "xmat::take: value_type mismatch");
+  check_shapes<Axis>(dst, src, isize(idx), "xmat::take: shape mismatch");
+  const auto off = offsets(idx, src.shape()[Axis], src.stride()[Axis]);
+  const size_t lo = hidx::morderlowi(MOrderT0, ND);
+  T* d = dst.ptr();
+  const T* s = src.ptr();
+  if (Axis == lo) {
+    const bool nw = narrow(off);
+    const ptrdiff_t ds = dst.stride()[Axis];
+    for_lines<MOrderT0, ND>(dst.shape(), Axis, [&](const std::array<size_t, ND>& index) {
+      gather(d + offset(index, dst.stride()), ds, s + offset(index, src.stride()), off, nw);
+    });
+  }
+  else {
+    // rows: the Axis coordinate of src comes from idx
+    const size_t n = dst.shape()[lo];
+    const ptrdiff_t ds = dst.stride()[lo], ss = src.stride()[lo];
+    for_lines<MOrderT0, ND>(dst.shape(), lo, [&](std::array<size_t, ND> index) {
+      T* dk = d + offset(index, dst.stride());
+      const ptrdiff_t ok = off[index[Axis]];
+      index[Axis] = 0;
+      copy_run(dk, ds, s + offset(index, src.stride()) + ok, ss, n);
+    });
+  }
+}
+
+// dst[..., idx[k], ...] = src[..., k, ...]
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class I, class S>
+void put(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const I& idx, const S& src) {
+  static_assert(Axis < ND, "xmat::put: Axis >= ndim");
+  static_assert(S::ndim == ND, "xmat::put: ndim mismatch");
+  static_assert(std::is_same<T, typename S::value_type>::value, "xmat::put: value_type mismatch");
+  check_shapes<Axis>(src, dst, isize(idx), "xmat::put: shape mismatch");
+  const auto off = offsets(idx, dst.shape()[Axis], dst.stride()[Axis]);
+  const size_t lo = hidx::morderlowi(MOrderT0, ND);
+  T* d = dst.ptr();
+  const T* s = src.ptr();
+  if (Axis == lo) {
+    const ptrdiff_t ss = src.stride()[Axis];
+    for_lines<MOrderT0, ND>(src.shape(), Axis, [&](const std::array<size_t, ND>& index) {
+      scatter(d + offset(index, dst.stride()), off, s + offset(index, src.stride()), ss);
+    });
+  }
+  else {
+    const size_t n = src.shape()[lo];
+    const ptrdiff_t ds = dst.stride()[lo], ss = src.stride()[lo];
+    for_lines<MOrderT0, ND>(src.shape(), lo, [&](std::array<size_t, ND> index) {
+      const T* sk = s + offset(index, src.stride());
+      const ptrdiff_t ok = off[index[Axis]];
+      index[Axis] = 0;
+      copy_run(d + offset(index, dst.stride()) + ok, ds, sk, ss, n);
+    });
+  }
+}
+
+
+// 16 mask bytes: bit i set if m[i] != 0
+#if defined(XMAT_SELECT_SSE2)
+inline unsigned bits16(const void* m) noexcept {
+  const __m128i x = _mm_loadu_si128(static_cast<const __m128i*>(m));
+  return ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128()))) & 0xffffu;
+}
+#endif
+
+inline size_t popcount16(unsigned x) noexcept {
+  x = x - ((x >> 1) & 0x5555u);
+  x = (x & 0x3333u) + ((x >> 2) & 0x3333u);
+  x = (x + (x >> 4)) & 0x0f0fu;
+  return (x + (x >> 8)) & 0x1fu;
+}
+
+template<typename M>
+constexpr bool byte_mask() noexcept { return sizeof(M) == 1 && std::is_integral<M>::value; }
+
+// nonzero mask elements of a run
+template<typename M>
+size_t count_run(const M* m, ptrdiff_t ms, size_t n) noexcept {
+  size_t i = 0, c = 0;
+#if defined(XMAT_SELECT_SSE2)
+  if (ms == 1 && byte_mask<M>()) {
+    for (; i + 16 <= n; i += 16) { c += popcount16(bits16(m + i)); }
+  }
+#endif
+  for (; i < n; ++i) { c += m[i * ms] ? 1 : 0; }
+  return c;
+}
+
+// d[j++ * ds] = s[i * ss] where m[i * ms], returns j; d past j is left alone,
+// mixed blocks are packed branchless into a 16-element scratch first
+template<typename T, typename M>
+size_t compress_run(T* d, ptrdiff_t ds, const T* s, ptrdiff_t ss, const M* m, ptrdiff_t ms, size_t n) noexcept {
+  size_t i = 0, j = 0;
+#if defined(XMAT_SELECT_SSE2)
+  if (ms == 1 && byte_mask<M>()) {
+    for (; i + 16 <= n; i += 16) {
+      const unsigned b = bits16(m + i);
+      if (b == 0) { continue; }
+      if (b == 0xffffu) {
+        copy_run(d + j * ds, ds, s + i * ss, ss, 16);
+        j += 16;
+        continue;
+      }
+      T buf[16];
+      size_t c = 0;
+      for (size_t k = 0; k < 16; ++k) {
+        buf[c] = s[(i + k) * ss];
+        c += (b >> k) & 1u;
+      }
+      copy_run(d + j * ds, ds, buf, 1, c);
+      j += c;
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (m[i * ms]) { d[j++ * ds] = s[i * ss]; }
+  }
+  return j;
+}
+
+// d[i * ds] = s[j++ * ss] where m[i * ms], returns j
+template<typename T, typename M>
+size_t expand_run(T* d, ptrdiff_t ds, const M* m, ptrdiff_t ms, const T* s, ptrdiff_t ss, size_t n) noexcept {
+  size_t i = 0, j = 0;
+#if defined(XMAT_SELECT_SSE2)
+  if (ms == 1 && byte_mask<M>()) {
+    for (; i + 16 <= n; i += 16) {
+      const unsigned b = bits16(m + i);
+      if (b == 0) { continue; }
+      if (b == 0xffffu) {
+        copy_run(d + i * ds, ds, s + j * ss, ss, 16);
+        j += 16;
+        continue;
+      }
+      for (size_t k = 0; k < 16; ++k) {
+        if ((b >> k) & 1u) { d[(i + k) * ds] = s[j++ * ss]; }
+      }
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (m[i * ms]) { d[i * ds] = s[j++ * ss]; }
+  }
+  return j;
+}
+
+template<class A, class K>
+void check_mask(const A& a, const K& mask, const char* msg) {
+  static_assert(A::ndim == K::ndim, "xmat::compress/expand: mask ndim mismatch");
+  if (!std::equal(a.shape().begin(), a.shape().end(), mask.shape().begin(),
+                  [](auto x, auto y) { return static_cast<size_t>(x) == static_cast<size_t>(y); })) {
+    throw ShapeError(msg);
+  }
+}
+
+// runs along the most data-local dim of `a`
+template<MOrder MOrderT, class A, class K, typename F>
+void for_mask_runs(const A& a, const K& mask, F&& f) {
+  constexpr size_t ND = A::ndim;
+  const size_t lo = hidx::morderlowi(MOrderT, ND);
+  for_lines<MOrderT, ND>(a.shape(), lo, [&](const std::array<size_t, ND>& index) {
+    f(offset(index, a.stride()), offset(index, mask.stride()), a.shape()[lo], a.stride()[lo], mask.stride()[lo]);
+  });
+}
+} // namespace impl_select
+
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S, class I>
+void take(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src, const I& idx) {
+  impl_select::take<Axis>(dst, src, idx);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S, class I>
+void take(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const S& src, const I& idx) {
+  impl_select::take<Axis>(dst, src, idx);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void take(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const S& src, std::initializer_list<size_t> idx) {
+  impl_select::take<Axis>(dst, src, idx);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class I, class S>
+void put(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const I& idx, const S& src) {
+  impl_select::put<Axis>(dst, idx, src);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class I, class S>
+void put(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const I& idx, const S& src) {
+  impl_select::put<Axis>(dst, idx, src);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S>
+void put(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, std::initializer_list<size_t> idx, const S& src) {
+  impl_select::put<Axis>(dst, idx, src);
+}
+
+// nonzero elements of a mask
+template<class D, typename M, size_t ND, MOrder MOrderT, typename IntT>
+size_t count_nonzero(const NArrayInterface_<D, M, ND, MOrderT, IntT>& mask) {
+  size_t c = 0;
+  impl_select::for_mask_runs<MOrderT>(mask, mask, [&](ptrdiff_t, ptrdiff_t om, size_t n, ptrdiff_t, ptrdiff_t ms) {
+    c += impl_select::count_run(mask.ptr() + om, ms, n);
+  });
+  return c;
+}
+
+// dst[j++] = src[i] where mask[i], in the memory order of src; dst is 1D
+// with at least count_nonzero(mask) elements, returns the count
+template<class D0, typename T, MOrder MOrderT0, typename IntT0,
+         class D1, size_t ND, MOrder MOrderT1, typename IntT1, class K>
+size_t compress(NArrayInterface_<D0, T, 1, MOrderT0, IntT0>& dst,
+                const NArrayInterface_<D1, T, ND, MOrderT1, IntT1>& src, const K& mask) {
+  impl_select::check_mask(src, mask, "xmat::compress: mask shape mismatch");
+  if (dst.shape()[0] < count_nonzero(mask)) {
+    throw ShapeError("xmat::compress: dst is too small");
+  }
+  T* d = dst.ptr();
+  const ptrdiff_t ds = dst.stride()[0];
+  size_t j = 0;
+  impl_select::for_mask_runs<MOrderT1>(src, mask,
+    [&](ptrdiff_t os, ptrdiff_t om, size_t n, ptrdiff_t ss, ptrdiff_t ms) {
+      j += impl_select::compress_run(d + ptrdiff_t(j) * ds, ds, src.ptr() + os, ss, mask.ptr() + om, ms, n);
+    });
+  return j;
+}
+
+template<class D0, typename T, MOrder MOrderT0, typename IntT0, class S, class K>
+size_t compress(NArrayInterface_<D0, T, 1, MOrderT0, IntT0>&& dst, const S& src, const K& mask) {
+  return compress(dst, src, mask);
+}
+
+// dst[i] = src[j++] where mask[i], in the memory order of dst; src is 1D
+// with at least count_nonzero(mask) elements, returns the count
+template<class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class K, class S>
+size_t expand(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& dst, const K& mask, const S& src) {
+  static_assert(std::is_same<T, typename S::value_type>::value, "xmat::expand: value_type mismatch");
+  static_assert(S::ndim == 1, "xmat::expand: src must be 1D");
+  impl_select::check_mask(dst, mask, "xmat::expand: mask shape mismatch");
+  if (static_cast<size_t>(src.shape()[0]) < count_nonzero(mask)) {
+    throw ShapeError("xmat::expand: src is too small");
+  }
+  const T* s = src.ptr();
+  const ptrdiff_t ss = src.stride()[0];
+  size_t j = 0;
+  impl_select::for_mask_runs<MOrderT0>(dst, mask,
+    [&](ptrdiff_t od, ptrdiff_t om, size_t n, ptrdiff_t ds, ptrdiff_t ms) {
+      j += impl_select::expand_run(dst.ptr() + od, ds, mask.ptr() + om, ms, s + ptrdiff_t(j) * ss, ss, n);
+    });
+  return j;
+}
+
+template<class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class K, class S>
+size_t expand(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>&& dst, const K& mask, const S& src) {
+  return expand(dst, mask, src);
+}
+} // namespace xmat
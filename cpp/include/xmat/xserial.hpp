@@ -10,6 +10,7 @@
 #include "xutil.hpp"
 #include "xdatastream.hpp"
 #include "xarray.hpp"
+#include "xconvert.hpp"
 
 
 namespace xmat
@@ -339,6 +340,56 @@ struct LoadTo<NArrayInterface_<Derived, T, ND, MOrderT, IntT>,
       }
     }
   }
+
+  // converting load: y = x * scale + offset from any registered numeric
+  // block type, see xconvert.hpp; read in chunks, no full-size temporary
+  template<typename IDStreamT>
+  static void load(XBlock& block,
+                   IDStreamT& ids,
+                   NArrayInterface_<Derived, T, ND, MOrderT, IntT>& y,
+                   double scale, double offset = 0)
+  {
+    if(block.ndim() > ND) {
+      throw DeserializationError("wrong ndim");
+    }
+    if(!std::equal(y.shape().cbegin(), 
+                   y.shape().cbegin() + block.ndim(), 
+                   block.shape().cbegin())) {
+      throw DeserializationError("wrong array's shape");
+    }
+    const bool known = visit_data_stream_type(block.t_, [&](auto tag) {
+      using S = typename decltype(tag)::type;
+      load_as<S>(ids, y, scale, offset, std::integral_constant<bool, impl_convert::convertible<T, S>()>{});
+    });
+    if(!known) {
+      throw DeserializationError("converting load(): unknown scalar type");
+    }
+  }
+
+ private:
+  template<typename S, typename IDStreamT>
+  static void load_as(IDStreamT& ids, NArrayInterface_<Derived, T, ND, MOrderT, IntT>& y,
+                      double scale, double offset, std::true_type) {
+    constexpr size_t k_chunk = 4096 / sizeof(S) + 1;
+    std::array<S, k_chunk> buf;
+    const size_t lo = hidx::morderlowi(MOrderT, ND);
+    const size_t n = y.shape()[lo];
+    const ptrdiff_t ds = y.stride()[lo];
+    T* d = y.ptr();
+    impl_convert::for_runs<MOrderT>(y, y, [&](ptrdiff_t od, ptrdiff_t) {
+      for (size_t i = 0; i < n; i += k_chunk) {
+        const size_t m = std::min(k_chunk, n - i);
+        ids.read(buf.data(), m);
+        impl_convert::convert(d + od + ptrdiff_t(i) * ds, ds, buf.data(), 1, m, scale, offset);
+      }
+    });
+  }
+
+  template<typename S, typename IDStreamT>
+  static void load_as(IDStreamT&, NArrayInterface_<Derived, T, ND, MOrderT, IntT>&,
+                      double, double, std::false_type) {
+    throw DeserializationError("converting load(): complex -> real");
+  }
 };
 
 
@@ -366,7 +417,12 @@ struct LoadTo<NArray_<T, ND, MemSourceT, MOrderT, IntT>,
 
   template<typename IDStreamT>
   static void load(XBlock& block, IDStreamT& ids, array_t& y) {
-    Load<typename array_t::base_t>::load(block, ids, y);
+    LoadTo<typename array_t::base_t>::load(block, ids, y);
+  }
+
+  template<typename IDStreamT>
+  static void load(XBlock& block, IDStreamT& ids, array_t& y, double scale, double offset = 0) {
+    LoadTo<typename array_t::base_t>::load(block, ids, y, scale, offset);
   }
 };
 
@@ -402,5 +458,46 @@ struct Load<NArray_<T, ND, MemSourceT, MOrderT, IntT>,
     return LoadArgs<array_t>::load(block, ids, MemSourceT{});
   }
 };
+
+
+// xmat::NArrayFixed_
+////////////////////////////////////////////////////////////////////////////////
+template<typename T, MOrder MOrderT, size_t ... Shape>
+struct Dump<NArrayFixed_<T, MOrderT, Shape...>, std::enable_if_t<DataStreamType<T>::enabled>>
+{
+  static const bool enabled = true;
+  using array_t = NArrayFixed_<T, MOrderT, Shape...>;
+
+  template<typename ODStreamT>
+  static void dump(XBlock& block, ODStreamT& ods, const array_t& x) {
+    Dump<typename array_t::base_t>::dump(block, ods, x);
+  }
+};
+
+template<typename T, MOrder MOrderT, size_t ... Shape>
+struct LoadTo<NArrayFixed_<T, MOrderT, Shape...>, std::enable_if_t<DataStreamType<T>::enabled>>
+{
+  static const bool enabled = true;
+  using array_t = NArrayFixed_<T, MOrderT, Shape...>;
+
+  template<typename IDStreamT>
+  static void load(XBlock& block, IDStreamT& ids, array_t& y) {
+    LoadTo<typename array_t::base_t>::load(block, ids, y);
+  }
+};
+
+template<typename T, MOrder MOrderT, size_t ... Shape>
+struct Load<NArrayFixed_<T, MOrderT, Shape...>, std::enable_if_t<DataStreamType<T>::enabled>>
+{
+  static const bool enabled = true;
+  using array_t = NArrayFixed_<T, MOrderT, Shape...>;
+
+  template<typename IDStreamT>
+  static array_t load(XBlock& block, IDStreamT& ids) {
+    array_t y;
+    LoadTo<typename array_t::base_t>::load(block, ids, y);
+    return y;
+  }
+};
 } // namespase serial
 } // namespace xmat
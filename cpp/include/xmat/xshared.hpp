@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "xarray.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Reference-counted storage and owning views
+// ------------------------------------------------------------
+//   xmat::NArrayShared<float, 2> frame{{8, 1024}};          // refcounted buffer
+//   auto s = xmat::share(std::move(frame));                 // SharedView_, frame is empty
+//   pool.submit([s]() { ... });                             // copies share the buffer
+//   auto rows = s.share(s.view<2>({xmat::Slice(0, 2), xmat::sl::all}));  // owning sub-view
+//   s.detach();                                             // copy-on-write before mutating
+//
+// The buffer lives while any array or SharedView_ refers to it. The count
+// is atomic: SharedView_ copies can be made and dropped from any thread.
+// Elements are not synchronized: concurrent readers are fine, a writer
+// calls detach() first to get a private copy if the buffer is shared.
+
+// counted block, deletes itself with the last reference
+struct SharedBlockBase {
+  virtual ~SharedBlockBase() = default;
+
+  // new block with n elements from the same memory source
+  virtual SharedBlockBase* make_like(size_t n) const = 0;
+  virtual void* data() noexcept = 0;
+
+  std::atomic<size_t> refs{1};
+};
+
+template<typename T, class MemSourceT>
+struct SharedBlock_ : public SharedBlockBase {
+  SharedBlock_(const MemSourceT& memsrc, size_t n) : memsource_{memsrc}, n_{n} {
+    data_ = memsource_.allocate(n_);  // may throw
+  }
+
+  ~SharedBlock_() override { memsource_.deallocate(data_, n_); }
+
+  SharedBlockBase* make_like(size_t n) const override { return new SharedBlock_(memsource_, n); }
+  void* data() noexcept override { return data_; }
+
+  MemSourceT memsource_;
+  T* data_ = nullptr;
+  size_t n_ = 0;
+};
+
+// one counted reference to a block
+class SharedRef {
+ public:
+  SharedRef() = default;
+  explicit SharedRef(SharedBlockBase* block) noexcept : block_{block} { }
+
+  SharedRef(const SharedRef& other) noexcept : block_{other.block_} {
+    if (block_) { block_->refs.fetch_add(1, std::memory_order_relaxed); }
+  }
+
+  SharedRef(SharedRef&& other) noexcept : block_{other.block_} { other.block_ = nullptr; }
+
+  SharedRef& operator=(SharedRef other) noexcept {
+    swap(*this, other);
+    return *this;
+  }
+
+  ~SharedRef() { reset(); }
+
+  friend void swap(SharedRef& lhs, SharedRef& rhs) noexcept { std::swap(lhs.block_, rhs.block_); }
+
+  void reset() noexcept {
+    if (block_ && block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) { delete block_; }
+    block_ = nullptr;
+  }
+
+  size_t use_count() const noexcept { return block_ ? block_->refs.load(std::memory_order_acquire) : 0; }
+  SharedBlockBase* get() const noexcept { return block_; }
+  explicit operator bool() const noexcept { return block_ != nullptr; }
+
+ private:
+  SharedBlockBase* block_ = nullptr;
+};
+
+
+// Memory source tag: NArray_<T, ND, Shared<MemSourceT>> keeps its elements
+// in a refcounted block allocated by MemSourceT, see share().
+template<class MemSourceT>
+struct Shared : public MemSourceT {
+  Shared() = default;
+  Shared(const MemSourceT& memsrc) : MemSourceT{memsrc} {}
+};
+
+template<typename T, class MemSourceT>
+struct NArrayStorage_<T, Shared<MemSourceT>> {
+  using memory_source_t = Shared<MemSourceT>;
+  using block_t = SharedBlock_<T, MemSourceT>;
+
+  static constexpr bool k_has_default_constructor = std::is_default_constructible<memory_source_t>::value;
+
+  template<bool HDC = k_has_default_constructor, typename std::enable_if<HDC, int>::type = 0>
+  NArrayStorage_() {}
+
+  NArrayStorage_(const memory_source_t& memsrc) : memsource_{memsrc} {}
+
+  // a copy of the storage itself refers to the same block; NArray_'s copy
+  // constructor allocates a new block and deep-copies the elements
+  NArrayStorage_(const NArrayStorage_& other) = default;
+
+  NArrayStorage_(NArrayStorage_&& other) noexcept
+  : memsource_{other.memsource_}  { swap(*this, other); }
+
+  NArrayStorage_& operator=(NArrayStorage_ other) noexcept {
+    swap(*this, other);
+    return *this;
+  }
+
+  friend void swap(NArrayStorage_& lhs, NArrayStorage_& rhs) noexcept {
+    using std::swap;
+    swap(lhs.memsource_, rhs.memsource_);
+    swap(lhs.ref_, rhs.ref_);
+    swap(lhs.data_, rhs.data_);
+    swap(lhs.N_, rhs.N_);
+  }
+
+  T* data() noexcept { return data_; }
+  const T* data() const noexcept { return data_; }
+  size_t size() const noexcept { return N_; }
+
+  void init(std::size_t n, size_t /*align*/ = 0) {
+    auto* block = new block_t{memsource_, n};
+    ref_ = SharedRef{block};
+    data_ = block->data_;
+    N_ = n;
+  }
+
+  // growth takes a new block, views keep the old one
+  bool extend(size_t /*nmin*/, size_t /*nmax*/) noexcept { return false; }
+
+  const SharedRef& ref() const noexcept { return ref_; }
+  size_t use_count() const noexcept { return ref_.use_count(); }
+
+ public:
+  memory_source_t memsource_;
+  SharedRef ref_;
+  T* data_ = nullptr;
+  size_t N_ = 0;
+};
+
+
+// Owning view: a View_ that keeps its buffer alive
+template<typename T, size_t ND, MOrder MOrderT = MOrder::C, typename IntT = size_t>
+struct SharedView_ : public NArrayInterface_<SharedView_<T, ND, MOrderT, IntT>, T, ND, MOrderT, IntT> {
+  using this_t = SharedView_<T, ND, MOrderT, IntT>;
+  using base_t = NArrayInterface_<this_t, T, ND, MOrderT, IntT>;
+  using typename base_t::value_type;
+  using typename base_t::ravel_t;
+  using typename base_t::index_t;
+  using base_t::ndim;
+
+  SharedView_() = default;
+
+  // `v` must point into the block of `ref`
+  SharedView_(SharedRef ref, const View_<T, ND, MOrderT, IntT>& v) noexcept
+  : ptr_{v.ptr_}, ravel_{v.ravel_}, ref_{std::move(ref)} { }
+
+  // owning view of a part of this one: s.share(s.view<2>({...}))
+  template<size_t ND_, typename IntT_>
+  SharedView_<T, ND_, MOrderT, IntT_> share(const View_<T, ND_, MOrderT, IntT_>& v) const noexcept {
+    return {ref_, v};
+  }
+
+  // arrays and views referring to the buffer
+  size_t use_count() const noexcept { return ref_.use_count(); }
+  bool unique() const noexcept { return use_count() == 1; }
+
+  // copy-on-write: a private compact copy if the buffer is shared
+  void detach() {
+    if (!ref_ || unique()) { return; }
+    const size_t n = this->numel();
+    SharedRef ref{ref_.get()->make_like(n)};
+    T* p = static_cast<T*>(ref.get()->data());
+    std::copy(this->fbegin(), this->fend(), p);
+    ptr_ = p;
+    ravel_ = ravel_t{this->shape()};
+    ref_ = std::move(ref);
+  }
+
+  T* ptr_ = nullptr;
+  ravel_t ravel_;
+  SharedRef ref_;
+};
+
+template<typename T, size_t ND, MOrder MOrderT, typename IntT>
+struct ViewForNarray<SharedView_<T, ND, MOrderT, IntT>> {
+  template<size_t ND_, typename IntT_>
+  using view_t = View_<T, ND_, MOrderT, IntT_>;
+
+  template<size_t ND_, typename IntT_>
+  using viterator_t = VIterator_<T, ND_, MOrderT, IntT_>;
+};
+
+template<typename T, size_t ND> using SharedView = SharedView_<T, ND, MOrder::C, size_t>;
+template<typename T, size_t ND> using SharedViewF = SharedView_<T, ND, MOrder::F, size_t>;
+
+// std::allocator, refcounted
+template<typename T, size_t ND>
+using NArrayShared = NArray_<T, ND, Shared<std::allocator<T>>, MOrder::C, size_t>;
+
+template<typename T, size_t ND>
+using NArraySharedxF = NArray_<T, ND, Shared<std::allocator<T>>, MOrder::F, size_t>;
+
+
+// owning view of the whole array, the array keeps its reference
+template<typename T, size_t ND, class MemSourceT, MOrder MOrderT, typename IntT>
+SharedView_<T, ND, MOrderT, IntT> share(NArray_<T, ND, Shared<MemSourceT>, MOrderT, IntT>& a) noexcept {
+  return {a.storage_.ref(), View_<T, ND, MOrderT, IntT>{a.ptr(), a.ravel()}};
+}
+
+// owning view of a part of the array: share(a, a.view<1>({...}))
+template<typename T, size_t ND, class MemSourceT, MOrder MOrderT, typename IntT, size_t ND_, typename IntT_>
+SharedView_<T, ND_, MOrderT, IntT_> share(NArray_<T, ND, Shared<MemSourceT>, MOrderT, IntT>& a,
+                                          const View_<T, ND_, MOrderT, IntT_>& v) noexcept {
+  return {a.storage_.ref(), v};
+}
+
+// the array hands its buffer over and is left empty
+template<typename T, size_t ND, class MemSourceT, MOrder MOrderT, typename IntT>
+SharedView_<T, ND, MOrderT, IntT> share(NArray_<T, ND, Shared<MemSourceT>, MOrderT, IntT>&& a) noexcept {
+  NArray_<T, ND, Shared<MemSourceT>, MOrderT, IntT> tmp{std::move(a)};
+  return share(tmp);
+}
+} // namespace xmat
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+
+#include <array>
+#include <algorithm>
+#include <complex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+#include "xthreadpool.hpp"
+
+
+namespace xmat {
+
+// ------------------------------------------------------------
+// Sorting along an axis
+// ------------------------------------------------------------
+//   xmat::sort<1>(x);                          // every row of x: [C, N], in place
+//   xmat::argsort<1>(idx, x);                  // idx[c, k]: index of the k-th smallest of row c
+//   xmat::nth_element<1>(x, 3);                // x[c, 3] in sorted position, smaller before
+//   xmat::topk<1>(vals, idx, x);               // vals, idx: [C, K], K largest by default
+//   xmat::sort<1>(x, xmat::ord::abs_greater{}); // by magnitude, largest first
+//
+// Rows may be strided views; a strided row is gathered into a buffer,
+// sorted and written back. Rows of up to 8 elements go through sorting
+// networks, min/max instructions without branches for real types in
+// ord::less/greater order. Complex values are ordered by magnitude. argsort and
+// topk break ties by index, so their results do not depend on the
+// algorithm. NaNs give an unspecified order.
+// Threaded versions at the end: xmat::par::sort/argsort/nth_element/topk.
+namespace impl_sort {
+
+template<typename T> T key(const T& x) noexcept { return x; }
+template<typename T> T key(const std::complex<T>& x) noexcept { return std::norm(x); }
+
+template<typename T, std::enable_if_t<std::is_signed<T>::value, int> = 0>
+T abs_key(const T& x) noexcept { return x < 0 ? -x : x; }
+template<typename T, std::enable_if_t<!std::is_signed<T>::value, int> = 0>
+T abs_key(const T& x) noexcept { return x; }
+template<typename T> T abs_key(const std::complex<T>& x) noexcept { return std::norm(x); }
+} // namespace impl_sort
+
+
+// Orderings: strict weak orders on elements
+namespace ord {
+
+struct less {
+  template<typename T>
+  bool operator()(const T& a, const T& b) const noexcept { return impl_sort::key(a) < impl_sort::key(b); }
+};
+
+struct greater {
+  template<typename T>
+  bool operator()(const T& a, const T& b) const noexcept { return impl_sort::key(b) < impl_sort::key(a); }
+};
+
+// by magnitude
+struct abs_less {
+  template<typename T>
+  bool operator()(const T& a, const T& b) const noexcept { return impl_sort::abs_key(a) < impl_sort::abs_key(b); }
+};
+
+struct abs_greater {
+  template<typename T>
+  bool operator()(const T& a, const T& b) const noexcept { return impl_sort::abs_key(b) < impl_sort::abs_key(a); }
+};
+} // namespace ord
+
+
+namespace impl_sort {
+
+// element with its index along the axis
+template<typename T>
+struct Item { T v; size_t i; };
+
+// ordering of items, ties by index
+template<class Cmp>
+struct ItemCmp {
+  Cmp cmp;
+  template<typename T>
+  bool operator()(const Item<T>& a, const Item<T>& b) const {
+    return cmp(a.v, b.v) || (!cmp(b.v, a.v) && a.i < b.i);
+  }
+};
+
+// a, b = min, max without branches
+template<typename T, class Cmp>
+void cswap(T& a, T& b, const Cmp& cmp) {
+  const bool c = cmp(b, a);
+  const T lo = c ? b : a;
+  const T hi = c ? a : b;
+  a = lo;
+  b = hi;
+}
+
+// arithmetic types in natural order: min/max instructions
+template<typename T, std::enable_if_t<std::is_arithmetic<T>::value, int> = 0>
+void cswap(T& a, T& b, const ord::less&) noexcept {
+  const T lo = std::min(a, b);
+  b = std::max(a, b);
+  a = lo;
+}
+
+template<typename T, std::enable_if_t<std::is_arithmetic<T>::value, int> = 0>
+void cswap(T& a, T& b, const ord::greater&) noexcept {
+  const T hi = std::max(a, b);
+  b = std::min(a, b);
+  a = hi;
+}
+
+constexpr size_t k_max_network = 8;
+
+// v[0..n), n <= k_max_network: optimal-size sorting networks
+template<typename T, class Cmp>
+void sort_small(T* v, size_t n, const Cmp& cmp) {
+  auto cs = [&](size_t i, size_t j) { cswap(v[i], v[j], cmp); };
+  switch (n) {
+    case 2: cs(0, 1); break;
+    case 3: cs(0, 1); cs(1, 2); cs(0, 1); break;
+    case 4: cs(0, 1); cs(2, 3); cs(0, 2); cs(1, 3); cs(1, 2); break;
+    case 5:
+      cs(0, 1); cs(3, 4); cs(2, 4); cs(2, 3); cs(0, 3); cs(0, 2); cs(1, 4); cs(1, 3); cs(1, 2);
+      break;
+    case 6:
+      cs(1, 2); cs(0, 2); cs(0, 1); cs(4, 5); cs(3, 5); cs(3, 4);
+      cs(0, 3); cs(1, 4); cs(2, 5); cs(2, 4); cs(1, 3); cs(2, 3);
+      break;
+    case 7:
+      cs(1, 2); cs(0, 2); cs(0, 1); cs(3, 4); cs(5, 6); cs(3, 5); cs(4, 6); cs(4, 5);
+      cs(0, 4); cs(0, 3); cs(1, 5); cs(2, 6); cs(2, 5); cs(1, 3); cs(2, 4); cs(2, 3);
+      break;
+    case 8:
+      cs(0, 1); cs(2, 3); cs(0, 2); cs(1, 3); cs(1, 2); cs(4, 5); cs(6, 7); cs(4, 6); cs(5, 7); cs(5, 6);
+      cs(0, 4); cs(1, 5); cs(1, 4); cs(2, 6); cs(3, 7); cs(3, 6); cs(2, 4); cs(3, 5); cs(3, 4);
+      break;
+    default: break;
+  }
+}
+
+// calls f(index) for every line along `Axis` of `shape`, index[Axis] = 0
+template<size_t Axis, MOrder MOrderT, size_t ND, class Shape, typename F>
+void for_lines(const Shape& shape, F&& f) {
+  std::array<size_t, ND> sh;
+  for (size_t i = 0; i < ND; ++i) {
+    if (!shape[i]) { return; }
+    sh[i] = i == Axis ? 1 : static_cast<size_t>(shape[i]);
+  }
+  std::array<size_t, ND> index{};
+  do { f(index); } while (hidx::next_outer<MOrderT>(index.data(), sh.data(), ND, 0));
+}
+
+template<size_t ND, class Stride>
+ptrdiff_t offset(const std::array<size_t, ND>& index, const Stride& stride) {
+  return hidx::conv(index.data(), stride.begin(), ND, ptrdiff_t{0});
+}
+
+// NArray_/View_, not an ordering
+template<class D, typename T, size_t ND, MOrder MOrderT, typename IntT>
+std::true_type is_array_(const NArrayInterface_<D, T, ND, MOrderT, IntT>*);
+std::false_type is_array_(const void*);
+template<class A> using is_array = decltype(is_array_(std::declval<A*>()));
+
+// shapes equal except along `Axis`, Axis = ND: all of them
+template<size_t Axis, class D, class S>
+void check_shapes(const D& a, const S& b, const char* msg) {
+  for (size_t d = 0; d < a.ndim; ++d) {
+    if (d != Axis && a.shape()[d] != b.shape()[d]) { throw ShapeError(msg); }
+  }
+}
+
+template<typename T>
+void gather(T* d, const T* s, ptrdiff_t ss, size_t n) noexcept {
+  for (size_t i = 0; i < n; ++i) { d[i] = s[i * ss]; }
+}
+
+template<typename T>
+void scatter(T* d, ptrdiff_t ds, const T* s, size_t n) noexcept {
+  for (size_t i = 0; i < n; ++i) { d[i * ds] = s[i]; }
+}
+
+// p[k * s], k < n in order
+template<typename T, class Cmp>
+void sort_line(T* p, ptrdiff_t s, size_t n, const Cmp& cmp, std::vector<T>& buf) {
+  if (n <= k_max_network) {
+    T v[k_max_network];
+    gather(v, p, s, n);
+    sort_small(v, n, cmp);
+    scatter(p, s, v, n);
+  } else if (s == 1) {
+    std::sort(p, p + n, cmp);
+  } else {
+    buf.resize(n);
+    gather(buf.data(), p, s, n);
+    std::sort(buf.begin(), buf.end(), cmp);
+    scatter(p, s, buf.data(), n);
+  }
+}
+
+// p[kth * s] in sorted position, smaller before, not smaller after
+template<typename T, class Cmp>
+void nth_line(T* p, ptrdiff_t s, size_t n, size_t kth, const Cmp& cmp, std::vector<T>& buf) {
+  if (n <= k_max_network) {
+    sort_line(p, s, n, cmp, buf);
+  } else if (s == 1) {
+    std::nth_element(p, p + kth, p + n, cmp);
+  } else {
+    buf.resize(n);
+    gather(buf.data(), p, s, n);
+    std::nth_element(buf.begin(), buf.begin() + kth, buf.end(), cmp);
+    scatter(p, s, buf.data(), n);
+  }
+}
+
+template<typename T>
+void load_items(Item<T>* v, const T* p, ptrdiff_t s, size_t n) noexcept {
+  for (size_t i = 0; i < n; ++i) { v[i] = {p[i * s], i}; }
+}
+
+// q[k * qs] = index of the k-th element of p[.. * s]
+template<typename T, typename I, class Cmp>
+void argsort_line(I* q, ptrdiff_t qs, const T* p, ptrdiff_t s, size_t n, const ItemCmp<Cmp>& cmp,
+                  std::vector<Item<T>>& buf) {
+  buf.resize(n);
+  load_items(buf.data(), p, s, n);
+  if (n <= k_max_network) { sort_small(buf.data(), n, cmp); }
+  else                    { std::sort(buf.begin(), buf.end(), cmp); }
+  for (size_t k = 0; k < n; ++k) { q[k * qs] = static_cast<I>(buf[k].i); }
+}
+
+// the first k of p[.. * s] in order into buf[0..k). Short k: one pass with a
+// heap of the k best so far, its top is the worst of them
+template<typename T, class Cmp>
+void topk_line(const T* p, ptrdiff_t s, size_t n, size_t k, const ItemCmp<Cmp>& cmp,
+               std::vector<Item<T>>& buf) {
+  if (k == 0) { return; }
+  if (k * 16 <= n) {
+    buf.resize(k);
+    load_items(buf.data(), p, s, k);
+    std::make_heap(buf.begin(), buf.end(), cmp);
+    for (size_t i = k; i < n; ++i) {
+      const T& x = p[i * s];
+      if (cmp.cmp(x, buf.front().v)) {  // later index loses ties
+        std::pop_heap(buf.begin(), buf.end(), cmp);
+        buf.back() = {x, i};
+        std::push_heap(buf.begin(), buf.end(), cmp);
+      }
+    }
+    std::sort_heap(buf.begin(), buf.end(), cmp);
+    return;
+  }
+  buf.resize(n);
+  load_items(buf.data(), p, s, n);
+  if (k < n) { std::nth_element(buf.begin(), buf.begin() + (k - 1), buf.end(), cmp); }
+  std::sort(buf.begin(), buf.begin() + k, cmp);
+}
+
+
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp>
+void sort(NArrayInterface_<D, T, ND, MOrderT, IntT>& x, const Cmp& cmp) {
+  static_assert(Axis < ND, "xmat::sort(): Axis must be less than ND");
+  const size_t n = x.shape()[Axis];
+  const ptrdiff_t s = static_cast<ptrdiff_t>(x.stride()[Axis]);
+  std::vector<T> buf;
+  for_lines<Axis, MOrderT, ND>(x.shape(), [&](const std::array<size_t, ND>& index) {
+    sort_line(x.ptr() + offset(index, x.stride()), s, n, cmp, buf);
+  });
+}
+
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp>
+void nth_element(NArrayInterface_<D, T, ND, MOrderT, IntT>& x, size_t kth, const Cmp& cmp) {
+  static_assert(Axis < ND, "xmat::nth_element(): Axis must be less than ND");
+  const size_t n = x.shape()[Axis];
+  if (n == 0) { return; }
+  if (kth >= n) { throw std::out_of_range("xmat::nth_element(): kth out of range"); }
+  const ptrdiff_t s = static_cast<ptrdiff_t>(x.stride()[Axis]);
+  std::vector<T> buf;
+  for_lines<Axis, MOrderT, ND>(x.shape(), [&](const std::array<size_t, ND>& index) {
+    nth_line(x.ptr() + offset(index, x.stride()), s, n, kth, cmp, buf);
+  });
+}
+
+template<size_t Axis, class D0, typename I, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename T, MOrder MOrderT1, typename IntT1, class Cmp>
+void argsort(NArrayInterface_<D0, I, ND, MOrderT0, IntT0>& idx,
+             const NArrayInterface_<D1, T, ND, MOrderT1, IntT1>& x, const Cmp& cmp) {
+  static_assert(Axis < ND, "xmat::argsort(): Axis must be less than ND");
+  static_assert(std::is_integral<I>::value, "xmat::argsort(): integer indices expected");
+  check_shapes<ND>(idx, x, "xmat::argsort(): idx and x shapes mismatch");
+  using U = std::remove_const_t<T>;
+  const size_t n = x.shape()[Axis];
+  const ptrdiff_t s = static_cast<ptrdiff_t>(x.stride()[Axis]);
+  const ptrdiff_t qs = static_cast<ptrdiff_t>(idx.stride()[Axis]);
+  const ItemCmp<Cmp> icmp{cmp};
+  std::vector<Item<U>> buf;
+  for_lines<Axis, MOrderT1, ND>(x.shape(), [&](const std::array<size_t, ND>& index) {
+    argsort_line(idx.ptr() + offset(index, idx.stride()), qs,
+                 x.ptr() + offset(index, x.stride()), s, n, icmp, buf);
+  });
+}
+
+// idx may be nullptr
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class I, class S, class Cmp>
+void topk(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& vals, I* idx, const S& x, const Cmp& cmp) {
+  static_assert(Axis < ND, "xmat::topk(): Axis must be less than ND");
+  static_assert(std::is_same<std::remove_const_t<typename S::value_type>, T>::value,
+                "xmat::topk(): vals and x element types differ");
+  using Q = typename I::value_type;
+  static_assert(std::is_integral<Q>::value, "xmat::topk(): integer indices expected");
+  check_shapes<Axis>(vals, x, "xmat::topk(): vals and x shapes mismatch");
+  if (idx) { check_shapes<ND>(*idx, vals, "xmat::topk(): idx and vals shapes mismatch"); }
+  const size_t n = x.shape()[Axis], k = vals.shape()[Axis];
+  if (k > n) { throw ShapeError("xmat::topk(): k is larger than the axis"); }
+  const ptrdiff_t s = static_cast<ptrdiff_t>(x.stride()[Axis]);
+  const ptrdiff_t vs = static_cast<ptrdiff_t>(vals.stride()[Axis]);
+  const ptrdiff_t qs = idx ? static_cast<ptrdiff_t>(idx->stride()[Axis]) : 0;
+  const ItemCmp<Cmp> icmp{cmp};
+  std::vector<Item<T>> buf;
+  for_lines<Axis, MOrderT0, ND>(vals.shape(), [&](const std::array<size_t, ND>& index) {
+    topk_line(x.ptr() + offset(index, x.stride()), s, n, k, icmp, buf);
+    T* v = vals.ptr() + offset(index, vals.stride());
+    for (size_t j = 0; j < k; ++j) { v[j * vs] = buf[j].v; }
+    if (idx) {
+      Q* q = idx->ptr() + offset(index, idx->stride());
+      for (size_t j = 0; j < k; ++j) { q[j * qs] = static_cast<Q>(buf[j].i); }
+    }
+  });
+}
+} // namespace impl_sort
+
+
+// sorts every line along `Axis` in place
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp = ord::less>
+void sort(NArrayInterface_<D, T, ND, MOrderT, IntT>& x, Cmp cmp = {}) {
+  impl_sort::sort<Axis>(x, cmp);
+}
+
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp = ord::less>
+void sort(NArrayInterface_<D, T, ND, MOrderT, IntT>&& x, Cmp cmp = {}) {
+  impl_sort::sort<Axis>(x, cmp);
+}
+
+// partitions every line along `Axis` around its kth element
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp = ord::less>
+void nth_element(NArrayInterface_<D, T, ND, MOrderT, IntT>& x, size_t kth, Cmp cmp = {}) {
+  impl_sort::nth_element<Axis>(x, kth, cmp);
+}
+
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp = ord::less>
+void nth_element(NArrayInterface_<D, T, ND, MOrderT, IntT>&& x, size_t kth, Cmp cmp = {}) {
+  impl_sort::nth_element<Axis>(x, kth, cmp);
+}
+
+// idx: integer array of x's shape, the order of every line along `Axis`
+template<size_t Axis, class D0, typename I, size_t ND, MOrder MOrderT0, typename IntT0, class S,
+         class Cmp = ord::less>
+void argsort(NArrayInterface_<D0, I, ND, MOrderT0, IntT0>& idx, const S& x, Cmp cmp = {}) {
+  impl_sort::argsort<Axis>(idx, x, cmp);
+}
+
+template<size_t Axis, class D0, typename I, size_t ND, MOrder MOrderT0, typename IntT0, class S,
+         class Cmp = ord::less>
+void argsort(NArrayInterface_<D0, I, ND, MOrderT0, IntT0>&& idx, const S& x, Cmp cmp = {}) {
+  impl_sort::argsort<Axis>(idx, x, cmp);
+}
+
+// the first k = vals.shape()[Axis] elements of every line along `Axis` in
+// order, largest first by default, and their indices along `Axis`
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename I, MOrder MOrderT1, typename IntT1, class S, class Cmp = ord::greater>
+void topk(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& vals, NArrayInterface_<D1, I, ND, MOrderT1, IntT1>& idx,
+          const S& x, Cmp cmp = {}) {
+  impl_sort::topk<Axis>(vals, &idx, x, cmp);
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0, class S,
+         class Cmp = ord::greater, std::enable_if_t<!impl_sort::is_array<Cmp>::value, int> = 0>
+void topk(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& vals, const S& x, Cmp cmp = {}) {
+  impl_sort::topk<Axis>(vals, static_cast<View_<size_t, ND, MOrderT0, IntT0>*>(nullptr), x, cmp);
+}
+
+
+namespace par {
+
+namespace impl_par {
+
+// the least data-local dim other than `Axis`, ND if there is none
+template<size_t Axis, MOrder MOrderT, size_t ND>
+constexpr size_t line_split_dim() noexcept {
+  return ND < 2 ? ND : MOrderT == MOrder::C ? (Axis == 0 ? 1 : 0) : (Axis == ND - 1 ? ND - 2 : ND - 1);
+}
+
+// f(i0, i1) for chunks of rows [i0, i1) of the split dim, every line along
+// the sorted axis is in one chunk
+template<typename F>
+void for_line_chunks(size_t numel, size_t nrows, size_t grain, ThreadPool& pool, F&& f) {
+  const auto pl = plan(numel, nrows, grain, pool.size());
+  pool.parallel_for(pl.nchunk, [&](size_t c) {
+    const size_t i0 = c * pl.rows;
+    f(i0, std::min(i0 + pl.rows, nrows));
+  });
+}
+} // namespace impl_par
+
+
+// xmat::sort/nth_element/argsort/topk, lines along `Axis` are split between threads
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp = ord::less>
+void sort(NArrayInterface_<D, T, ND, MOrderT, IntT>& x, Cmp cmp = {},
+          size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  constexpr size_t d = impl_par::line_split_dim<Axis, MOrderT, ND>();
+  if (d == ND) { return impl_sort::sort<Axis>(x, cmp); }
+  impl_par::for_line_chunks(x.numel(), x.shape()[d], grain, pool, [&](size_t i0, size_t i1) {
+    auto c = impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1);
+    impl_sort::sort<Axis>(c, cmp);
+  });
+}
+
+template<size_t Axis, class D, typename T, size_t ND, MOrder MOrderT, typename IntT, class Cmp = ord::less>
+void nth_element(NArrayInterface_<D, T, ND, MOrderT, IntT>& x, size_t kth, Cmp cmp = {},
+                 size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  constexpr size_t d = impl_par::line_split_dim<Axis, MOrderT, ND>();
+  if (d == ND) { return impl_sort::nth_element<Axis>(x, kth, cmp); }
+  if (x.shape()[Axis] && kth >= x.shape()[Axis]) { throw std::out_of_range("xmat::nth_element(): kth out of range"); }
+  impl_par::for_line_chunks(x.numel(), x.shape()[d], grain, pool, [&](size_t i0, size_t i1) {
+    auto c = impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1);
+    impl_sort::nth_element<Axis>(c, kth, cmp);
+  });
+}
+
+template<size_t Axis, class D0, typename I, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename T, MOrder MOrderT1, typename IntT1, class Cmp = ord::less>
+void argsort(NArrayInterface_<D0, I, ND, MOrderT0, IntT0>& idx, const NArrayInterface_<D1, T, ND, MOrderT1, IntT1>& x,
+             Cmp cmp = {}, size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  constexpr size_t d = impl_par::line_split_dim<Axis, MOrderT1, ND>();
+  if (d == ND) { return impl_sort::argsort<Axis>(idx, x, cmp); }
+  impl_sort::check_shapes<ND>(idx, x, "xmat::argsort(): idx and x shapes mismatch");
+  impl_par::for_line_chunks(x.numel(), x.shape()[d], grain, pool, [&](size_t i0, size_t i1) {
+    auto q = impl_par::chunk(idx.ptr(), idx.ravel(), d, i0, i1);
+    impl_sort::argsort<Axis>(q, impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1), cmp);
+  });
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D1, typename I, MOrder MOrderT1, typename IntT1,
+         class D2, typename TS, MOrder MOrderT2, typename IntT2, class Cmp = ord::greater>
+void topk(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& vals, NArrayInterface_<D1, I, ND, MOrderT1, IntT1>& idx,
+          const NArrayInterface_<D2, TS, ND, MOrderT2, IntT2>& x, Cmp cmp = {},
+          size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  constexpr size_t d = impl_par::line_split_dim<Axis, MOrderT2, ND>();
+  if (d == ND) { return impl_sort::topk<Axis>(vals, &idx, x, cmp); }
+  impl_sort::check_shapes<Axis>(vals, x, "xmat::topk(): vals and x shapes mismatch");
+  impl_par::for_line_chunks(x.numel(), x.shape()[d], grain, pool, [&](size_t i0, size_t i1) {
+    auto v = impl_par::chunk(vals.ptr(), vals.ravel(), d, i0, i1);
+    auto q = impl_par::chunk(idx.ptr(), idx.ravel(), d, i0, i1);
+    impl_sort::topk<Axis>(v, &q, impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1), cmp);
+  });
+}
+
+template<size_t Axis, class D0, typename T, size_t ND, MOrder MOrderT0, typename IntT0,
+         class D2, typename TS, MOrder MOrderT2, typename IntT2, class Cmp = ord::greater,
+         std::enable_if_t<!impl_sort::is_array<Cmp>::value, int> = 0>
+void topk(NArrayInterface_<D0, T, ND, MOrderT0, IntT0>& vals, const NArrayInterface_<D2, TS, ND, MOrderT2, IntT2>& x,
+          Cmp cmp = {}, size_t grain = k_grain, ThreadPool& pool = ThreadPool::global()) {
+  constexpr size_t d = impl_par::line_split_dim<Axis, MOrderT2, ND>();
+  using no_idx_t = View_<size_t, ND, MOrderT0, IntT0>;
+  if (d == ND) { return impl_sort::topk<Axis>(vals, static_cast<no_idx_t*>(nullptr), x, cmp); }
+  impl_sort::check_shapes<Axis>(vals, x, "xmat::topk(): vals and x shapes mismatch");
+  impl_par::for_line_chunks(x.numel(), x.shape()[d], grain, pool, [&](size_t i0, size_t i1) {
+    auto v = impl_par::chunk(vals.ptr(), vals.ravel(), d, i0, i1);
+    impl_sort::topk<Axis>(v, static_cast<no_idx_t*>(nullptr), impl_par::chunk(x.ptr(), x.ravel(), d, i0, i1), cmp);
+  });
+}
+} // namespace par
+} // namespace xmat
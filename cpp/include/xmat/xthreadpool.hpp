@@ -0,0 +1,226 @@
+#pragma once
+
+// Work-stealing thread pool of the xmat::par:: algorithms and the chunking
+// of arrays between its threads; the algorithms live next to their serial
+// versions (xparallel.hpp, xlinalg.hpp, ...).
+
+#include <cstddef>
+#include <cassert>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "xutil.hpp"
+#include "xarray.hpp"
+
+
+namespace xmat {
+namespace par {
+
+// ------------------------------------------------------------
+// ThreadPool
+// ------------------------------------------------------------
+// Every thread has own task queue: it pops own tasks from the back,
+// and steals from other queues' front when own queue is empty.
+// Queue 0 is shared by external threads, which also run tasks while
+// they are waiting for a parallel_for().
+class ThreadPool {
+ public:
+  using task_t = std::function<void()>;
+  static constexpr size_t npos = size_t(-1);
+
+  // nthreads - total concurrency, including the calling thread
+  explicit ThreadPool(size_t nthreads = default_size()) {
+    nthreads = std::max(nthreads, size_t{1});
+    for (size_t n = 0; n < nthreads; ++n) { queues_.emplace_back(new Queue); }
+    for (size_t n = 1; n < nthreads; ++n) { threads_.emplace_back([this, n] { work(n); }); }
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for (auto& t : threads_) { t.join(); }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void submit(task_t task) {
+    size_t i = index();
+    if (i == npos) { i = next_.fetch_add(1, std::memory_order_relaxed) % queues_.size(); }
+    {
+      std::lock_guard<std::mutex> lock{queues_[i]->mutex};
+      queues_[i]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      ++pending_;
+    }
+    cv_.notify_one();
+  }
+
+  // runs one pending task if any
+  bool run_one() {
+    task_t task;
+    if (!pop(task)) { return false; }
+    task();
+    return true;
+  }
+
+  // calls f(c) for c in [0, n). the calling thread runs c = 0 itself
+  // and helps with the rest, returns when all of them are finished.
+  // the first exception is rethrown.
+  template<typename F>
+  void parallel_for(size_t n, F&& f) {
+    if (n == 0) { return; }
+    if (n == 1 || size() == 1) {
+      for (size_t c = 0; c < n; ++c) { f(c); }
+      return;
+    }
+
+    std::atomic<size_t> left{n - 1};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto guarded = [&](size_t c) {
+      try { f(c); }
+      catch (...) {
+        std::lock_guard<std::mutex> lock{error_mutex};
+        if (!error) { error = std::current_exception(); }
+      }
+    };
+
+    for (size_t c = 1; c < n; ++c) {
+      submit([&guarded, &left, c] {
+        guarded(c);
+        left.fetch_sub(1, std::memory_order_release);
+      });
+    }
+    guarded(0);
+    while (left.load(std::memory_order_acquire) != 0) {
+      if (!run_one()) { std::this_thread::yield(); }
+    }
+    if (error) { std::rethrow_exception(error); }
+  }
+
+  size_t size() const noexcept { return queues_.size(); }
+
+  static size_t default_size() noexcept {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }
+
+  // process-wide pool, created on first use
+  static ThreadPool& global() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<task_t> tasks;
+  };
+
+  struct Worker {
+    const ThreadPool* pool = nullptr;
+    size_t index = npos;
+  };
+
+  static Worker& worker() noexcept {
+    thread_local Worker w;
+    return w;
+  }
+
+  // own queue index of the current thread, npos for external threads
+  size_t index() const noexcept { return worker().pool == this ? worker().index : npos; }
+
+  bool pop(task_t& task) {
+    if (pending_.load(std::memory_order_acquire) == 0) { return false; }
+    const size_t i0 = index() == npos ? 0 : index();
+    for (size_t k = 0, N = queues_.size(); k < N; ++k) {
+      Queue& q = *queues_[(i0 + k) % N];
+      std::lock_guard<std::mutex> lock{q.mutex};
+      if (q.tasks.empty()) { continue; }
+      if (k == 0) {
+        task = std::move(q.tasks.back());
+        q.tasks.pop_back();
+      }
+      else {
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+      }
+      pending_.fetch_sub(1, std::memory_order_acq_rel);
+      return true;
+    }
+    return false;
+  }
+
+  void work(size_t n) {
+    worker() = {this, n};
+    for (;;) {
+      if (run_one()) { continue; }
+      std::unique_lock<std::mutex> lock{mutex_};
+      cv_.wait(lock, [this] { return stop_ || pending_.load(std::memory_order_acquire) > 0; });
+      if (stop_) { return; }
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::atomic<size_t> pending_{0};
+  std::atomic<size_t> next_{0};
+  bool stop_ = false;
+};
+
+
+// ------------------------------------------------------------
+// splitting arrays between threads
+// ------------------------------------------------------------
+// Arrays are split into chunks along one dim (the least data-local one
+// for element-wise algorithms), so every chunk is a View_ over a contiguous
+// slab for contiguous data. Chunks have at least `grain` elements: small
+// arrays run in the calling thread.
+constexpr size_t k_grain = 1 << 15;
+
+namespace impl_par {
+
+struct Plan {
+  size_t nchunk = 1;  // number of chunks
+  size_t rows = 0;    // rows of the split dim per chunk
+};
+
+inline Plan plan(size_t numel, size_t nrows, size_t grain, size_t nthreads) noexcept {
+  Plan p;
+  p.rows = nrows;
+  if (nrows == 0 || nthreads < 2) { return p; }
+  size_t n = std::min(numel / std::max(grain, size_t{1}), 4 * nthreads);
+  n = std::min(std::max(n, size_t{1}), nrows);
+  p.rows = (nrows + n - 1) / n;
+  p.nchunk = (nrows + p.rows - 1) / p.rows;
+  return p;
+}
+
+// rows [i0, i1) of dim `d`
+template<typename T, size_t ND, MOrder MOrderT, typename IntT>
+View_<T, ND, MOrderT, IntT> chunk(T* ptr, Ravel_<ND, MOrderT, IntT> ravel,
+                                  size_t d, size_t i0, size_t i1) noexcept {
+  ravel.shape[d] = i1 - i0;
+  return {ptr + i0 * ravel.stride[d], ravel};
+}
+} // namespace impl_par
+} // namespace par
+} // namespace xmat